@@ -0,0 +1,419 @@
+#include "FileManager.h"
+#include "TreeGenerator.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <optional>
+#include <memory>
+#include <locale>
+
+#ifdef OS_WINDOWS
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct BenchOptions {
+    std::vector<std::string> profiles;
+    std::optional<unsigned> depth;
+    std::optional<unsigned> fanout;
+    std::optional<unsigned> files;
+    std::optional<std::uint64_t> minSize;
+    std::optional<std::uint64_t> maxSize;
+    unsigned runs = 5;
+    unsigned catSamples = 32;
+    bool warm = true;
+    bool cold = false;
+    fs::path workDir;
+    std::string label;
+    std::string output;
+    bool keep = false;
+};
+
+struct Measurement {
+    std::vector<double> seconds;
+    std::uint64_t items = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+};
+
+class StdoutSilencer {
+private:
+    int saved;
+    
+public:
+    StdoutSilencer() {
+        tcout.flush();
+        std::fflush(stdout);
+#ifdef OS_WINDOWS
+        saved = _dup(1);
+        int null = _open("NUL", _O_WRONLY);
+        _dup2(null, 1);
+        _close(null);
+#else
+        saved = ::dup(1);
+        int null = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        ::dup2(null, 1);
+        ::close(null);
+#endif
+    }
+    
+    ~StdoutSilencer() {
+        tcout.flush();
+        std::fflush(stdout);
+#ifdef OS_WINDOWS
+        _dup2(saved, 1);
+        _close(saved);
+#else
+        ::dup2(saved, 1);
+        ::close(saved);
+#endif
+    }
+};
+
+std::string quote(const fs::path& path) {
+    return "\"" + path.string() + "\"";
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", c);
+            escaped += code;
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+double percentile(const std::vector<double>& sorted, double fraction) {
+    if (sorted.empty()) return 0;
+    std::size_t rank = static_cast<std::size_t>(fraction * static_cast<double>(sorted.size()) + 0.999999);
+    rank = std::min(std::max<std::size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+}
+
+std::string dropCaches(const fs::path& root) {
+#ifdef OS_LINUX
+    ::sync();
+    
+    std::error_code error;
+    for (fs::recursive_directory_iterator it(root, error), end; !error && it != end; it.increment(error)) {
+        if (!it->is_regular_file(error)) continue;
+        int fd = ::open(it->path().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) continue;
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    }
+    
+    std::ofstream drop("/proc/sys/vm/drop_caches");
+    if (drop && (drop << "3").flush()) {
+        return "drop_caches";
+    }
+    return "fadvise";
+#else
+    (void)root;
+    return "none";
+#endif
+}
+
+class Benchmark {
+private:
+    const BenchOptions& options;
+    std::ostream& out;
+    std::unique_ptr<FileManager> manager;
+    
+    bool timed(const std::string& command, Measurement& measurement) {
+        bool success;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point finished;
+        std::basic_ostringstream<tstring::value_type> errors;
+        {
+            StdoutSilencer silencer;
+            auto* saved = tcerr.rdbuf(errors.rdbuf());
+            started = std::chrono::steady_clock::now();
+            success = manager->execute(command);
+            finished = std::chrono::steady_clock::now();
+            tcerr.rdbuf(saved);
+        }
+        measurement.seconds.push_back(std::chrono::duration<double>(finished - started).count());
+        
+        tstring reported = errors.str();
+        if (!reported.empty()) {
+            tcerr << reported;
+            success = false;
+        }
+        if (!success) ++measurement.errors;
+        return success;
+    }
+    
+    void report(const TreeProfile& profile, const TreeStats& tree, const std::string& operation,
+                const std::string& cache, const std::string& coldMethod, Measurement& measurement) {
+        std::vector<double> sorted = measurement.seconds;
+        std::sort(sorted.begin(), sorted.end());
+        
+        double total = 0;
+        for (double value : sorted) total += value;
+        
+        double filesPerSecond = total > 0 ? static_cast<double>(measurement.items) / total : 0;
+        double megabytesPerSecond = total > 0 ? static_cast<double>(measurement.bytes) / 1e6 / total : 0;
+        double mean = sorted.empty() ? 0 : total / static_cast<double>(sorted.size());
+        
+        std::ostringstream line;
+        line.imbue(std::locale::classic());
+        line << "{\"label\":\"" << jsonEscape(options.label) << "\""
+             << ",\"profile\":\"" << jsonEscape(profile.name) << "\""
+             << ",\"operation\":\"" << operation << "\""
+             << ",\"cache\":\"" << cache << "\""
+             << ",\"cold_method\":\"" << coldMethod << "\""
+             << ",\"samples\":" << sorted.size()
+             << ",\"items\":" << measurement.items
+             << ",\"bytes\":" << measurement.bytes
+             << ",\"seconds\":" << total
+             << ",\"files_per_sec\":" << filesPerSecond
+             << ",\"mb_per_sec\":" << megabytesPerSecond
+             << ",\"latency_ms\":{"
+             << "\"min\":" << (sorted.empty() ? 0 : sorted.front() * 1000)
+             << ",\"p50\":" << percentile(sorted, 0.50) * 1000
+             << ",\"p90\":" << percentile(sorted, 0.90) * 1000
+             << ",\"p99\":" << percentile(sorted, 0.99) * 1000
+             << ",\"max\":" << (sorted.empty() ? 0 : sorted.back() * 1000)
+             << ",\"mean\":" << mean * 1000 << "}"
+             << ",\"errors\":" << measurement.errors
+             << ",\"tree\":{\"files\":" << tree.files
+             << ",\"directories\":" << tree.directories
+             << ",\"bytes\":" << tree.bytes << "}}";
+        out << line.str() << std::endl;
+    }
+    
+    void runCache(const TreeProfile& profile, const TreeStats& tree, const fs::path& root, const fs::path& copy, bool cold) {
+        std::string cache = cold ? "cold" : "warm";
+        std::string coldMethod = "none";
+        auto prepare = [&](const fs::path& path) {
+            if (!cold) return;
+            coldMethod = dropCaches(path);
+            manager = std::make_unique<FileManager>(loggerOptions(options));
+        };
+        
+        Measurement ls, find, cat, cp, rm;
+        
+        std::vector<fs::path> samples;
+        std::size_t step = std::max<std::size_t>(1, tree.filePaths.size() / std::max(1u, options.catSamples));
+        for (std::size_t i = 0; i < tree.filePaths.size() && samples.size() < options.catSamples; i += step) {
+            samples.push_back(tree.filePaths[i]);
+        }
+        
+        if (!cold) {
+            StdoutSilencer silencer;
+            manager->execute("find " + quote(root) + " \"*.dat\"");
+        }
+        
+        for (unsigned run = 0; run < options.runs; ++run) {
+            prepare(root);
+            timed("ls -l " + quote(root), ls);
+            ls.items += tree.topLevelEntries;
+            
+            prepare(root);
+            timed("find " + quote(root) + " \"*.dat\"", find);
+            find.items += tree.files + tree.directories;
+            
+            prepare(root);
+            for (const auto& file : samples) {
+                timed("cat " + quote(file), cat);
+                cat.items += 1;
+                cat.bytes += fs::file_size(file);
+            }
+            
+            prepare(root);
+            timed("cp " + quote(root) + " " + quote(copy), cp);
+            cp.items += tree.files;
+            cp.bytes += tree.bytes;
+            
+            prepare(copy);
+            timed("rm " + quote(copy), rm);
+            rm.items += tree.files + tree.directories;
+        }
+        
+        report(profile, tree, "ls", cache, coldMethod, ls);
+        report(profile, tree, "find", cache, coldMethod, find);
+        report(profile, tree, "cat", cache, coldMethod, cat);
+        report(profile, tree, "cp", cache, coldMethod, cp);
+        report(profile, tree, "rm", cache, coldMethod, rm);
+    }
+    
+    static LoggerOptions loggerOptions(const BenchOptions& options) {
+        LoggerOptions logger;
+        logger.path = (options.workDir / "bench.log").string();
+        logger.durability = LogDurability::Buffered;
+        return logger;
+    }
+    
+public:
+    Benchmark(const BenchOptions& options, std::ostream& out) : options(options), out(out), manager(std::make_unique<FileManager>(loggerOptions(options))) {}
+    
+    void runProfile(TreeProfile profile) {
+        if (options.depth) profile.depth = *options.depth;
+        if (options.fanout) profile.fanout = *options.fanout;
+        if (options.files) profile.filesPerDirectory = *options.files;
+        if (options.minSize) profile.minSize = *options.minSize;
+        if (options.maxSize) profile.maxSize = *options.maxSize;
+        
+        fs::path root = options.workDir / profile.name;
+        fs::path copy = options.workDir / (profile.name + "-copy");
+        fs::remove_all(root);
+        fs::remove_all(copy);
+        
+        std::cerr << "Генерация дерева " << profile.name << "..." << std::endl;
+        TreeGenerator generator(profile);
+        TreeStats tree = generator.generate(root);
+        std::cerr << "  файлов: " << tree.files << ", директорий: " << tree.directories
+                  << ", байт: " << tree.bytes << std::endl;
+        
+        if (options.warm) runCache(profile, tree, root, copy, false);
+        if (options.cold) runCache(profile, tree, root, copy, true);
+        
+        if (!options.keep) {
+            fs::remove_all(root);
+            fs::remove_all(copy);
+        }
+    }
+};
+
+std::uint64_t parseNumber(const std::string& value) {
+    std::size_t used = 0;
+    unsigned long long number = std::stoull(value, &used);
+    if (used != value.size()) {
+        throw std::invalid_argument("некорректное число: " + value);
+    }
+    return number;
+}
+
+bool parseArguments(int argc, char* argv[], BenchOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (arg == "--keep") {
+            options.keep = true;
+            continue;
+        }
+        
+        if (i + 1 >= argc) {
+            return false;
+        }
+        
+        std::string value = argv[++i];
+        
+        if (arg == "--profile") {
+            if (value == "all") {
+                options.profiles = TreeGenerator::profileNames();
+            } else {
+                options.profiles.push_back(value);
+            }
+        } else if (arg == "--depth") {
+            options.depth = static_cast<unsigned>(parseNumber(value));
+        } else if (arg == "--fanout") {
+            options.fanout = static_cast<unsigned>(parseNumber(value));
+        } else if (arg == "--files") {
+            options.files = static_cast<unsigned>(parseNumber(value));
+        } else if (arg == "--min-size") {
+            options.minSize = parseNumber(value);
+        } else if (arg == "--max-size") {
+            options.maxSize = parseNumber(value);
+        } else if (arg == "--runs") {
+            options.runs = static_cast<unsigned>(parseNumber(value));
+        } else if (arg == "--cat-samples") {
+            options.catSamples = static_cast<unsigned>(parseNumber(value));
+        } else if (arg == "--cache") {
+            options.warm = value == "warm" || value == "both";
+            options.cold = value == "cold" || value == "both";
+            if (!options.warm && !options.cold) return false;
+        } else if (arg == "--work-dir") {
+            options.workDir = value;
+        } else if (arg == "--label") {
+            options.label = value;
+        } else if (arg == "--output") {
+            options.output = value;
+        } else {
+            return false;
+        }
+    }
+    
+    if (options.profiles.empty()) {
+        options.profiles.push_back("small");
+    }
+    if (options.workDir.empty()) {
+        options.workDir = fs::temp_directory_path() / "simplefm-bench";
+    }
+    
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        BenchOptions options;
+        if (!parseArguments(argc, argv, options)) {
+            std::cerr << "Использование: FileManagerBench [--profile small|large|flat|all] [--depth N] [--fanout N] [--files N]\n"
+                         "                        [--min-size B] [--max-size B] [--runs N] [--cat-samples N]\n"
+                         "                        [--cache warm|cold|both] [--work-dir DIR] [--label TEXT] [--output FILE] [--keep]"
+                      << std::endl;
+            return 1;
+        }
+        
+#ifndef OS_WINDOWS
+        try {
+            std::locale::global(std::locale("en_US.UTF-8"));
+        } catch (const std::runtime_error&) {
+        }
+#endif
+        
+        fs::create_directories(options.workDir);
+        
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output, std::ios::app);
+            if (!file) {
+                std::cerr << "Не удалось открыть файл результатов: " << options.output << std::endl;
+                return 1;
+            }
+        }
+        std::ostream& out = options.output.empty() ? std::cout : file;
+        
+        {
+            Benchmark benchmark(options, out);
+            for (const auto& name : options.profiles) {
+                TreeProfile profile;
+                if (!TreeGenerator::profileByName(name, profile)) {
+                    std::cerr << "Неизвестный профиль: " << name << std::endl;
+                    return 1;
+                }
+                benchmark.runProfile(profile);
+            }
+        }
+        
+        if (!options.keep) {
+            std::error_code error;
+            fs::remove(options.workDir / "bench.log", error);
+            fs::remove(options.workDir, error);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Критическая ошибка: " << e.what() << std::endl;
+        return 1;
+    }
+    
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "TreeGenerator.h"
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+TreeGenerator::TreeGenerator(const TreeProfile& profile)
+    : profile(profile), state(profile.seed * 0x9E3779B97F4A7C15ULL + 1), block(1024 * 1024) {
+    for (auto& byte : block) {
+        byte = static_cast<char>(next() & 0xFF);
+    }
+}
+
+std::uint64_t TreeGenerator::next() {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+std::uint64_t TreeGenerator::pickSize() {
+    if (profile.maxSize <= profile.minSize) return profile.minSize;
+    
+    double low = std::log1p(static_cast<double>(profile.minSize));
+    double high = std::log1p(static_cast<double>(profile.maxSize));
+    double unit = static_cast<double>(next() >> 11) / static_cast<double>(1ULL << 53);
+    return static_cast<std::uint64_t>(std::expm1(low + (high - low) * unit));
+}
+
+void TreeGenerator::writeFile(const fs::path& path, std::uint64_t size) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("не удалось создать файл: " + path.string());
+    }
+    
+    std::uint64_t offset = next() % block.size();
+    while (size > 0) {
+        std::uint64_t chunk = std::min<std::uint64_t>(size, block.size() - offset);
+        out.write(block.data() + offset, static_cast<std::streamsize>(chunk));
+        size -= chunk;
+        offset = 0;
+    }
+}
+
+void TreeGenerator::generateLevel(const fs::path& dir, unsigned level) {
+    char name[32];
+    
+    for (unsigned i = 0; i < profile.filesPerDirectory; ++i) {
+        std::snprintf(name, sizeof(name), "f%06u.dat", i);
+        fs::path path = dir / name;
+        std::uint64_t size = pickSize();
+        writeFile(path, size);
+        
+        ++stats.files;
+        stats.bytes += size;
+        stats.filePaths.push_back(path);
+    }
+    
+    if (level >= profile.depth) return;
+    
+    for (unsigned i = 0; i < profile.fanout; ++i) {
+        std::snprintf(name, sizeof(name), "d%04u", i);
+        fs::path child = dir / name;
+        fs::create_directory(child);
+        ++stats.directories;
+        generateLevel(child, level + 1);
+    }
+}
+
+TreeStats TreeGenerator::generate(const fs::path& root) {
+    stats = TreeStats();
+    fs::create_directories(root);
+    generateLevel(root, 0);
+    stats.topLevelEntries = profile.filesPerDirectory + (profile.depth > 0 ? profile.fanout : 0);
+    return std::move(stats);
+}
+
+bool TreeGenerator::profileByName(const std::string& name, TreeProfile& profile) {
+    profile = TreeProfile();
+    profile.name = name;
+    
+    if (name == "small") {
+        profile.depth = 3;
+        profile.fanout = 6;
+        profile.filesPerDirectory = 40;
+        profile.minSize = 0;
+        profile.maxSize = 16 * 1024;
+    } else if (name == "large") {
+        profile.depth = 1;
+        profile.fanout = 2;
+        profile.filesPerDirectory = 4;
+        profile.minSize = 1024 * 1024;
+        profile.maxSize = 32 * 1024 * 1024;
+    } else if (name == "flat") {
+        profile.depth = 0;
+        profile.fanout = 0;
+        profile.filesPerDirectory = 100000;
+        profile.minSize = 0;
+        profile.maxSize = 256;
+    } else {
+        return false;
+    }
+    
+    return true;
+}
+
+std::vector<std::string> TreeGenerator::profileNames() {
+    return {"small", "large", "flat"};
+}
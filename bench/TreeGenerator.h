@@ -0,0 +1,50 @@
+#ifndef TREE_GENERATOR_H
+#define TREE_GENERATOR_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+struct TreeProfile {
+    std::string name;
+    unsigned depth = 3;
+    unsigned fanout = 6;
+    unsigned filesPerDirectory = 40;
+    std::uint64_t minSize = 0;
+    std::uint64_t maxSize = 16 * 1024;
+    std::uint32_t seed = 1;
+};
+
+struct TreeStats {
+    std::uint64_t files = 0;
+    std::uint64_t directories = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t topLevelEntries = 0;
+    std::vector<fs::path> filePaths;
+};
+
+class TreeGenerator {
+private:
+    const TreeProfile& profile;
+    std::uint64_t state;
+    std::vector<char> block;
+    TreeStats stats;
+    
+    std::uint64_t next();
+    std::uint64_t pickSize();
+    void writeFile(const fs::path& path, std::uint64_t size);
+    void generateLevel(const fs::path& dir, unsigned level);
+    
+public:
+    explicit TreeGenerator(const TreeProfile& profile);
+    
+    TreeStats generate(const fs::path& root);
+    
+    static bool profileByName(const std::string& name, TreeProfile& profile);
+    static std::vector<std::string> profileNames();
+};
+
+#endif
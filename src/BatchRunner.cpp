@@ -0,0 +1,356 @@
+#include "BatchRunner.h"
+#include "FileManager.h"
+#include "ThreadPool.h"
+#include <deque>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <streambuf>
+#include <exception>
+
+namespace {
+
+struct OutputCapture {
+    bool captureOut;
+    bool echoErr;
+    tstring out;
+    tstring err;
+};
+
+thread_local OutputCapture* activeCapture = nullptr;
+std::mutex passThroughMutex;
+
+class CaptureScope {
+private:
+    OutputCapture* previous;
+    
+public:
+    explicit CaptureScope(OutputCapture* capture) : previous(activeCapture) {
+        activeCapture = capture;
+    }
+    
+    ~CaptureScope() {
+        activeCapture = previous;
+    }
+};
+
+template <typename Char>
+class CaptureBuffer : public std::basic_streambuf<Char> {
+private:
+    using Traits = typename std::basic_streambuf<Char>::traits_type;
+    using IntType = typename Traits::int_type;
+    
+    std::basic_streambuf<Char>* target;
+    bool errorStream;
+    
+protected:
+    IntType overflow(IntType ch) override {
+        if (Traits::eq_int_type(ch, Traits::eof())) {
+            return Traits::not_eof(ch);
+        }
+        Char c = Traits::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : Traits::eof();
+    }
+    
+    std::streamsize xsputn(const Char* data, std::streamsize size) override {
+        OutputCapture* capture = activeCapture;
+        if (capture) {
+            if (errorStream) {
+                capture->err.append(data, static_cast<std::size_t>(size));
+                if (!capture->echoErr) return size;
+            } else if (capture->captureOut) {
+                capture->out.append(data, static_cast<std::size_t>(size));
+                return size;
+            }
+        }
+        std::lock_guard<std::mutex> lock(passThroughMutex);
+        return target->sputn(data, size);
+    }
+    
+    int sync() override {
+        OutputCapture* capture = activeCapture;
+        if (capture && (errorStream ? !capture->echoErr : capture->captureOut)) return 0;
+        std::lock_guard<std::mutex> lock(passThroughMutex);
+        return target->pubsync();
+    }
+    
+public:
+    CaptureBuffer(std::basic_streambuf<Char>* target, bool errorStream) : target(target), errorStream(errorStream) {}
+};
+
+using StreamBuffer = CaptureBuffer<tstring::value_type>;
+
+class StreamRedirect {
+private:
+    std::basic_ostream<tstring::value_type>& stream;
+    std::basic_streambuf<tstring::value_type>* original;
+    StreamBuffer buffer;
+    
+public:
+    StreamRedirect(std::basic_ostream<tstring::value_type>& stream, bool errorStream)
+        : stream(stream), original(stream.rdbuf()), buffer(original, errorStream) {
+        stream.flush();
+        stream.rdbuf(&buffer);
+    }
+    
+    ~StreamRedirect() {
+        stream.rdbuf(original);
+    }
+};
+
+struct Slot {
+    BatchStatus status;
+    tstring out;
+    tstring err;
+    bool done = false;
+};
+
+struct Job {
+    Slot* slot;
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+};
+
+bool overlaps(const std::string& a, const std::string& b) {
+    const std::string& shorter = a.size() <= b.size() ? a : b;
+    const std::string& longer = a.size() <= b.size() ? b : a;
+    if (longer.compare(0, shorter.size(), shorter) != 0) return false;
+    if (longer.size() == shorter.size()) return true;
+    char separator = static_cast<char>(fs::path::preferred_separator);
+    return longer[shorter.size()] == separator || shorter.back() == separator;
+}
+
+bool anyOverlap(const std::vector<std::string>& left, const std::vector<std::string>& right) {
+    for (const auto& a : left) {
+        for (const auto& b : right) {
+            if (overlaps(a, b)) return true;
+        }
+    }
+    return false;
+}
+
+bool conflicts(const Job& earlier, const Job& later) {
+    return anyOverlap(earlier.writes, later.writes) ||
+           anyOverlap(earlier.writes, later.reads) ||
+           anyOverlap(earlier.reads, later.writes);
+}
+
+std::string firstLine(const tstring& text) {
+    std::string line = toString(text.substr(0, text.find(tstring::value_type('\n'))));
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' ')) {
+        line.pop_back();
+    }
+    return line;
+}
+
+bool isBlank(const std::string& line) {
+    for (char c : line) {
+        if (c != ' ' && c != '\t') return c == '#';
+    }
+    return true;
+}
+
+}
+
+BatchRunner::BatchRunner(const BatchOptions& options, Parser parser, Executor executor, PathResolver resolver)
+    : options(options), parser(std::move(parser)), executor(std::move(executor)), resolver(std::move(resolver)) {}
+    
+bool BatchRunner::isParallel(const std::string& command) const {
+    return command == "cp" || command == "mv" || command == "rm" || command == "mkdir" || command == "sync" ||
+           command == "pack" || command == "unpack";
+}
+
+void BatchRunner::collectPaths(const std::vector<std::string>& args, std::vector<std::string>& reads, std::vector<std::string>& writes) const {
+    bool copy = args[0] == "cp" || args[0] == "sync" || args[0] == "pack" || args[0] == "unpack";
+    std::size_t position = 0;
+    
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        if (args[i] == "-j" || args[i] == "--queue-depth" || args[i] == "--block-size" || args[i] == "--format") {
+            ++i;
+            continue;
+        }
+        if (!args[i].empty() && args[i][0] == '-') continue;
+        
+        std::string path = resolver(args[i]).lexically_normal().string();
+        char separator = static_cast<char>(fs::path::preferred_separator);
+        while (path.size() > 1 && path.back() == separator) {
+            path.pop_back();
+        }
+        
+        if (copy && position == 0) {
+            reads.push_back(std::move(path));
+        } else {
+            writes.push_back(std::move(path));
+        }
+        ++position;
+    }
+}
+
+bool BatchRunner::run(std::istream& input) {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<Slot> slots;
+    std::vector<Job> inflight;
+    
+    ThreadPool pool(options.threads);
+    std::size_t window = options.window ? options.window : static_cast<std::size_t>(pool.size()) * 4;
+    
+    StreamRedirect outRedirect(tcout, false);
+    StreamRedirect errRedirect(tcerr, true);
+    
+    auto execute = [this](Slot& slot, const std::vector<std::string>& args, OutputCapture& capture) {
+        CaptureScope scope(&capture);
+        auto started = std::chrono::steady_clock::now();
+        std::string failure;
+        
+        try {
+            executor(args);
+        } catch (const std::exception& e) {
+            failure = e.what();
+            tcerr << toTString("Ошибка: ") << toTString(failure) << std::endl;
+        } catch (...) {
+            failure = "неизвестное исключение";
+            tcerr << toTString("Ошибка: ") << toTString(failure) << std::endl;
+        }
+        
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - started;
+        slot.status.milliseconds = elapsed.count();
+        if (!failure.empty()) {
+            slot.status.success = false;
+            slot.status.error = failure;
+        } else if (!capture.err.empty()) {
+            slot.status.success = false;
+            slot.status.error = firstLine(capture.err);
+        }
+    };
+    
+    auto flush = [&]() {
+        std::vector<Slot> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inflight.erase(std::remove_if(inflight.begin(), inflight.end(),
+                [](const Job& running) { return running.slot->done; }), inflight.end());
+            while (!slots.empty() && slots.front().done) {
+                ready.push_back(std::move(slots.front()));
+                slots.pop_front();
+            }
+        }
+        
+        for (auto& slot : ready) {
+            if (!slot.out.empty()) tcout << slot.out;
+            if (!slot.err.empty()) tcerr << slot.err;
+            statuses.push_back(std::move(slot.status));
+        }
+        if (!ready.empty()) tcout.flush();
+    };
+    
+    auto drain = [&]() {
+        pool.wait();
+        inflight.clear();
+        flush();
+    };
+    
+    std::string line;
+    std::size_t lineNumber = 0;
+    
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (isBlank(line)) continue;
+        
+        std::vector<std::string> args = parser(line);
+        if (args.empty()) continue;
+        
+        if (args[0] == "barrier") {
+            drain();
+            continue;
+        }
+        
+        if (args[0] == "exit") {
+            break;
+        }
+        
+        Slot* slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.emplace_back();
+            slot = &slots.back();
+        }
+        slot->status.line = lineNumber;
+        slot->status.command = line;
+        
+        if (!isParallel(args[0])) {
+            drain();
+            OutputCapture capture{false, true, tstring(), tstring()};
+            execute(*slot, args, capture);
+            tcout.flush();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot->done = true;
+            }
+            flush();
+            continue;
+        }
+        
+        Job job{slot, {}, {}};
+        collectPaths(args, job.reads, job.writes);
+        
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                inflight.erase(std::remove_if(inflight.begin(), inflight.end(),
+                    [](const Job& running) { return running.slot->done; }), inflight.end());
+                
+                bool blocked = inflight.size() >= window;
+                for (std::size_t i = 0; !blocked && i < inflight.size(); ++i) {
+                    blocked = conflicts(inflight[i], job);
+                }
+                if (!blocked) break;
+                
+                changed.wait(lock);
+            }
+            inflight.push_back(job);
+        }
+        
+        pool.submit([&, slot, args]() {
+            OutputCapture capture{true, false, tstring(), tstring()};
+            execute(*slot, args, capture);
+            
+            slot->out = std::move(capture.out);
+            slot->err = std::move(capture.err);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                slot->done = true;
+            }
+            changed.notify_all();
+        });
+        
+        flush();
+    }
+    
+    drain();
+    return failures() == 0;
+}
+
+const std::vector<BatchStatus>& BatchRunner::report() const {
+    return statuses;
+}
+
+std::size_t BatchRunner::failures() const {
+    std::size_t count = 0;
+    for (const auto& status : statuses) {
+        if (!status.success) ++count;
+    }
+    return count;
+}
+
+void BatchRunner::writeReport(std::ostream& out) const {
+    for (const auto& status : statuses) {
+        out << status.line << '\t'
+            << (status.success ? "ok" : "error") << '\t'
+            << status.milliseconds << '\t'
+            << status.command << '\t'
+            << status.error << '\n';
+    }
+}
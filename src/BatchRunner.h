@@ -0,0 +1,53 @@
+#ifndef BATCH_RUNNER_H
+#define BATCH_RUNNER_H
+
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <functional>
+#include <filesystem>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+struct BatchStatus {
+    std::size_t line = 0;
+    std::string command;
+    bool success = true;
+    std::string error;
+    double milliseconds = 0;
+};
+
+struct BatchOptions {
+    unsigned threads = 0;
+    std::size_t window = 0;
+};
+
+class BatchRunner {
+public:
+    using Parser = std::function<std::vector<std::string>(const std::string& line)>;
+    using Executor = std::function<void(const std::vector<std::string>& args)>;
+    using PathResolver = std::function<fs::path(const std::string& arg)>;
+    
+private:
+    BatchOptions options;
+    Parser parser;
+    Executor executor;
+    PathResolver resolver;
+    std::vector<BatchStatus> statuses;
+    
+    bool isParallel(const std::string& command) const;
+    void collectPaths(const std::vector<std::string>& args, std::vector<std::string>& reads, std::vector<std::string>& writes) const;
+    
+public:
+    BatchRunner(const BatchOptions& options, Parser parser, Executor executor, PathResolver resolver);
+    
+    bool run(std::istream& input);
+    
+    const std::vector<BatchStatus>& report() const;
+    std::size_t failures() const;
+    void writeReport(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,416 @@
+#include "ContentSearcher.h"
+#include "Metrics.h"
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#else
+#include <fstream>
+#include <iterator>
+#endif
+
+namespace {
+
+std::bitset<256> symbolSet(unsigned char c) {
+    std::bitset<256> set;
+    set.set(c);
+    return set;
+}
+
+std::bitset<256> escapeSet(char c) {
+    std::bitset<256> set;
+    switch (c) {
+        case 'd':
+            for (int i = '0'; i <= '9'; ++i) set.set(i);
+            return set;
+        case 'w':
+            for (int i = 'a'; i <= 'z'; ++i) set.set(i);
+            for (int i = 'A'; i <= 'Z'; ++i) set.set(i);
+            for (int i = '0'; i <= '9'; ++i) set.set(i);
+            set.set('_');
+            return set;
+        case 's':
+            set.set(' ');
+            set.set('\t');
+            set.set('\r');
+            set.set('\v');
+            set.set('\f');
+            return set;
+        default:
+            return symbolSet(static_cast<unsigned char>(c));
+    }
+}
+
+std::bitset<256> parseClass(const std::string& pattern, std::size_t& i) {
+    std::bitset<256> set;
+    bool negated = false;
+    
+    if (i < pattern.size() && pattern[i] == '^') {
+        negated = true;
+        ++i;
+    }
+    
+    bool first = true;
+    while (i < pattern.size() && (first || pattern[i] != ']')) {
+        first = false;
+        
+        if (pattern[i] == '\\' && i + 1 < pattern.size()) {
+            set |= escapeSet(pattern[i + 1]);
+            i += 2;
+            continue;
+        }
+        
+        unsigned char low = static_cast<unsigned char>(pattern[i]);
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            unsigned char high = static_cast<unsigned char>(pattern[i + 2]);
+            if (high < low) {
+                throw std::invalid_argument("некорректный диапазон в выражении: " + pattern);
+            }
+            for (unsigned c = low; c <= high; ++c) set.set(c);
+            i += 3;
+        } else {
+            set.set(low);
+            ++i;
+        }
+    }
+    
+    if (i >= pattern.size()) {
+        throw std::invalid_argument("незакрытая скобка в выражении: " + pattern);
+    }
+    ++i;
+    
+    if (negated) {
+        set.flip();
+        set.reset('\n');
+    }
+    return set;
+}
+
+}
+
+LinePattern::LinePattern(const std::string& pattern) : anchoredStart(false), anchoredEnd(false), literal(false) {
+    std::size_t i = 0;
+    if (i < pattern.size() && pattern[i] == '^') {
+        anchoredStart = true;
+        ++i;
+    }
+    
+    while (i < pattern.size()) {
+        char c = pattern[i];
+        
+        if (c == '$' && i + 1 == pattern.size()) {
+            anchoredEnd = true;
+            ++i;
+        } else if (c == '*' || c == '+' || c == '?') {
+            if (tokens.empty() || tokens.back().quantifier != Quantifier::One) {
+                throw std::invalid_argument("квантификатор без операнда в выражении: " + pattern);
+            }
+            tokens.back().quantifier = c == '*' ? Quantifier::Star : (c == '+' ? Quantifier::Plus : Quantifier::Optional);
+            ++i;
+        } else if (c == '.') {
+            std::bitset<256> any;
+            any.set();
+            any.reset('\n');
+            tokens.push_back({any, Quantifier::One, -1});
+            ++i;
+        } else if (c == '[') {
+            ++i;
+            tokens.push_back({parseClass(pattern, i), Quantifier::One, -1});
+        } else if (c == '\\') {
+            if (i + 1 >= pattern.size()) {
+                throw std::invalid_argument("незавершенное экранирование в выражении: " + pattern);
+            }
+            char next = pattern[i + 1];
+            bool symbol = next != 'd' && next != 'w' && next != 's';
+            tokens.push_back({escapeSet(next), Quantifier::One, symbol ? static_cast<unsigned char>(next) : -1});
+            i += 2;
+        } else {
+            tokens.push_back({symbolSet(static_cast<unsigned char>(c)), Quantifier::One, static_cast<unsigned char>(c)});
+            ++i;
+        }
+    }
+    
+    std::string run;
+    for (const auto& token : tokens) {
+        if (token.symbol >= 0 && token.quantifier == Quantifier::One) {
+            run += static_cast<char>(token.symbol);
+        } else {
+            run.clear();
+        }
+        if (run.size() > required.size()) required = run;
+    }
+    
+    literal = !anchoredStart && !anchoredEnd && !tokens.empty() && required.size() == tokens.size();
+}
+
+const std::string& LinePattern::requiredLiteral() const {
+    return required;
+}
+
+bool LinePattern::isLiteral() const {
+    return literal;
+}
+
+bool LinePattern::matchesLine(const char* begin, const char* end) const {
+    thread_local std::vector<std::size_t> current;
+    thread_local std::vector<std::size_t> next;
+    thread_local std::vector<std::uint64_t> marks;
+    thread_local std::uint64_t generation = 0;
+    
+    const std::size_t accept = tokens.size();
+    if (marks.size() <= accept) marks.resize(accept + 1, 0);
+    
+    auto add = [&](std::vector<std::size_t>& states, std::size_t state) {
+        for (; marks[state] != generation; ++state) {
+            marks[state] = generation;
+            states.push_back(state);
+            if (state == accept) return true;
+            if (tokens[state].quantifier != Quantifier::Optional && tokens[state].quantifier != Quantifier::Star) break;
+        }
+        return false;
+    };
+    
+    ++generation;
+    current.clear();
+    bool accepting = add(current, 0);
+    
+    for (const char* position = begin;; ++position) {
+        if (accepting && (!anchoredEnd || position == end)) return true;
+        if (position == end || current.empty()) return false;
+        
+        unsigned char c = static_cast<unsigned char>(*position);
+        ++generation;
+        next.clear();
+        accepting = false;
+        
+        for (std::size_t state : current) {
+            if (state == accept || !tokens[state].accepts.test(c)) continue;
+            if (tokens[state].quantifier == Quantifier::Star || tokens[state].quantifier == Quantifier::Plus) {
+                accepting = add(next, state) || accepting;
+            }
+            accepting = add(next, state + 1) || accepting;
+        }
+        if (!anchoredStart) accepting = add(next, 0) || accepting;
+        current.swap(next);
+    }
+}
+
+const char* LinePattern::findLiteral(const char* begin, const char* end, const std::string& needle) {
+    std::size_t length = needle.size();
+    std::size_t size = static_cast<std::size_t>(end - begin);
+    if (length == 0) return begin;
+    if (size < length) return nullptr;
+    if (length == 1) return static_cast<const char*>(std::memchr(begin, needle[0], size));
+    
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[length - 1]);
+    
+    for (; i + length - 1 + 16 <= size; i += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + i));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last))));
+        
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(begin + i + bit + 1, needle.data() + 1, length - 2) == 0) {
+                return begin + i + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    while (i + length <= size) {
+        const char* candidate = static_cast<const char*>(std::memchr(begin + i, needle[0], size - length + 1 - i));
+        if (!candidate) return nullptr;
+        if (std::memcmp(candidate + 1, needle.data() + 1, length - 1) == 0) return candidate;
+        i = static_cast<std::size_t>(candidate - begin) + 1;
+    }
+    return nullptr;
+}
+
+ContentSearcher::ContentSearcher(const std::string& pattern, const SearchOptions& options)
+    : pattern(pattern), options(options), pool(options.threads),
+      files(0), matchedFiles(0), matches(0), binarySkipped(0), bytes(0), errors(0) {}
+
+void ContentSearcher::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        firstErrorPath = path;
+        firstError = error;
+    }
+}
+
+std::uint64_t ContentSearcher::searchBuffer(const std::string& path, const char* data, std::size_t size) {
+    const std::string& needle = pattern.requiredLiteral();
+    const char* end = data + size;
+    const char* position = data;
+    const char* counted = data;
+    std::uint64_t line = 1;
+    std::uint64_t found = 0;
+    
+    std::string out;
+    std::vector<std::pair<std::uint64_t, std::string_view>> pending;
+    
+    auto deliver = [&]() {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        if (options.onMatch) {
+            for (const auto& match : pending) options.onMatch(path, match.first, match.second);
+        } else {
+            options.output(out.data(), out.size());
+        }
+        pending.clear();
+        out.clear();
+    };
+    
+    while (position < end) {
+        const char* lineStart = position;
+        const char* scanFrom = position;
+        
+        if (!needle.empty()) {
+            const char* hit = LinePattern::findLiteral(position, end, needle);
+            if (!hit) break;
+            
+            lineStart = hit;
+            while (lineStart > position && lineStart[-1] != '\n') --lineStart;
+            scanFrom = hit;
+        }
+        
+        const char* lineEnd = static_cast<const char*>(std::memchr(scanFrom, '\n', static_cast<std::size_t>(end - scanFrom)));
+        if (!lineEnd) lineEnd = end;
+        
+        const char* textEnd = lineEnd;
+        if (textEnd > lineStart && textEnd[-1] == '\r') --textEnd;
+        
+        if (pattern.isLiteral() || pattern.matchesLine(lineStart, textEnd)) {
+            line += static_cast<std::uint64_t>(std::count(counted, lineStart, '\n'));
+            counted = lineStart;
+            ++found;
+            
+            if (options.onMatch) {
+                pending.emplace_back(line, std::string_view(lineStart, static_cast<std::size_t>(textEnd - lineStart)));
+            } else {
+                out += path;
+                out += ':';
+                out += std::to_string(line);
+                out += ':';
+                out.append(lineStart, textEnd);
+                out += '\n';
+                if (out.size() >= options.flushBytes) deliver();
+            }
+        }
+        
+        if (lineEnd == end) break;
+        position = lineEnd + 1;
+    }
+    
+    if (!out.empty() || !pending.empty()) deliver();
+    
+    return found;
+}
+
+void ContentSearcher::searchFile(const std::string& path) {
+    const char* data = nullptr;
+    std::size_t size = 0;
+
+#ifdef OS_LINUX
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        return;
+    }
+    
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        ::close(fd);
+        return;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        ::close(fd);
+        return;
+    }
+    
+    size = static_cast<std::size_t>(info.st_size);
+    void* mapping = nullptr;
+    if (size > 0) {
+        mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED) {
+            fail(path, std::error_code(errno, std::generic_category()));
+            ::close(fd);
+            return;
+        }
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char*>(mapping);
+    }
+    ::close(fd);
+#else
+    std::error_code error;
+    if (!fs::is_regular_file(fs::path(path), error)) return;
+    
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        fail(path, std::make_error_code(std::errc::permission_denied));
+        return;
+    }
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    data = content.data();
+    size = content.size();
+#endif
+
+    files.fetch_add(1, std::memory_order_relaxed);
+    bytes.fetch_add(size, std::memory_order_relaxed);
+    Metrics::add(MetricCounter::BytesRead, size);
+    
+    if (size > 0) {
+        if (std::memchr(data, '\0', std::min(size, options.binaryProbe))) {
+            binarySkipped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            std::uint64_t found = searchBuffer(path, data, size);
+            if (found > 0) {
+                matches.fetch_add(found, std::memory_order_relaxed);
+                matchedFiles.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+#ifdef OS_LINUX
+    if (size > 0) ::munmap(const_cast<char*>(data), size);
+#endif
+}
+
+void ContentSearcher::submit(std::string path) {
+    pool.submit([this, path = std::move(path)]() { searchFile(path); });
+}
+
+SearchSummary ContentSearcher::finish() {
+    pool.wait();
+    
+    SearchSummary summary;
+    summary.files = files.load();
+    summary.matchedFiles = matchedFiles.load();
+    summary.matches = matches.load();
+    summary.binarySkipped = binarySkipped.load();
+    summary.bytes = bytes.load();
+    summary.errors = errors.load();
+    
+    std::lock_guard<std::mutex> lock(errorMutex);
+    summary.firstErrorPath = firstErrorPath;
+    summary.firstError = firstError;
+    return summary;
+}
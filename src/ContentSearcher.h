@@ -0,0 +1,96 @@
+#ifndef CONTENT_SEARCHER_H
+#define CONTENT_SEARCHER_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <bitset>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+class LinePattern {
+private:
+    enum class Quantifier {
+        One,
+        Optional,
+        Star,
+        Plus
+    };
+    
+    struct Token {
+        std::bitset<256> accepts;
+        Quantifier quantifier;
+        int symbol;
+    };
+    
+    std::vector<Token> tokens;
+    std::string required;
+    bool anchoredStart;
+    bool anchoredEnd;
+    bool literal;
+    
+public:
+    explicit LinePattern(const std::string& pattern);
+    
+    const std::string& requiredLiteral() const;
+    bool isLiteral() const;
+    bool matchesLine(const char* begin, const char* end) const;
+    
+    static const char* findLiteral(const char* begin, const char* end, const std::string& needle);
+};
+
+struct SearchOptions {
+    unsigned threads = 0;
+    std::size_t flushBytes = 1 << 20;
+    std::size_t binaryProbe = 8192;
+    std::function<void(const char* data, std::size_t size)> output;
+    std::function<void(const std::string& path, std::uint64_t line, std::string_view text)> onMatch;
+};
+
+struct SearchSummary {
+    std::uint64_t files = 0;
+    std::uint64_t matchedFiles = 0;
+    std::uint64_t matches = 0;
+    std::uint64_t binarySkipped = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class ContentSearcher {
+private:
+    LinePattern pattern;
+    SearchOptions options;
+    ThreadPool pool;
+    std::mutex outputMutex;
+    
+    std::atomic<std::uint64_t> files;
+    std::atomic<std::uint64_t> matchedFiles;
+    std::atomic<std::uint64_t> matches;
+    std::atomic<std::uint64_t> binarySkipped;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    std::string firstErrorPath;
+    std::error_code firstError;
+    
+    void searchFile(const std::string& path);
+    std::uint64_t searchBuffer(const std::string& path, const char* data, std::size_t size);
+    void fail(const std::string& path, const std::error_code& error);
+    
+public:
+    ContentSearcher(const std::string& pattern, const SearchOptions& options);
+    
+    void submit(std::string path);
+    SearchSummary finish();
+};
+
+#endif
@@ -0,0 +1,372 @@
+#include "DirectoryCache.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef OS_LINUX
+#include <unistd.h>
+#include <cerrno>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+#ifdef OS_LINUX
+const std::uint32_t watchMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_MODIFY | IN_ATTRIB |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_EXCL_UNLINK;
+#endif
+
+const std::size_t nodeOverhead = 64;
+const std::size_t watchLimit = 8192;
+
+}
+
+DirectoryCache::DirectoryCache(std::size_t memoryLimit)
+    : head(none), tail(none), inotifyFd(-1), nextGeneration(1), memoryUsage(0), memoryLimit(memoryLimit) {
+#ifdef OS_LINUX
+    inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0) eventBuffer.resize(64 * 1024);
+#endif
+}
+
+DirectoryCache::~DirectoryCache() {
+#ifdef OS_LINUX
+    if (inotifyFd >= 0) ::close(inotifyFd);
+#endif
+}
+
+void DirectoryCache::unlink(std::uint32_t id) {
+    Slot& slot = slots[id];
+    if (slot.prev != none) slots[slot.prev].next = slot.next; else head = slot.next;
+    if (slot.next != none) slots[slot.next].prev = slot.prev; else tail = slot.prev;
+    slot.prev = slot.next = none;
+}
+
+void DirectoryCache::touch(std::uint32_t id) {
+    if (head == id) return;
+    if (slots[id].prev != none) unlink(id);
+    slots[id].next = head;
+    if (head != none) slots[head].prev = id;
+    head = id;
+    if (tail == none) tail = id;
+}
+
+void DirectoryCache::account(Slot& slot) {
+    std::size_t bytes = sizeof(Slot) + nodeOverhead + slot.path.capacity() + slot.names.capacity() +
+                        slot.records.capacity() * sizeof(ListRecord);
+    memoryUsage = memoryUsage + bytes - slot.bytes;
+    slot.bytes = bytes;
+}
+
+std::uint32_t DirectoryCache::acquireSlot(const std::string& directory) {
+#ifdef OS_LINUX
+    while (watchSlots.size() >= watchLimit && tail != none) {
+        releaseSlot(tail);
+        ++counters.evictions;
+    }
+    
+    int watch = ::inotify_add_watch(inotifyFd, directory.c_str(), watchMask);
+    if (watch < 0 && errno == ENOSPC && tail != none) {
+        releaseSlot(tail);
+        ++counters.evictions;
+        watch = ::inotify_add_watch(inotifyFd, directory.c_str(), watchMask);
+    }
+    if (watch < 0 || watchSlots.count(watch)) return none;
+    
+    struct stat info;
+    if (::stat(directory.c_str(), &info) != 0) {
+        ::inotify_rm_watch(inotifyFd, watch);
+        return none;
+    }
+    
+    std::uint32_t id;
+    if (freeSlots.empty()) {
+        id = static_cast<std::uint32_t>(slots.size());
+        slots.emplace_back();
+    } else {
+        id = freeSlots.back();
+        freeSlots.pop_back();
+    }
+    
+    Slot& slot = slots[id];
+    slot.path = directory;
+    slot.watch = watch;
+    slot.device = info.st_dev;
+    slot.inode = info.st_ino;
+    slot.generation = nextGeneration++;
+    slotIds[directory] = id;
+    watchSlots[watch] = id;
+    touch(id);
+    account(slot);
+    return id;
+#else
+    (void)directory;
+    return none;
+#endif
+}
+
+bool DirectoryCache::resolvesTo(const Slot& slot, const std::string& directory) const {
+#ifdef OS_LINUX
+    struct stat info;
+    return ::stat(directory.c_str(), &info) == 0 && static_cast<std::uint64_t>(info.st_dev) == slot.device &&
+           static_cast<std::uint64_t>(info.st_ino) == slot.inode;
+#else
+    (void)slot;
+    (void)directory;
+    return false;
+#endif
+}
+
+void DirectoryCache::releaseSlot(std::uint32_t id) {
+    unlink(id);
+    Slot& slot = slots[id];
+#ifdef OS_LINUX
+    if (slot.watch >= 0) {
+        ::inotify_rm_watch(inotifyFd, slot.watch);
+        watchSlots.erase(slot.watch);
+    }
+#endif
+    slotIds.erase(slot.path);
+    memoryUsage -= slot.bytes;
+    slot = Slot();
+    freeSlots.push_back(id);
+}
+
+void DirectoryCache::dropListing(Slot& slot) {
+    slot.generation = nextGeneration++;
+    if (!slot.filled) return;
+    
+    std::string().swap(slot.names);
+    std::vector<ListRecord>().swap(slot.records);
+    slot.deadNameBytes = 0;
+    slot.filled = false;
+    ++counters.invalidations;
+    account(slot);
+}
+
+ListRecord* DirectoryCache::findRecord(Slot& slot, std::string_view name) {
+    auto found = std::lower_bound(slot.records.begin(), slot.records.end(), name,
+        [&slot](const ListRecord& record, std::string_view key) {
+            return std::string_view(slot.names.data() + record.nameOffset, record.nameLength) < key;
+        });
+    if (found == slot.records.end() ||
+        std::string_view(slot.names.data() + found->nameOffset, found->nameLength) != name) {
+        return nullptr;
+    }
+    return &*found;
+}
+
+void DirectoryCache::insertRecord(Slot& slot, std::string_view name, bool isDirectory) {
+    if (ListRecord* existing = findRecord(slot, name)) {
+        existing->known = false;
+        if (isDirectory) {
+            existing->type = static_cast<std::uint8_t>(EntryType::Directory);
+            existing->targetType = existing->type;
+        }
+        return;
+    }
+    
+    ListRecord record{};
+    record.nameOffset = slot.names.size();
+    record.nameLength = static_cast<std::uint16_t>(name.size());
+    record.type = static_cast<std::uint8_t>(isDirectory ? EntryType::Directory : EntryType::Unknown);
+    record.targetType = record.type;
+    slot.names.append(name.data(), name.size());
+    
+    auto position = std::lower_bound(slot.records.begin(), slot.records.end(), name,
+        [&slot](const ListRecord& entry, std::string_view key) {
+            return std::string_view(slot.names.data() + entry.nameOffset, entry.nameLength) < key;
+        });
+    slot.records.insert(position, record);
+}
+
+void DirectoryCache::removeRecord(Slot& slot, std::string_view name) {
+    ListRecord* record = findRecord(slot, name);
+    if (!record) return;
+    
+    slot.deadNameBytes += record->nameLength;
+    slot.records.erase(slot.records.begin() + (record - slot.records.data()));
+    
+    if (slot.deadNameBytes > slot.names.size() / 2) {
+        std::string names;
+        names.reserve(slot.names.size() - slot.deadNameBytes);
+        for (auto& entry : slot.records) {
+            std::uint64_t offset = names.size();
+            names.append(slot.names, entry.nameOffset, entry.nameLength);
+            entry.nameOffset = offset;
+        }
+        slot.names.swap(names);
+        slot.deadNameBytes = 0;
+    }
+}
+
+void DirectoryCache::applyEvent(std::uint32_t id, std::uint32_t mask, std::string_view name) {
+#ifdef OS_LINUX
+    Slot& slot = slots[id];
+    
+    if (mask & (IN_DELETE_SELF | IN_MOVE_SELF)) {
+        if (slot.filled) ++counters.invalidations;
+        releaseSlot(id);
+        return;
+    }
+    
+    slot.generation = nextGeneration++;
+    if (!slot.filled || name.empty()) return;
+    
+    if (mask & (IN_CREATE | IN_MOVED_TO)) {
+        insertRecord(slot, name, (mask & IN_ISDIR) != 0);
+    } else if (mask & (IN_DELETE | IN_MOVED_FROM)) {
+        removeRecord(slot, name);
+    } else if (ListRecord* record = findRecord(slot, name)) {
+        record->known = false;
+    }
+    ++counters.entryUpdates;
+    account(slot);
+#else
+    (void)id;
+    (void)mask;
+    (void)name;
+#endif
+}
+
+void DirectoryCache::drainEvents() {
+#ifdef OS_LINUX
+    if (inotifyFd < 0) return;
+    
+    while (true) {
+        ssize_t bytes = ::read(inotifyFd, eventBuffer.data(), eventBuffer.size());
+        if (bytes <= 0) {
+            if (bytes < 0 && errno == EINTR) continue;
+            return;
+        }
+        
+        for (ssize_t offset = 0; offset < bytes;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(eventBuffer.data() + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+            
+            if (event->mask & IN_Q_OVERFLOW) {
+                for (std::uint32_t id = head; id != none; id = slots[id].next) {
+                    dropListing(slots[id]);
+                }
+                continue;
+            }
+            
+            auto found = watchSlots.find(event->wd);
+            if (found == watchSlots.end()) continue;
+            
+            if (event->mask & IN_IGNORED) {
+                std::uint32_t id = found->second;
+                watchSlots.erase(found);
+                slots[id].watch = -1;
+                if (slots[id].filled) ++counters.invalidations;
+                releaseSlot(id);
+                continue;
+            }
+            
+            std::string_view name(event->name, event->len ? ::strnlen(event->name, event->len) : 0);
+            applyEvent(found->second, event->mask, name);
+        }
+    }
+#endif
+}
+
+void DirectoryCache::evict() {
+    while (memoryUsage > memoryLimit && tail != none) {
+        releaseSlot(tail);
+        ++counters.evictions;
+    }
+}
+
+bool DirectoryCache::lookup(const std::string& directory, std::string& names, std::vector<ListRecord>& records, std::uint64_t& token,
+                            bool admit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    drainEvents();
+    token = 0;
+    
+    auto found = slotIds.find(directory);
+    if (found != slotIds.end() && !resolvesTo(slots[found->second], directory)) {
+        if (slots[found->second].filled) ++counters.invalidations;
+        releaseSlot(found->second);
+        found = slotIds.end();
+    }
+    
+    if (found != slotIds.end() && slots[found->second].filled) {
+        const Slot& slot = slots[found->second];
+        names = slot.names;
+        records = slot.records;
+        token = slot.generation;
+        touch(found->second);
+        ++counters.hits;
+        return true;
+    }
+    
+    ++counters.misses;
+    if (inotifyFd < 0 || memoryLimit == 0) return false;
+    
+    std::uint32_t id = found != slotIds.end() ? found->second : admit ? acquireSlot(directory) : none;
+    if (id != none) token = slots[id].generation;
+    return false;
+}
+
+void DirectoryCache::store(const std::string& directory, std::uint64_t token, const std::string& names, const std::vector<ListRecord>& records) {
+    if (token == 0) return;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    drainEvents();
+    
+    auto found = slotIds.find(directory);
+    if (found == slotIds.end() || slots[found->second].generation != token) return;
+    
+    Slot& slot = slots[found->second];
+    slot.records = records;
+    std::sort(slot.records.begin(), slot.records.end(), [&names](const ListRecord& a, const ListRecord& b) {
+        return std::string_view(names.data() + a.nameOffset, a.nameLength) <
+               std::string_view(names.data() + b.nameOffset, b.nameLength);
+    });
+    
+    slot.names.clear();
+    slot.names.reserve(names.size());
+    for (auto& record : slot.records) {
+        std::uint64_t offset = slot.names.size();
+        slot.names.append(names, record.nameOffset, record.nameLength);
+        record.nameOffset = offset;
+        if (static_cast<EntryType>(record.targetType) == EntryType::Directory) record.known = false;
+    }
+    slot.names.shrink_to_fit();
+    slot.records.shrink_to_fit();
+    slot.deadNameBytes = 0;
+    slot.filled = true;
+    
+    account(slot);
+    touch(found->second);
+    evict();
+}
+
+void DirectoryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (tail != none) {
+        releaseSlot(tail);
+    }
+}
+
+void DirectoryCache::setMemoryLimit(std::size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    memoryLimit = limit;
+    evict();
+}
+
+CacheStats DirectoryCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    CacheStats result = counters;
+    for (std::uint32_t id = head; id != none; id = slots[id].next) {
+        if (!slots[id].filled) continue;
+        ++result.directories;
+        result.entries += slots[id].records.size();
+    }
+    result.memoryUsage = memoryUsage;
+    result.memoryLimit = memoryLimit;
+    result.watches = watchSlots.size();
+    result.watchLimit = watchLimit;
+    result.watching = inotifyFd >= 0;
+    return result;
+}
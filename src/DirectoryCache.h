@@ -0,0 +1,90 @@
+#ifndef DIRECTORY_CACHE_H
+#define DIRECTORY_CACHE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <cstdint>
+#include "DirectoryLister.h"
+
+struct CacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t invalidations = 0;
+    std::uint64_t entryUpdates = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t directories = 0;
+    std::uint64_t entries = 0;
+    std::size_t memoryUsage = 0;
+    std::size_t memoryLimit = 0;
+    std::size_t watches = 0;
+    std::size_t watchLimit = 0;
+    bool watching = false;
+};
+
+class DirectoryCache {
+private:
+    static constexpr std::uint32_t none = UINT32_MAX;
+    
+    struct Slot {
+        std::string path;
+        std::string names;
+        std::vector<ListRecord> records;
+        std::size_t deadNameBytes = 0;
+        std::size_t bytes = 0;
+        std::uint64_t generation = 0;
+        std::uint64_t device = 0;
+        std::uint64_t inode = 0;
+        int watch = -1;
+        bool filled = false;
+        std::uint32_t prev = none;
+        std::uint32_t next = none;
+    };
+    
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::vector<std::uint32_t> freeSlots;
+    std::unordered_map<std::string, std::uint32_t> slotIds;
+    std::unordered_map<int, std::uint32_t> watchSlots;
+    std::uint32_t head;
+    std::uint32_t tail;
+    
+    int inotifyFd;
+    std::vector<char> eventBuffer;
+    std::uint64_t nextGeneration;
+    std::size_t memoryUsage;
+    std::size_t memoryLimit;
+    CacheStats counters;
+    
+    void drainEvents();
+    void applyEvent(std::uint32_t id, std::uint32_t mask, std::string_view name);
+    std::uint32_t acquireSlot(const std::string& directory);
+    void releaseSlot(std::uint32_t id);
+    bool resolvesTo(const Slot& slot, const std::string& directory) const;
+    void dropListing(Slot& slot);
+    void removeRecord(Slot& slot, std::string_view name);
+    void insertRecord(Slot& slot, std::string_view name, bool isDirectory);
+    ListRecord* findRecord(Slot& slot, std::string_view name);
+    void account(Slot& slot);
+    void touch(std::uint32_t id);
+    void unlink(std::uint32_t id);
+    void evict();
+    
+public:
+    explicit DirectoryCache(std::size_t memoryLimit = 64 * 1024 * 1024);
+    ~DirectoryCache();
+    
+    DirectoryCache(const DirectoryCache&) = delete;
+    DirectoryCache& operator=(const DirectoryCache&) = delete;
+    
+    bool lookup(const std::string& directory, std::string& names, std::vector<ListRecord>& records, std::uint64_t& token,
+                bool admit = true);
+    void store(const std::string& directory, std::uint64_t token, const std::string& names, const std::vector<ListRecord>& records);
+    void clear();
+    void setMemoryLimit(std::size_t limit);
+    CacheStats stats() const;
+};
+
+#endif
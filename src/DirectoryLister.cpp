@@ -0,0 +1,316 @@
+#include "DirectoryLister.h"
+#include "DirectoryCache.h"
+#include "ThreadPool.h"
+#include "LinuxDirectory.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <system_error>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const std::size_t outputChunk = 1 << 20;
+const std::size_t parallelStatThreshold = 4096;
+
+void pad(std::string& output, std::size_t rowStart, std::size_t column) {
+    std::size_t length = output.size() - rowStart;
+    if (length < column) output.append(column - length, ' ');
+}
+
+void appendNumber(std::string& output, std::uint64_t value, std::size_t width) {
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    do {
+        *--p = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    
+    std::size_t length = static_cast<std::size_t>(end - p);
+    if (length < width) output.append(width - length, ' ');
+    output.append(p, length);
+}
+
+void appendMode(std::string& output, std::uint16_t mode, EntryType type) {
+    char text[10];
+    text[0] = type == EntryType::Directory ? 'd' : type == EntryType::Symlink ? 'l' : type == EntryType::File ? '-' : '?';
+    const char* flags = "rwxrwxrwx";
+    for (int i = 0; i < 9; ++i) {
+        text[i + 1] = (mode & (0400 >> i)) ? flags[i] : '-';
+    }
+    output.append(text, sizeof(text));
+}
+
+}
+
+DirectoryLister::DirectoryLister(const fs::path& directory, const ListOptions& options)
+    : directory(directory), options(options) {}
+    
+bool DirectoryLister::parseSort(const std::string& name, ListSort& sort) {
+    if (name == "none") {
+        sort = ListSort::None;
+    } else if (name == "name") {
+        sort = ListSort::Name;
+    } else if (name == "size") {
+        sort = ListSort::Size;
+    } else if (name == "mtime" || name == "time") {
+        sort = ListSort::Mtime;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string_view DirectoryLister::nameOf(const Record& record) const {
+    return std::string_view(names.data() + record.nameOffset, record.nameLength);
+}
+
+void DirectoryLister::readEntries(ListSummary& summary) {
+#ifdef OS_LINUX
+    FileDescriptor fd(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.get() < 0) {
+        throw fs::filesystem_error("cannot open directory", directory, std::error_code(errno, std::generic_category()));
+    }
+    
+    std::vector<char> buffer(256 * 1024);
+    DirentReader reader(fd.get(), buffer);
+    while (const LinuxDirent64* entry = reader.next()) {
+        Record record{};
+        record.nameOffset = names.size();
+        record.nameLength = static_cast<std::uint16_t>(std::strlen(entry->name));
+        record.type = static_cast<std::uint8_t>(entryTypeFromDirent(entry->type));
+        record.targetType = record.type;
+        names.append(entry->name, record.nameLength);
+        records.push_back(record);
+    }
+    if (reader.error() != 0) {
+        throw fs::filesystem_error("cannot read directory", directory, std::error_code(reader.error(), std::generic_category()));
+    }
+#else
+    std::error_code error;
+    for (fs::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        Record record{};
+        record.nameOffset = names.size();
+        record.nameLength = static_cast<std::uint16_t>(name.size());
+        std::error_code ignored;
+        fs::file_status status = it->symlink_status(ignored);
+        record.type = static_cast<std::uint8_t>(entryTypeFromStatus(status));
+        record.targetType = static_cast<std::uint8_t>(fs::is_symlink(status) ? entryTypeFromStatus(it->status(ignored)) : entryTypeFromStatus(status));
+        names += name;
+        records.push_back(record);
+    }
+    if (error) {
+        throw fs::filesystem_error("cannot read directory", directory, error);
+    }
+#endif
+    
+    summary.entries = records.size();
+}
+
+void DirectoryLister::fetchMetadata(ListSummary& summary, bool typesOnly) {
+    bool needAll = options.longFormat || options.sort == ListSort::Size || options.sort == ListSort::Mtime;
+    
+    std::vector<std::size_t> pending;
+    for (std::size_t i = 0; i < records.size(); ++i) {
+        if (records[i].known) continue;
+        EntryType type = static_cast<EntryType>(records[i].type);
+        if (typesOnly ? type == EntryType::Unknown : needAll || type != EntryType::Directory) pending.push_back(i);
+    }
+    if (pending.empty()) return;
+    
+    std::atomic<std::uint64_t> errors(0);
+    
+#ifdef OS_LINUX
+    FileDescriptor fd(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd.get() < 0) {
+        throw fs::filesystem_error("cannot open directory", directory, std::error_code(errno, std::generic_category()));
+    }
+    
+    unsigned mask = STATX_TYPE | STATX_SIZE | STATX_MTIME | STATX_MODE;
+    
+    auto fetchRange = [&](std::size_t begin, std::size_t end) {
+        std::string name;
+        for (std::size_t i = begin; i < end; ++i) {
+            Record& record = records[pending[i]];
+            name.assign(nameOf(record));
+            
+            struct statx info;
+            if (typesOnly || static_cast<EntryType>(record.type) == EntryType::Unknown) {
+                if (::statx(fd.get(), name.c_str(), AT_STATX_DONT_SYNC | AT_SYMLINK_NOFOLLOW, STATX_TYPE, &info) != 0) {
+                    ++errors;
+                    continue;
+                }
+                record.type = static_cast<std::uint8_t>(entryTypeFromMode(info.stx_mode));
+                record.targetType = record.type;
+                if (typesOnly) continue;
+            }
+            
+            if (::statx(fd.get(), name.c_str(), AT_STATX_DONT_SYNC, mask, &info) != 0 &&
+                ::statx(fd.get(), name.c_str(), AT_STATX_DONT_SYNC | AT_SYMLINK_NOFOLLOW, mask, &info) != 0) {
+                ++errors;
+                continue;
+            }
+            
+            record.targetType = static_cast<std::uint8_t>(entryTypeFromMode(info.stx_mode));
+            record.mode = static_cast<std::uint16_t>(info.stx_mode);
+            record.size = info.stx_size;
+            record.mtime = static_cast<std::int64_t>(info.stx_mtime.tv_sec);
+            record.known = true;
+        }
+    };
+#else
+    auto fetchRange = [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            Record& record = records[pending[i]];
+            fs::path path = directory / std::string(nameOf(record));
+            std::error_code error;
+            
+            record.size = fs::is_directory(path, error) ? 0 : fs::file_size(path, error);
+            auto time = fs::last_write_time(path, error);
+            record.mtime = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+            record.mode = static_cast<std::uint16_t>(fs::status(path, error).permissions());
+            record.known = !error;
+            if (error) ++errors;
+        }
+    };
+#endif
+    
+    if (pending.size() < parallelStatThreshold || options.threads == 1) {
+        fetchRange(0, pending.size());
+    } else {
+        ThreadPool pool(options.threads);
+        std::size_t chunk = std::max<std::size_t>(1024, pending.size() / (pool.size() * 4));
+        for (std::size_t begin = 0; begin < pending.size(); begin += chunk) {
+            std::size_t end = std::min(pending.size(), begin + chunk);
+            pool.submit([&fetchRange, begin, end]() { fetchRange(begin, end); });
+        }
+        pool.wait();
+    }
+    
+    summary.statCalls = pending.size();
+    summary.errors = errors;
+}
+
+void DirectoryLister::sortRecords() {
+    auto byName = [this](const Record& a, const Record& b) { return nameOf(a) < nameOf(b); };
+    
+    switch (options.sort) {
+        case ListSort::Name:
+            std::sort(records.begin(), records.end(), byName);
+            break;
+        case ListSort::Size:
+            std::sort(records.begin(), records.end(), [&](const Record& a, const Record& b) {
+                return a.size != b.size ? a.size > b.size : byName(a, b);
+            });
+            break;
+        case ListSort::Mtime:
+            std::sort(records.begin(), records.end(), [&](const Record& a, const Record& b) {
+                return a.mtime != b.mtime ? a.mtime > b.mtime : byName(a, b);
+            });
+            break;
+        case ListSort::None:
+            break;
+    }
+    
+    if (options.reverse) std::reverse(records.begin(), records.end());
+}
+
+void DirectoryLister::render(std::string& output, const ListEntry& entry, bool longFormat) {
+    bool isDirectory = entry.targetType == EntryType::Directory;
+    std::size_t rowStart = output.size();
+    
+    if (longFormat) {
+        appendMode(output, entry.mode, entry.targetType);
+        appendNumber(output, entry.size, 14);
+        output += "  ";
+        
+        thread_local std::int64_t cachedMinute = -1;
+        thread_local char cachedTime[20];
+        std::int64_t minute = entry.mtime / 60;
+        if (minute != cachedMinute) {
+            std::time_t time = static_cast<std::time_t>(entry.mtime);
+            std::tm timeInfo;
+#ifdef OS_WINDOWS
+            localtime_s(&timeInfo, &time);
+#else
+            localtime_r(&time, &timeInfo);
+#endif
+            std::strftime(cachedTime, sizeof(cachedTime), "%Y-%m-%d %H:%M", &timeInfo);
+            cachedMinute = minute;
+        }
+        output += cachedTime;
+        output += "  ";
+        output.append(entry.name);
+        if (isDirectory) output += '/';
+        output += '\n';
+        return;
+    }
+    
+    output += isDirectory ? "[DIR]" : "[FILE]";
+    pad(output, rowStart, 10);
+    output.append(entry.name);
+    pad(output, rowStart, 50);
+    if (!isDirectory) {
+        appendNumber(output, entry.size, 0);
+        output += " bytes";
+    }
+    output += '\n';
+}
+
+void DirectoryLister::loadEntries(ListSummary& summary, bool typesOnly) {
+    std::uint64_t token = 0;
+    if (options.cache) {
+        summary.cached = options.cache->lookup(directory.string(), names, records, token, options.fillCache);
+    }
+    
+    if (summary.cached) {
+        summary.entries = records.size();
+    } else {
+        readEntries(summary);
+    }
+    fetchMetadata(summary, typesOnly);
+    
+    if (options.cache && (!summary.cached || summary.statCalls > 0)) {
+        options.cache->store(directory.string(), token, names, records);
+    }
+}
+
+ListSummary DirectoryLister::list(const std::function<void(const std::string& chunk)>& output) {
+    std::string buffer;
+    buffer.reserve(outputChunk + 4096);
+    
+    ListSummary summary = visit([&](const ListEntry& entry) {
+        render(buffer, entry, options.longFormat);
+        if (buffer.size() >= outputChunk) {
+            output(buffer);
+            buffer.clear();
+        }
+        return true;
+    });
+    
+    if (!buffer.empty()) output(buffer);
+    return summary;
+}
+
+ListSummary DirectoryLister::visit(const std::function<bool(const ListEntry& entry)>& visitor, bool typesOnly) {
+    ListSummary summary;
+    loadEntries(summary, typesOnly);
+    sortRecords();
+    
+    for (const auto& record : records) {
+        ListEntry entry{nameOf(record), static_cast<EntryType>(record.type), static_cast<EntryType>(record.targetType), record.size,
+                        record.mtime, record.mode, record.known};
+        if (!visitor(entry)) break;
+    }
+    return summary;
+}
@@ -0,0 +1,88 @@
+#ifndef DIRECTORY_LISTER_H
+#define DIRECTORY_LISTER_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+#include "DirectoryWalker.h"
+
+namespace fs = std::filesystem;
+
+class DirectoryCache;
+
+enum class ListSort {
+    None,
+    Name,
+    Size,
+    Mtime
+};
+
+struct ListOptions {
+    ListSort sort = ListSort::None;
+    bool reverse = false;
+    bool longFormat = false;
+    unsigned threads = 0;
+    DirectoryCache* cache = nullptr;
+    bool fillCache = true;
+};
+
+struct ListRecord {
+    std::uint64_t size;
+    std::int64_t mtime;
+    std::uint64_t nameOffset;
+    std::uint16_t nameLength;
+    std::uint16_t mode;
+    std::uint8_t type;
+    std::uint8_t targetType;
+    bool known;
+};
+
+struct ListEntry {
+    std::string_view name;
+    EntryType type;
+    EntryType targetType;
+    std::uint64_t size;
+    std::int64_t mtime;
+    std::uint16_t mode;
+    bool known;
+};
+
+struct ListSummary {
+    std::uint64_t entries = 0;
+    std::uint64_t statCalls = 0;
+    std::uint64_t errors = 0;
+    bool cached = false;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class DirectoryLister {
+private:
+    using Record = ListRecord;
+    
+    fs::path directory;
+    ListOptions options;
+    std::string names;
+    std::vector<Record> records;
+    
+    void readEntries(ListSummary& summary);
+    void loadEntries(ListSummary& summary, bool typesOnly);
+    void fetchMetadata(ListSummary& summary, bool typesOnly);
+    void sortRecords();
+    std::string_view nameOf(const Record& record) const;
+    
+public:
+    DirectoryLister(const fs::path& directory, const ListOptions& options);
+    
+    ListSummary list(const std::function<void(const std::string& chunk)>& output);
+    ListSummary visit(const std::function<bool(const ListEntry& entry)>& visitor, bool typesOnly = false);
+    
+    static bool parseSort(const std::string& name, ListSort& sort);
+    static void render(std::string& output, const ListEntry& entry, bool longFormat);
+};
+
+#endif
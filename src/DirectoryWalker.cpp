@@ -0,0 +1,136 @@
+#include "DirectoryWalker.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <vector>
+#include <cstring>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+EntryType entryTypeFromStatus(const fs::file_status& status) {
+    switch (status.type()) {
+        case fs::file_type::regular: return EntryType::File;
+        case fs::file_type::directory: return EntryType::Directory;
+        case fs::file_type::symlink: return EntryType::Symlink;
+        case fs::file_type::unknown: return EntryType::Unknown;
+        default: return EntryType::Other;
+    }
+}
+
+std::string joinPath(const std::string& directory, std::string_view name) {
+    std::string path;
+    path.reserve(directory.size() + name.size() + 1);
+    path = directory;
+    if (path.empty() || path.back() != static_cast<char>(fs::path::preferred_separator)) {
+        path += static_cast<char>(fs::path::preferred_separator);
+    }
+    path.append(name.data(), name.size());
+    return path;
+}
+
+std::string WalkEntry::path() const {
+    return joinPath(directory, std::string_view(name, nameLength));
+}
+
+DirectoryWalker::DirectoryWalker(unsigned threads) : pool(threads), stopping(false) {}
+
+unsigned DirectoryWalker::threadCount() const {
+    return pool.size();
+}
+
+void DirectoryWalker::walk(const fs::path& root, const Visitor& visitor, const ErrorHandler& onError) {
+    stopping = false;
+    std::string start = root.string();
+    pool.submit([this, start, &visitor, &onError]() { walkDirectory(start, visitor, onError); });
+    pool.wait();
+}
+
+void DirectoryWalker::stop() {
+    stopping.store(true, std::memory_order_relaxed);
+}
+
+void DirectoryWalker::walkDirectory(const std::string& directory, const Visitor& visitor, const ErrorHandler& onError) {
+    if (stopping.load(std::memory_order_relaxed)) return;
+    
+    unsigned worker = static_cast<unsigned>(ThreadPool::currentWorker());
+    
+#ifdef OS_LINUX
+    FileDescriptor descriptor(::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    int fd = descriptor.get();
+    if (fd < 0) {
+        Metrics::add(MetricCounter::Errors);
+        onError(directory, std::error_code(errno, std::generic_category()), worker);
+        return;
+    }
+    
+    thread_local std::vector<char> buffer(64 * 1024);
+    DirentReader reader(fd, buffer);
+    std::uint64_t entries = 0;
+    std::uint64_t stats = 0;
+    
+    while (!stopping.load(std::memory_order_relaxed)) {
+        const LinuxDirent64* record = reader.next();
+        if (!record) {
+            if (reader.error() != 0) {
+                Metrics::add(MetricCounter::Errors);
+                onError(directory, std::error_code(reader.error(), std::generic_category()), worker);
+            }
+            break;
+        }
+        
+        const char* name = record->name;
+        ++entries;
+        EntryType type = entryTypeFromDirent(record->type);
+        if (type == EntryType::Unknown) {
+            ++stats;
+            struct stat info;
+            if (::fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) == 0) {
+                type = entryTypeFromMode(info.st_mode);
+            }
+        }
+        
+        WalkEntry entry{directory, name, std::strlen(name), type, worker, fd};
+        if (visitor(entry) && type == EntryType::Directory) {
+            std::string child = entry.path();
+            pool.submit([this, child, &visitor, &onError]() { walkDirectory(child, visitor, onError); });
+        }
+    }
+    
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+    Metrics::add(MetricCounter::DirectoryReads, reader.readCalls());
+    Metrics::add(MetricCounter::StatCalls, stats);
+#else
+    std::error_code error;
+    fs::directory_iterator it(directory, error);
+    if (error) {
+        Metrics::add(MetricCounter::Errors);
+        onError(directory, error, worker);
+        return;
+    }
+    
+    Metrics::add(MetricCounter::DirectoryReads);
+    
+    for (fs::directory_iterator end; it != end && !stopping.load(std::memory_order_relaxed); it.increment(error)) {
+        if (error) {
+            Metrics::add(MetricCounter::Errors);
+            onError(directory, error, worker);
+            break;
+        }
+        
+        Metrics::add(MetricCounter::EntriesVisited);
+        
+        std::string name = it->path().filename().string();
+        EntryType type = entryTypeFromStatus(it->symlink_status(error));
+        
+        WalkEntry entry{directory, name.c_str(), name.size(), type, worker, -1};
+        if (visitor(entry) && type == EntryType::Directory) {
+            std::string child = entry.path();
+            pool.submit([this, child, &visitor, &onError]() { walkDirectory(child, visitor, onError); });
+        }
+    }
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <atomic>
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+enum class EntryType {
+    Unknown,
+    File,
+    Directory,
+    Symlink,
+    Other
+};
+
+struct WalkEntry {
+    const std::string& directory;
+    const char* name;
+    std::size_t nameLength;
+    EntryType type;
+    unsigned worker;
+    int directoryFd;
+    
+    std::string path() const;
+};
+
+EntryType entryTypeFromStatus(const fs::file_status& status);
+std::string joinPath(const std::string& directory, std::string_view name);
+
+class DirectoryWalker {
+public:
+    using Visitor = std::function<bool(const WalkEntry& entry)>;
+    using ErrorHandler = std::function<void(const std::string& directory, const std::error_code& error, unsigned worker)>;
+    
+private:
+    ThreadPool pool;
+    std::atomic<bool> stopping;
+    
+    void walkDirectory(const std::string& directory, const Visitor& visitor, const ErrorHandler& onError);
+    
+public:
+    explicit DirectoryWalker(unsigned threads = 0);
+    
+    unsigned threadCount() const;
+    void walk(const fs::path& root, const Visitor& visitor, const ErrorHandler& onError);
+    void stop();
+};
+
+#endif
@@ -0,0 +1,321 @@
+#include "DiskUsage.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <algorithm>
+#include <queue>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#endif
+
+namespace {
+
+#ifdef OS_LINUX
+const unsigned directoryMask = STATX_TYPE | STATX_MTIME | STATX_INO | STATX_BLOCKS | STATX_SIZE;
+const unsigned entryMask = STATX_TYPE | STATX_NLINK | STATX_INO | STATX_BLOCKS | STATX_SIZE;
+#endif
+
+}
+
+void UsageTotals::add(const UsageTotals& other) {
+    allocated += other.allocated;
+    apparent += other.apparent;
+    files += other.files;
+    directories += other.directories;
+}
+
+bool InodeKey::operator==(const InodeKey& other) const {
+    return device == other.device && inode == other.inode;
+}
+
+std::size_t InodeKeyHash::operator()(const InodeKey& key) const {
+    std::uint64_t value = key.inode * 0x9e3779b97f4a7c15ull ^ key.device;
+    return static_cast<std::size_t>(value ^ (value >> 29));
+}
+
+const DiskUsageCache::Record* DiskUsageCache::find(const InodeKey& key) const {
+    auto found = records.find(key);
+    return found == records.end() ? nullptr : &found->second;
+}
+
+void DiskUsageCache::store(const InodeKey& key, Record record) {
+    records[key] = std::move(record);
+}
+
+void DiskUsageCache::clear() {
+    records.clear();
+}
+
+DiskUsageScanner::Node::Node(Node* parent, std::string name) : parent(parent), name(std::move(name)) {}
+
+DiskUsageScanner::DiskUsageScanner(const DiskUsageOptions& options)
+    : options(options), pool(options.threads), updates(pool.size()), duplicateLinks(0), scannedDirectories(0),
+      cachedDirectories(0), errors(0) {}
+
+void DiskUsageScanner::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+bool DiskUsageScanner::claim(const InodeKey& key) {
+    Shard& shard = shards[InodeKeyHash()(key) % shards.size()];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.inodes.insert(key).second;
+}
+
+std::uint64_t DiskUsageScanner::measure(const UsageTotals& totals) const {
+    return options.apparentSize ? totals.apparent : totals.allocated;
+}
+
+std::string DiskUsageScanner::pathOf(const Node* node) {
+    std::vector<const Node*> chain;
+    for (const Node* current = node; current; current = current->parent) chain.push_back(current);
+    
+    std::string path;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        if (!path.empty() && path.back() != static_cast<char>(fs::path::preferred_separator)) {
+            path += static_cast<char>(fs::path::preferred_separator);
+        }
+        path += (*it)->name;
+    }
+    return path;
+}
+
+void DiskUsageScanner::addChildren(Node* node, const std::string& path, const std::string& names) {
+    const char separator = static_cast<char>(fs::path::preferred_separator);
+    std::string prefix = path;
+    if (prefix.empty() || prefix.back() != separator) prefix += separator;
+    
+    for (std::size_t start = 0; start < names.size();) {
+        std::size_t end = names.find('\0', start);
+        if (end == std::string::npos) end = names.size();
+        
+        node->children.push_back(std::make_unique<Node>(node, names.substr(start, end - start)));
+        Node* child = node->children.back().get();
+        std::string childPath = prefix + child->name;
+        pool.submit([this, child, childPath]() { scan(child, childPath); });
+        start = end + 1;
+    }
+}
+
+#ifdef OS_LINUX
+void DiskUsageScanner::scan(Node* node, const std::string& path) {
+    struct statx info;
+    if (::statx(AT_FDCWD, path.c_str(), AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, directoryMask, &info) != 0) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        return;
+    }
+    Metrics::add(MetricCounter::StatCalls);
+    
+    InodeKey key{makedev(info.stx_dev_major, info.stx_dev_minor), info.stx_ino};
+    node->own.allocated += info.stx_blocks * 512;
+    node->own.apparent += info.stx_size;
+    node->own.directories += 1;
+    
+    const DiskUsageCache::Record* cached = options.cache && options.cached ? options.cache->find(key) : nullptr;
+    if (cached && cached->mtimeSeconds == info.stx_mtime.tv_sec && cached->mtimeNanoseconds == info.stx_mtime.tv_nsec) {
+        cachedDirectories.fetch_add(1, std::memory_order_relaxed);
+        node->own.add(cached->files);
+        for (const auto& file : cached->linked) {
+            if (claim(file.key)) {
+                node->own.allocated += file.allocated;
+                node->own.apparent += file.apparent;
+                node->own.files += 1;
+            } else {
+                duplicateLinks.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        addChildren(node, path, cached->subdirectories);
+        return;
+    }
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        return;
+    }
+    
+    DiskUsageCache::Record record;
+    record.mtimeSeconds = info.stx_mtime.tv_sec;
+    record.mtimeNanoseconds = info.stx_mtime.tv_nsec;
+    
+    thread_local std::vector<char> buffer(64 * 1024);
+    DirentReader reader(fd, buffer);
+    std::uint64_t stats = 0;
+    std::uint64_t entries = 0;
+    bool complete = true;
+    
+    while (const LinuxDirent64* dirent = reader.next()) {
+        const char* name = dirent->name;
+        ++entries;
+        
+        if (dirent->type == DT_DIR) {
+            record.subdirectories += name;
+            record.subdirectories += '\0';
+            continue;
+        }
+        
+        struct statx entry;
+        ++stats;
+        if (::statx(fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, entryMask, &entry) != 0) {
+            fail(path + '/' + name, std::error_code(errno, std::generic_category()));
+            complete = false;
+            continue;
+        }
+        
+        if (S_ISDIR(entry.stx_mode)) {
+            record.subdirectories += name;
+            record.subdirectories += '\0';
+        } else if (entry.stx_nlink > 1) {
+            record.linked.push_back({{key.device, entry.stx_ino}, entry.stx_blocks * 512, entry.stx_size});
+        } else {
+            record.files.allocated += entry.stx_blocks * 512;
+            record.files.apparent += entry.stx_size;
+            record.files.files += 1;
+        }
+    }
+    if (reader.error() != 0) {
+        fail(path, std::error_code(reader.error(), std::generic_category()));
+        complete = false;
+    }
+    ::close(fd);
+    
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+    Metrics::add(MetricCounter::DirectoryReads, reader.readCalls());
+    Metrics::add(MetricCounter::StatCalls, stats);
+    scannedDirectories.fetch_add(1, std::memory_order_relaxed);
+    
+    node->own.add(record.files);
+    for (const auto& file : record.linked) {
+        if (claim(file.key)) {
+            node->own.allocated += file.allocated;
+            node->own.apparent += file.apparent;
+            node->own.files += 1;
+        } else {
+            duplicateLinks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    addChildren(node, path, record.subdirectories);
+    
+    if (complete && options.cache) {
+        updates[static_cast<std::size_t>(ThreadPool::currentWorker())].emplace_back(key, std::move(record));
+    }
+}
+#else
+void DiskUsageScanner::scan(Node* node, const std::string& path) {
+    std::error_code error;
+    fs::directory_iterator it(path, error);
+    if (error) {
+        fail(path, error);
+        return;
+    }
+    
+    node->own.directories += 1;
+    scannedDirectories.fetch_add(1, std::memory_order_relaxed);
+    
+    std::string names;
+    for (fs::directory_iterator end; it != end; it.increment(error)) {
+        if (error) {
+            fail(path, error);
+            break;
+        }
+        
+        fs::file_status status = it->symlink_status(error);
+        if (fs::is_directory(status)) {
+            names += it->path().filename().string();
+            names += '\0';
+        } else if (fs::is_regular_file(status)) {
+            std::uintmax_t size = it->file_size(error);
+            if (error) {
+                fail(it->path().string(), error);
+                continue;
+            }
+            node->own.allocated += size;
+            node->own.apparent += size;
+            node->own.files += 1;
+        } else {
+            node->own.files += 1;
+        }
+    }
+    addChildren(node, path, names);
+}
+#endif
+
+void DiskUsageScanner::accumulate(Node* root) {
+    std::vector<std::pair<Node*, bool>> stack;
+    stack.emplace_back(root, false);
+    
+    while (!stack.empty()) {
+        auto [node, visited] = stack.back();
+        stack.pop_back();
+        
+        if (!visited) {
+            stack.emplace_back(node, true);
+            for (auto& child : node->children) stack.emplace_back(child.get(), false);
+            continue;
+        }
+        
+        node->total = node->own;
+        for (auto& child : node->children) node->total.add(child->total);
+    }
+}
+
+void DiskUsageScanner::collectLargest(Node* root) {
+    auto smaller = [this](const Node* a, const Node* b) { return measure(a->total) > measure(b->total); };
+    std::priority_queue<const Node*, std::vector<const Node*>, decltype(smaller)> heap(smaller);
+    
+    std::vector<const Node*> stack;
+    for (auto& child : root->children) stack.push_back(child.get());
+    while (!stack.empty()) {
+        const Node* node = stack.back();
+        stack.pop_back();
+        for (auto& child : node->children) stack.push_back(child.get());
+        
+        if (heap.size() < options.top) {
+            heap.push(node);
+        } else if (measure(node->total) > measure(heap.top()->total)) {
+            heap.pop();
+            heap.push(node);
+        }
+    }
+    
+    while (!heap.empty()) {
+        summary.largest.push_back({pathOf(heap.top()), heap.top()->total});
+        heap.pop();
+    }
+    std::reverse(summary.largest.begin(), summary.largest.end());
+}
+
+DiskUsageSummary DiskUsageScanner::scan(const fs::path& root) {
+    std::string rootPath = root.string();
+    while (rootPath.size() > 1 && rootPath.back() == static_cast<char>(fs::path::preferred_separator)) rootPath.pop_back();
+    
+    Node tree(nullptr, rootPath);
+    pool.submit([this, &tree, rootPath]() { scan(&tree, rootPath); });
+    pool.wait();
+    
+    accumulate(&tree);
+    if (options.top > 0) collectLargest(&tree);
+    
+    if (options.cache) {
+        for (auto& worker : updates) {
+            for (auto& update : worker) options.cache->store(update.first, std::move(update.second));
+        }
+    }
+    
+    summary.totals = tree.total;
+    summary.duplicateLinks = duplicateLinks.load();
+    summary.scannedDirectories = scannedDirectories.load();
+    summary.cachedDirectories = cachedDirectories.load();
+    summary.errors = errors.load();
+    return summary;
+}
@@ -0,0 +1,132 @@
+#ifndef DISK_USAGE_H
+#define DISK_USAGE_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <system_error>
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+struct UsageTotals {
+    std::uint64_t allocated = 0;
+    std::uint64_t apparent = 0;
+    std::uint64_t files = 0;
+    std::uint64_t directories = 0;
+    
+    void add(const UsageTotals& other);
+};
+
+struct InodeKey {
+    std::uint64_t device = 0;
+    std::uint64_t inode = 0;
+    
+    bool operator==(const InodeKey& other) const;
+};
+
+struct InodeKeyHash {
+    std::size_t operator()(const InodeKey& key) const;
+};
+
+class DiskUsageCache {
+public:
+    struct LinkedFile {
+        InodeKey key;
+        std::uint64_t allocated;
+        std::uint64_t apparent;
+    };
+    
+    struct Record {
+        std::int64_t mtimeSeconds = 0;
+        std::uint32_t mtimeNanoseconds = 0;
+        UsageTotals files;
+        std::string subdirectories;
+        std::vector<LinkedFile> linked;
+    };
+    
+private:
+    std::unordered_map<InodeKey, Record, InodeKeyHash> records;
+    
+public:
+    const Record* find(const InodeKey& key) const;
+    void store(const InodeKey& key, Record record);
+    void clear();
+};
+
+struct SubtreeUsage {
+    std::string path;
+    UsageTotals totals;
+};
+
+struct DiskUsageOptions {
+    unsigned threads = 0;
+    std::size_t top = 0;
+    bool apparentSize = false;
+    bool cached = false;
+    DiskUsageCache* cache = nullptr;
+};
+
+struct DiskUsageSummary {
+    UsageTotals totals;
+    std::uint64_t duplicateLinks = 0;
+    std::uint64_t scannedDirectories = 0;
+    std::uint64_t cachedDirectories = 0;
+    std::vector<SubtreeUsage> largest;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class DiskUsageScanner {
+private:
+    struct Node {
+        Node* parent;
+        std::string name;
+        UsageTotals own;
+        UsageTotals total;
+        std::vector<std::unique_ptr<Node>> children;
+        
+        Node(Node* parent, std::string name);
+    };
+    
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_set<InodeKey, InodeKeyHash> inodes;
+    };
+    
+    DiskUsageOptions options;
+    ThreadPool pool;
+    std::array<Shard, 64> shards;
+    std::vector<std::vector<std::pair<InodeKey, DiskUsageCache::Record>>> updates;
+    
+    std::atomic<std::uint64_t> duplicateLinks;
+    std::atomic<std::uint64_t> scannedDirectories;
+    std::atomic<std::uint64_t> cachedDirectories;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    DiskUsageSummary summary;
+    
+    bool claim(const InodeKey& key);
+    void scan(Node* node, const std::string& path);
+    void addChildren(Node* node, const std::string& path, const std::string& names);
+    void accumulate(Node* root);
+    void collectLargest(Node* root);
+    std::uint64_t measure(const UsageTotals& totals) const;
+    static std::string pathOf(const Node* node);
+    void fail(const std::string& path, const std::error_code& error);
+    
+public:
+    explicit DiskUsageScanner(const DiskUsageOptions& options = DiskUsageOptions());
+    
+    DiskUsageSummary scan(const fs::path& root);
+};
+
+#endif
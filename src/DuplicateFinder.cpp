@@ -0,0 +1,519 @@
+#include "DuplicateFinder.h"
+#include "DirectoryWalker.h"
+#include "ThreadPool.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <tuple>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#else
+#include <fstream>
+#endif
+
+namespace {
+
+const std::size_t readBlock = 1 << 20;
+
+class Hasher64 {
+private:
+    static const std::uint64_t prime1 = 11400714785074694791ull;
+    static const std::uint64_t prime2 = 14029467366897019727ull;
+    static const std::uint64_t prime3 = 1609587929392839161ull;
+    static const std::uint64_t prime4 = 9650029242287828579ull;
+    static const std::uint64_t prime5 = 2870177450012600261ull;
+    
+    std::uint64_t lanes[4];
+    unsigned char pending[32];
+    std::size_t pendingSize;
+    std::uint64_t total;
+    
+    static std::uint64_t rotate(std::uint64_t value, int bits) {
+        return (value << bits) | (value >> (64 - bits));
+    }
+    
+    static std::uint64_t load64(const unsigned char* data) {
+        std::uint64_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    
+    static std::uint32_t load32(const unsigned char* data) {
+        std::uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+    
+    static std::uint64_t round(std::uint64_t lane, std::uint64_t input) {
+        lane += input * prime2;
+        return rotate(lane, 31) * prime1;
+    }
+    
+    static std::uint64_t merge(std::uint64_t hash, std::uint64_t lane) {
+        hash ^= round(0, lane);
+        return hash * prime1 + prime4;
+    }
+    
+    void consume(const unsigned char* stripe) {
+        lanes[0] = round(lanes[0], load64(stripe));
+        lanes[1] = round(lanes[1], load64(stripe + 8));
+        lanes[2] = round(lanes[2], load64(stripe + 16));
+        lanes[3] = round(lanes[3], load64(stripe + 24));
+    }
+    
+public:
+    Hasher64() : lanes{prime1 + prime2, prime2, 0, 0 - prime1}, pendingSize(0), total(0) {}
+    
+    void update(const char* input, std::size_t size) {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(input);
+        total += size;
+        
+        if (pendingSize > 0) {
+            std::size_t take = std::min(size, sizeof(pending) - pendingSize);
+            std::memcpy(pending + pendingSize, data, take);
+            pendingSize += take;
+            data += take;
+            size -= take;
+            if (pendingSize < sizeof(pending)) return;
+            consume(pending);
+            pendingSize = 0;
+        }
+        
+        for (; size >= sizeof(pending); data += sizeof(pending), size -= sizeof(pending)) {
+            consume(data);
+        }
+        
+        std::memcpy(pending, data, size);
+        pendingSize = size;
+    }
+    
+    std::uint64_t digest() const {
+        std::uint64_t hash;
+        if (total >= sizeof(pending)) {
+            hash = rotate(lanes[0], 1) + rotate(lanes[1], 7) + rotate(lanes[2], 12) + rotate(lanes[3], 18);
+            for (std::uint64_t lane : lanes) hash = merge(hash, lane);
+        } else {
+            hash = prime5;
+        }
+        hash += total;
+        
+        const unsigned char* data = pending;
+        std::size_t size = pendingSize;
+        for (; size >= 8; data += 8, size -= 8) {
+            hash ^= round(0, load64(data));
+            hash = rotate(hash, 27) * prime1 + prime4;
+        }
+        if (size >= 4) {
+            hash ^= static_cast<std::uint64_t>(load32(data)) * prime1;
+            hash = rotate(hash, 23) * prime2 + prime3;
+            data += 4;
+            size -= 4;
+        }
+        for (; size > 0; ++data, --size) {
+            hash ^= *data * prime5;
+            hash = rotate(hash, 11) * prime1;
+        }
+        
+        hash ^= hash >> 33;
+        hash *= prime2;
+        hash ^= hash >> 29;
+        hash *= prime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+};
+
+class InputFile {
+private:
+#ifdef OS_LINUX
+    int fd;
+#else
+    std::ifstream stream;
+#endif
+    std::error_code openError;
+    
+public:
+    explicit InputFile(const std::string& path, bool sequential) {
+#ifdef OS_LINUX
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            openError = std::error_code(errno, std::generic_category());
+        } else if (sequential) {
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
+#else
+        (void)sequential;
+        stream.open(path, std::ios::binary);
+        if (!stream) openError = std::make_error_code(std::errc::permission_denied);
+#endif
+    }
+
+#ifdef OS_LINUX
+    ~InputFile() {
+        if (fd >= 0) ::close(fd);
+    }
+#endif
+
+    InputFile(const InputFile&) = delete;
+    InputFile& operator=(const InputFile&) = delete;
+    
+    const std::error_code& error() const { return openError; }
+    
+    bool read(char* buffer, std::size_t size, std::uint64_t offset, std::size_t& got, std::error_code& error) {
+        got = 0;
+#ifdef OS_LINUX
+        while (got < size) {
+            ssize_t n = ::pread(fd, buffer + got, size - got, static_cast<off_t>(offset + got));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = std::error_code(errno, std::generic_category());
+                return false;
+            }
+            if (n == 0) break;
+            got += static_cast<std::size_t>(n);
+        }
+#else
+        stream.clear();
+        stream.seekg(static_cast<std::streamoff>(offset));
+        stream.read(buffer, static_cast<std::streamsize>(size));
+        got = static_cast<std::size_t>(stream.gcount());
+        if (stream.bad()) {
+            error = std::make_error_code(std::errc::io_error);
+            return false;
+        }
+#endif
+        Metrics::add(MetricCounter::BytesRead, got);
+        return true;
+    }
+};
+
+}
+
+DuplicateFinder::DuplicateFinder(const DupeOptions& options) : options(options), errors(0) {}
+
+void DuplicateFinder::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+std::vector<DuplicateFinder::Candidate> DuplicateFinder::collect(const fs::path& root) {
+    DirectoryWalker walker(options.threads);
+    std::vector<std::vector<Candidate>> workerFiles(walker.threadCount());
+    std::vector<std::uint64_t> workerStats(walker.threadCount(), 0);
+    
+    walker.walk(root,
+        [&](const WalkEntry& entry) {
+            if (entry.type != EntryType::File && entry.type != EntryType::Unknown) return true;
+            
+            std::string path = entry.path();
+            Candidate candidate{path, 0, 0, 0, 0, false};
+#ifdef OS_LINUX
+            struct stat info;
+            ++workerStats[entry.worker];
+            if (::lstat(path.c_str(), &info) != 0) {
+                fail(path, std::error_code(errno, std::generic_category()));
+                return true;
+            }
+            if (!S_ISREG(info.st_mode)) return true;
+            
+            candidate.size = static_cast<std::uintmax_t>(info.st_size);
+            candidate.device = static_cast<std::uint64_t>(info.st_dev);
+            candidate.inode = static_cast<std::uint64_t>(info.st_ino);
+#else
+            std::error_code error;
+            if (!fs::is_regular_file(fs::symlink_status(path, error))) return true;
+            
+            candidate.size = fs::file_size(path, error);
+            if (error) {
+                fail(path, error);
+                return true;
+            }
+#endif
+            if (candidate.size >= options.minSize) {
+                workerFiles[entry.worker].push_back(std::move(candidate));
+            }
+            return true;
+        },
+        [&](const std::string& directory, const std::error_code& error, unsigned) {
+            fail(directory, error);
+        });
+    
+    std::vector<Candidate> files;
+    for (std::size_t i = 0; i < workerFiles.size(); ++i) {
+        Metrics::add(MetricCounter::StatCalls, workerStats[i]);
+        std::move(workerFiles[i].begin(), workerFiles[i].end(), std::back_inserter(files));
+    }
+    return files;
+}
+
+std::vector<std::vector<DuplicateFinder::Candidate>> DuplicateFinder::sizeGroups(std::vector<Candidate>& files) {
+    std::sort(files.begin(), files.end(), [](const Candidate& a, const Candidate& b) {
+        return std::tie(a.size, a.device, a.inode, a.path) < std::tie(b.size, b.device, b.inode, b.path);
+    });
+    
+    std::vector<std::vector<Candidate>> groups;
+    for (std::size_t begin = 0; begin < files.size();) {
+        std::size_t end = begin + 1;
+        while (end < files.size() && files[end].size == files[begin].size) ++end;
+        
+        if (end - begin > 1) {
+            std::vector<Candidate> group;
+            for (std::size_t i = begin; i < end; ++i) {
+                const Candidate& file = files[i];
+                if (!group.empty() && file.inode != 0 &&
+                    group.back().device == file.device && group.back().inode == file.inode) {
+                    ++summary.hardlinksSkipped;
+                    continue;
+                }
+                group.push_back(std::move(files[i]));
+            }
+            if (group.size() > 1) groups.push_back(std::move(group));
+        }
+        begin = end;
+    }
+    
+    return groups;
+}
+
+bool DuplicateFinder::hashFile(Candidate& candidate, bool full) {
+    InputFile input(candidate.path, full);
+    if (input.error()) {
+        fail(candidate.path, input.error());
+        return false;
+    }
+    
+    thread_local std::vector<char> buffer(readBlock);
+    Hasher64 hasher;
+    std::error_code error;
+    std::size_t got = 0;
+    std::uintmax_t edge = options.edgeBytes;
+    
+    if (!full && candidate.size > 2 * edge) {
+        if (!input.read(buffer.data(), edge, 0, got, error) || got != edge) {
+            fail(candidate.path, error ? error : std::make_error_code(std::errc::io_error));
+            return false;
+        }
+        hasher.update(buffer.data(), got);
+        
+        if (!input.read(buffer.data(), edge, candidate.size - edge, got, error) || got != edge) {
+            fail(candidate.path, error ? error : std::make_error_code(std::errc::io_error));
+            return false;
+        }
+        hasher.update(buffer.data(), got);
+    } else {
+        std::uint64_t offset = 0;
+        while (offset < candidate.size) {
+            if (!input.read(buffer.data(), buffer.size(), offset, got, error)) {
+                fail(candidate.path, error);
+                return false;
+            }
+            if (got == 0) break;
+            hasher.update(buffer.data(), got);
+            offset += got;
+        }
+        if (offset != candidate.size) {
+            fail(candidate.path, std::make_error_code(std::errc::io_error));
+            return false;
+        }
+    }
+    
+    candidate.hash = hasher.digest();
+    return true;
+}
+
+std::vector<std::vector<DuplicateFinder::Candidate>> DuplicateFinder::splitByHash(std::vector<Candidate>& group) {
+    group.erase(std::remove_if(group.begin(), group.end(), [](const Candidate& c) { return c.failed; }), group.end());
+    std::sort(group.begin(), group.end(), [](const Candidate& a, const Candidate& b) {
+        return std::tie(a.hash, a.path) < std::tie(b.hash, b.path);
+    });
+    
+    std::vector<std::vector<Candidate>> parts;
+    for (std::size_t begin = 0; begin < group.size();) {
+        std::size_t end = begin + 1;
+        while (end < group.size() && group[end].hash == group[begin].hash) ++end;
+        
+        if (end - begin > 1) {
+            parts.emplace_back(std::make_move_iterator(group.begin() + begin), std::make_move_iterator(group.begin() + end));
+        }
+        begin = end;
+    }
+    return parts;
+}
+
+void DuplicateFinder::hashGroups(std::vector<std::vector<Candidate>>& groups, bool full) {
+    std::uintmax_t partialLimit = 2 * static_cast<std::uintmax_t>(options.edgeBytes);
+    std::uint64_t submitted = 0;
+    
+    {
+        ThreadPool pool(options.threads);
+        for (auto& group : groups) {
+            if (full && group.front().size <= partialLimit) continue;
+            
+            for (auto& candidate : group) {
+                Candidate* target = &candidate;
+                pool.submit([this, target, full]() {
+                    if (!hashFile(*target, full)) target->failed = true;
+                });
+                ++submitted;
+            }
+        }
+        pool.wait();
+    }
+    
+    (full ? summary.fullHashed : summary.partialHashed) += submitted;
+    
+    std::vector<std::vector<Candidate>> next;
+    for (auto& group : groups) {
+        if (full && group.front().size <= partialLimit) {
+            next.push_back(std::move(group));
+            continue;
+        }
+        for (auto& part : splitByHash(group)) {
+            next.push_back(std::move(part));
+        }
+    }
+    groups.swap(next);
+}
+
+bool DuplicateFinder::sameContent(const std::string& first, const std::string& second) {
+    InputFile a(first, true);
+    InputFile b(second, true);
+    if (a.error() || b.error()) {
+        fail(a.error() ? first : second, a.error() ? a.error() : b.error());
+        return false;
+    }
+    
+    std::vector<char> left(readBlock);
+    std::vector<char> right(readBlock);
+    std::uint64_t offset = 0;
+    std::error_code error;
+    
+    while (true) {
+        std::size_t gotLeft = 0;
+        std::size_t gotRight = 0;
+        if (!a.read(left.data(), left.size(), offset, gotLeft, error) ||
+            !b.read(right.data(), right.size(), offset, gotRight, error)) {
+            fail(second, error);
+            return false;
+        }
+        if (gotLeft != gotRight || std::memcmp(left.data(), right.data(), gotLeft) != 0) return false;
+        if (gotLeft == 0) return true;
+        offset += gotLeft;
+    }
+}
+
+std::error_code DuplicateFinder::createLink(const std::string& original, const std::string& duplicate, const std::string& temp) const {
+    std::error_code error;
+    if (options.link == LinkMode::Hard) {
+        fs::create_hard_link(original, temp, error);
+        return error;
+    }
+    
+#ifdef OS_LINUX
+    struct stat info;
+    int in = ::open(original.c_str(), O_RDONLY | O_CLOEXEC);
+    int out = -1;
+    if (in < 0 || ::stat(duplicate.c_str(), &info) != 0 ||
+        (out = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, info.st_mode & 07777)) < 0 ||
+        ::ioctl(out, FICLONE, in) != 0) {
+        error = std::error_code(errno, std::generic_category());
+    }
+    if (out >= 0) ::close(out);
+    if (out >= 0 && error) ::unlink(temp.c_str());
+    if (in >= 0) ::close(in);
+#else
+    error = std::make_error_code(std::errc::operation_not_supported);
+#endif
+    return error;
+}
+
+bool DuplicateFinder::linkDuplicate(const std::string& original, const std::string& duplicate) {
+    static std::atomic<std::uint64_t> sequence(0);
+    std::uint64_t stamp = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    
+    std::string temp;
+    std::error_code error;
+    for (int attempt = 0; attempt < 100; ++attempt) {
+        temp = duplicate + ".sfm-link-" + std::to_string(stamp + sequence.fetch_add(1, std::memory_order_relaxed));
+        error = createLink(original, duplicate, temp);
+        if (error != std::errc::file_exists) break;
+    }
+    
+    if (!error) {
+        fs::rename(temp, duplicate, error);
+        if (error) {
+            std::error_code ignored;
+            fs::remove(temp, ignored);
+        }
+    }
+    
+    if (error) {
+        fail(duplicate, error);
+        return false;
+    }
+    return true;
+}
+
+void DuplicateFinder::replaceWithLinks() {
+    for (const auto& group : summary.groups) {
+        const std::string& original = group.paths.front();
+        for (std::size_t i = 1; i < group.paths.size(); ++i) {
+            if (!sameContent(original, group.paths[i])) continue;
+            if (linkDuplicate(original, group.paths[i])) {
+                ++summary.linked;
+                summary.reclaimedBytes += group.size;
+            }
+        }
+    }
+}
+
+DupeSummary DuplicateFinder::find(const fs::path& root) {
+    summary = DupeSummary();
+    errors = 0;
+    
+    std::vector<Candidate> files = collect(root);
+    summary.files = files.size();
+    
+    std::vector<std::vector<Candidate>> groups = sizeGroups(files);
+    files.clear();
+    files.shrink_to_fit();
+    
+    hashGroups(groups, false);
+    hashGroups(groups, true);
+    
+    for (auto& group : groups) {
+        DuplicateGroup result;
+        result.size = group.front().size;
+        for (auto& candidate : group) {
+            result.paths.push_back(std::move(candidate.path));
+        }
+        std::sort(result.paths.begin(), result.paths.end());
+        summary.wastedBytes += result.size * (result.paths.size() - 1);
+        summary.groups.push_back(std::move(result));
+    }
+    
+    std::sort(summary.groups.begin(), summary.groups.end(), [](const DuplicateGroup& a, const DuplicateGroup& b) {
+        std::uintmax_t wastedA = a.size * (a.paths.size() - 1);
+        std::uintmax_t wastedB = b.size * (b.paths.size() - 1);
+        if (wastedA != wastedB) return wastedA > wastedB;
+        return a.paths.front() < b.paths.front();
+    });
+    
+    if (options.link != LinkMode::None) {
+        replaceWithLinks();
+    }
+    
+    summary.errors = errors.load();
+    return summary;
+}
@@ -0,0 +1,80 @@
+#ifndef DUPLICATE_FINDER_H
+#define DUPLICATE_FINDER_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+enum class LinkMode {
+    None,
+    Hard,
+    Reflink
+};
+
+struct DupeOptions {
+    unsigned threads = 0;
+    std::uintmax_t minSize = 1;
+    std::size_t edgeBytes = 4096;
+    LinkMode link = LinkMode::None;
+};
+
+struct DuplicateGroup {
+    std::uintmax_t size = 0;
+    std::vector<std::string> paths;
+};
+
+struct DupeSummary {
+    std::uint64_t files = 0;
+    std::uint64_t hardlinksSkipped = 0;
+    std::uint64_t partialHashed = 0;
+    std::uint64_t fullHashed = 0;
+    std::vector<DuplicateGroup> groups;
+    std::uintmax_t wastedBytes = 0;
+    std::uint64_t linked = 0;
+    std::uintmax_t reclaimedBytes = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class DuplicateFinder {
+private:
+    struct Candidate {
+        std::string path;
+        std::uintmax_t size;
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::uint64_t hash;
+        bool failed;
+    };
+    
+    DupeOptions options;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    DupeSummary summary;
+    
+    std::vector<Candidate> collect(const fs::path& root);
+    std::vector<std::vector<Candidate>> sizeGroups(std::vector<Candidate>& files);
+    void hashGroups(std::vector<std::vector<Candidate>>& groups, bool full);
+    void replaceWithLinks();
+    bool hashFile(Candidate& candidate, bool full);
+    bool sameContent(const std::string& first, const std::string& second);
+    std::error_code createLink(const std::string& original, const std::string& duplicate, const std::string& temp) const;
+    bool linkDuplicate(const std::string& original, const std::string& duplicate);
+    void fail(const std::string& path, const std::error_code& error);
+    
+    static std::vector<std::vector<Candidate>> splitByHash(std::vector<Candidate>& group);
+    
+public:
+    explicit DuplicateFinder(const DupeOptions& options = DupeOptions());
+    
+    DupeSummary find(const fs::path& root);
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "FileCopier.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <system_error>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/fs.h>
+#endif
+
+std::string FileCopier::methodName(CopyMethod method) {
+    switch (method) {
+        case CopyMethod::Reflink: return "reflink";
+        case CopyMethod::CopyFileRange: return "copy_file_range";
+        case CopyMethod::SendFile: return "sendfile";
+        case CopyMethod::ReadWrite: return "read/write";
+        default: return "std::filesystem";
+    }
+}
+
+#ifdef OS_LINUX
+namespace {
+
+struct Range {
+    off_t offset;
+    off_t length;
+};
+
+[[noreturn]] void throwError(const std::string& what, const fs::path& source, const fs::path& dest, int error) {
+    throw fs::filesystem_error(what, source, dest, std::error_code(error, std::generic_category()));
+}
+
+bool isFallbackError(int error) {
+    return error == ENOSYS || error == EXDEV || error == EINVAL || error == EOPNOTSUPP || error == ETXTBSY;
+}
+
+std::vector<Range> dataRanges(int fd, off_t size, bool sparse) {
+    std::vector<Range> ranges;
+    if (!sparse) {
+        ranges.push_back({0, size});
+        return ranges;
+    }
+    
+    off_t offset = 0;
+    while (offset < size) {
+        off_t dataStart = ::lseek(fd, offset, SEEK_DATA);
+        if (dataStart < 0) {
+            if (errno == ENXIO) break;
+            ranges.assign(1, Range{0, size});
+            return ranges;
+        }
+        
+        off_t dataEnd = ::lseek(fd, dataStart, SEEK_HOLE);
+        if (dataEnd < 0 || dataEnd > size) dataEnd = size;
+        
+        ranges.push_back({dataStart, dataEnd - dataStart});
+        offset = dataEnd;
+    }
+    
+    return ranges;
+}
+
+std::vector<Range> splitRanges(const std::vector<Range>& ranges, off_t chunkSize) {
+    std::vector<Range> chunks;
+    for (const auto& range : ranges) {
+        for (off_t offset = 0; offset < range.length; offset += chunkSize) {
+            chunks.push_back({range.offset + offset, std::min(chunkSize, range.length - offset)});
+        }
+    }
+    return chunks;
+}
+
+int readWriteRange(int in, int out, off_t offset, off_t length) {
+    std::vector<char> buffer(static_cast<std::size_t>(std::min<off_t>(length, 1 << 20)));
+    off_t end = offset + length;
+    
+    while (offset < end) {
+        std::size_t toRead = static_cast<std::size_t>(std::min<off_t>(end - offset, buffer.size()));
+        ssize_t readBytes = ::pread(in, buffer.data(), toRead, offset);
+        if (readBytes < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (readBytes == 0) break;
+        
+        ssize_t written = 0;
+        while (written < readBytes) {
+            ssize_t n = ::pwrite(out, buffer.data() + written, readBytes - written, offset + written);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            written += n;
+        }
+        offset += readBytes;
+    }
+    
+    return 0;
+}
+
+int copyRange(int in, int out, Range range, bool positional, CopyMethod& method) {
+    off_t end = range.offset + range.length;
+    off_t offset = range.offset;
+    
+    while (offset < end && method == CopyMethod::CopyFileRange) {
+        loff_t inOffset = offset;
+        loff_t outOffset = offset;
+        ssize_t n = ::copy_file_range(in, &inOffset, out, &outOffset, static_cast<std::size_t>(end - offset), 0);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (!isFallbackError(errno)) return errno;
+            method = positional ? CopyMethod::ReadWrite : CopyMethod::SendFile;
+            break;
+        }
+        if (n == 0) return 0;
+        offset += n;
+    }
+    
+    if (offset < end && method == CopyMethod::SendFile) {
+        if (::lseek(out, offset, SEEK_SET) < 0) return errno;
+        
+        while (offset < end) {
+            off_t inOffset = offset;
+            ssize_t n = ::sendfile(out, in, &inOffset, static_cast<std::size_t>(end - offset));
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EINVAL && errno != ENOSYS) return errno;
+                method = CopyMethod::ReadWrite;
+                break;
+            }
+            if (n == 0) return 0;
+            offset += n;
+        }
+    }
+    
+    if (offset < end) {
+        return readWriteRange(in, out, offset, end - offset);
+    }
+    
+    return 0;
+}
+
+}
+#endif
+
+CopyResult FileCopier::copyFile(const fs::path& source, const fs::path& dest, const CopyOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("copy.file");
+    MetricTimer timer(latency);
+    
+    CopyResult result = copyData(source, dest, options);
+    Metrics::add(MetricCounter::FilesCopied);
+    Metrics::add(MetricCounter::BytesRead, result.bytesCopied);
+    Metrics::add(MetricCounter::BytesWritten, result.bytesCopied);
+    return result;
+}
+
+CopyResult FileCopier::copyData(const fs::path& source, const fs::path& dest, const CopyOptions& options) {
+    CopyResult result;
+    
+#ifdef OS_LINUX
+    FileDescriptor in(::open(source.c_str(), O_RDONLY | O_CLOEXEC));
+    if (in.get() < 0) throwError("cannot open source file", source, dest, errno);
+    
+    struct stat sourceStat;
+    if (::fstat(in.get(), &sourceStat) != 0) throwError("cannot stat source file", source, dest, errno);
+    
+    if (!S_ISREG(sourceStat.st_mode)) {
+        fs::copy_file(source, dest, fs::copy_options::overwrite_existing);
+        return result;
+    }
+    
+    struct stat destStat;
+    if (::stat(dest.c_str(), &destStat) == 0 &&
+        destStat.st_dev == sourceStat.st_dev && destStat.st_ino == sourceStat.st_ino) {
+        throwError("source and destination are the same file", source, dest, EEXIST);
+    }
+    
+    mode_t mode = sourceStat.st_mode & 07777;
+    FileDescriptor out(::open(dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode));
+    if (out.get() < 0) throwError("cannot open destination file", source, dest, errno);
+    
+    off_t size = sourceStat.st_size;
+    
+    if (options.reflink && size > 0 && ::ioctl(out.get(), FICLONE, in.get()) == 0) {
+        result.method = CopyMethod::Reflink;
+        result.bytesCopied = static_cast<std::uintmax_t>(size);
+        ::fchmod(out.get(), mode);
+        return result;
+    }
+    
+    if (::ftruncate(out.get(), size) != 0) throwError("cannot resize destination file", source, dest, errno);
+    
+    std::vector<Range> ranges = dataRanges(in.get(), size, options.sparse);
+    off_t dataBytes = 0;
+    for (const auto& range : ranges) dataBytes += range.length;
+    
+    result.method = CopyMethod::CopyFileRange;
+    result.bytesCopied = static_cast<std::uintmax_t>(dataBytes);
+    result.holesSkipped = static_cast<std::uintmax_t>(size - dataBytes);
+    
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    
+    if (static_cast<std::uintmax_t>(size) < options.parallelThreshold || threads == 1) {
+        CopyMethod method = CopyMethod::CopyFileRange;
+        for (const auto& range : ranges) {
+            int error = copyRange(in.get(), out.get(), range, false, method);
+            if (error != 0) throwError("cannot copy file data", source, dest, error);
+        }
+        result.method = method;
+    } else {
+        off_t chunkSize = static_cast<off_t>(std::max<std::uintmax_t>(options.chunkSize, 1 << 20));
+        std::vector<Range> chunks = splitRanges(ranges, chunkSize);
+        threads = static_cast<unsigned>(std::min<std::size_t>(threads, chunks.size()));
+        
+        std::atomic<std::size_t> nextChunk(0);
+        std::atomic<int> firstError(0);
+        std::mutex methodMutex;
+        std::vector<std::thread> workers;
+        
+        for (unsigned i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                CopyMethod method = CopyMethod::CopyFileRange;
+                std::size_t index;
+                while (firstError == 0 && (index = nextChunk++) < chunks.size()) {
+                    int error = copyRange(in.get(), out.get(), chunks[index], true, method);
+                    if (error != 0) {
+                        int expected = 0;
+                        firstError.compare_exchange_strong(expected, error);
+                    }
+                }
+                
+                std::lock_guard<std::mutex> lock(methodMutex);
+                result.method = std::max(result.method, method);
+            });
+        }
+        
+        for (auto& worker : workers) worker.join();
+        
+        if (firstError != 0) throwError("cannot copy file data", source, dest, firstError);
+        result.threadsUsed = threads;
+    }
+    
+    ::fchmod(out.get(), mode);
+#else
+    fs::copy_file(source, dest, fs::copy_options::overwrite_existing);
+    result.bytesCopied = fs::file_size(dest);
+#endif
+    
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef FILE_COPIER_H
+#define FILE_COPIER_H
+
+#include <filesystem>
+#include <cstdint>
+#include <string>
+
+namespace fs = std::filesystem;
+
+enum class CopyMethod {
+    Reflink,
+    CopyFileRange,
+    SendFile,
+    ReadWrite,
+    Standard
+};
+
+struct CopyOptions {
+    std::uintmax_t parallelThreshold = 256ull * 1024 * 1024;
+    std::uintmax_t chunkSize = 64ull * 1024 * 1024;
+    unsigned threads = 0;
+    bool reflink = true;
+    bool sparse = true;
+};
+
+struct CopyResult {
+    CopyMethod method = CopyMethod::Standard;
+    std::uintmax_t bytesCopied = 0;
+    std::uintmax_t holesSkipped = 0;
+    unsigned threadsUsed = 1;
+};
+
+class FileCopier {
+private:
+    static CopyResult copyData(const fs::path& source, const fs::path& dest, const CopyOptions& options);
+    
+public:
+    static CopyResult copyFile(const fs::path& source, const fs::path& dest, const CopyOptions& options = CopyOptions());
+    static std::string methodName(CopyMethod method);
+};
+
+#endif
@@ -0,0 +1,513 @@
+#include "FileEngine.h"
+#include "FileCopier.h"
+#include "DirectoryWalker.h"
+#include "Metrics.h"
+#include <atomic>
+#include <algorithm>
+
+namespace {
+
+template <typename Summary>
+void recordError(Summary& summary, const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (summary.errors++ == 0) {
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+}
+
+FileEngine::FileEngine(std::size_t cacheLimit) : cache(cacheLimit) {
+}
+
+ListSummary FileEngine::list(const fs::path& dir, const ListOptions& options, const EntryVisitor& visitor) {
+    static LatencyHistogram& latency = Metrics::histogram("ls.list");
+    MetricTimer timer(latency);
+    
+    ListOptions effective = options;
+    if (!effective.cache) effective.cache = &cache;
+    
+    ListSummary summary;
+    try {
+        DirectoryLister lister(dir, effective);
+        summary = lister.visit(visitor);
+    } catch (const fs::filesystem_error& e) {
+        recordError(summary, dir.string(), e.code());
+        return summary;
+    }
+    
+    Metrics::add(MetricCounter::EntriesVisited, summary.entries);
+    Metrics::add(MetricCounter::StatCalls, summary.statCalls);
+    Metrics::add(MetricCounter::Errors, summary.errors);
+    return summary;
+}
+
+TreeCopySummary FileEngine::copy(const fs::path& source, const fs::path& dest, const TreeCopyOptions& options) {
+    TreeCopySummary summary;
+    std::error_code error;
+    
+    fs::file_status status = fs::status(source, error);
+    if (error) {
+        recordError(summary, source.string(), error);
+        return summary;
+    }
+    
+    if (!fs::is_directory(status)) {
+        try {
+            CopyResult result = FileCopier::copyFile(source, dest);
+            summary.files = 1;
+            summary.bytesCopied = result.bytesCopied;
+        } catch (const fs::filesystem_error& e) {
+            recordError(summary, dest.string(), e.code());
+        }
+        return summary;
+    }
+    
+    fs::file_status destStatus = fs::status(dest, error);
+    if (!fs::exists(destStatus)) {
+        error.clear();
+        fs::create_directories(dest, error);
+    } else if (!fs::is_directory(destStatus)) {
+        error = std::make_error_code(std::errc::not_a_directory);
+    }
+    if (error) {
+        recordError(summary, dest.string(), error);
+        return summary;
+    }
+    
+    static LatencyHistogram& latency = Metrics::histogram("cp.tree");
+    MetricTimer timer(latency);
+    TreeCopier copier(options);
+    return copier.copy(source, dest);
+}
+
+MoveSummary FileEngine::move(const fs::path& source, const fs::path& dest, const MoveOptions& options) {
+    MoveSummary summary;
+    std::error_code error;
+    
+    fs::rename(source, dest, error);
+    if (error == std::errc::cross_device_link) {
+        static LatencyHistogram& latency = Metrics::histogram("mv.move");
+        MetricTimer timer(latency);
+        TreeMover mover(options);
+        summary = mover.move(source, dest);
+        summary.crossDevice = true;
+    } else if (error) {
+        recordError(summary, source.string(), error);
+    }
+    return summary;
+}
+
+RemoveSummary FileEngine::remove(const fs::path& path, const RemoveOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("rm.remove");
+    MetricTimer timer(latency);
+    
+    RemoveSummary summary;
+    std::error_code error;
+    
+    fs::file_status status = fs::symlink_status(path, error);
+    if (error) {
+        recordError(summary, path.string(), error);
+        return summary;
+    }
+    
+    if (fs::is_directory(status)) {
+        TreeRemover remover(options);
+        summary = remover.remove(path);
+    } else if (fs::remove(path, error)) {
+        summary.removed = 1;
+    } else {
+        recordError(summary, path.string(), error ? error : std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+    
+    Metrics::add(MetricCounter::EntriesRemoved, summary.removed);
+    return summary;
+}
+
+SyncSummary FileEngine::sync(const fs::path& source, const fs::path& dest, const SyncOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("sync.run");
+    MetricTimer timer(latency);
+    TreeSyncer syncer(options);
+    return syncer.sync(source, dest);
+}
+
+PackSummary FileEngine::pack(const fs::path& root, const fs::path& archive, const PackOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("pack.run");
+    MetricTimer timer(latency);
+    TarPacker packer(options);
+    PackSummary summary = packer.pack(root, archive);
+    Metrics::add(MetricCounter::FilesCopied, summary.files);
+    return summary;
+}
+
+UnpackSummary FileEngine::unpack(const fs::path& archive, const fs::path& dest, const UnpackOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("unpack.run");
+    MetricTimer timer(latency);
+    TarUnpacker unpacker(options);
+    UnpackSummary summary = unpacker.unpack(archive, dest);
+    Metrics::add(MetricCounter::FilesCopied, summary.files);
+    return summary;
+}
+
+MakeDirectorySummary FileEngine::makeDirectory(const fs::path& path) {
+    MakeDirectorySummary summary;
+    std::error_code error;
+    
+    summary.created = fs::create_directories(path, error);
+    if (error) {
+        recordError(summary, path.string(), error);
+    }
+    return summary;
+}
+
+bool FileEngine::walkCached(const std::string& dir, const std::function<bool(const std::string& dir, const ListEntry& entry)>& visitor,
+                            const ErrorCallback& onError) {
+    std::uint64_t entries = 0;
+    bool proceed = true;
+    
+    try {
+        ListOptions options;
+        options.threads = 1;
+        options.sort = ListSort::None;
+        options.cache = &cache;
+        options.fillCache = false;
+        
+        DirectoryLister lister(dir, options);
+        ListSummary summary = lister.visit([&](const ListEntry& entry) {
+            ++entries;
+            if (!visitor(dir, entry)) {
+                proceed = false;
+            } else if (entry.type == EntryType::Directory && !walkCached(joinPath(dir, entry.name), visitor, onError)) {
+                proceed = false;
+            }
+            return proceed;
+        }, true);
+        
+        if (!summary.cached) Metrics::add(MetricCounter::DirectoryReads);
+        Metrics::add(MetricCounter::StatCalls, summary.statCalls);
+    } catch (const fs::filesystem_error& e) {
+        onError(dir, e.code());
+    }
+    
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+    return proceed;
+}
+
+FileIndex* FileEngine::loadIndex(const fs::path& dir) {
+    fs::path current = dir;
+    
+    while (true) {
+        std::string key = current.string();
+        auto loaded = indexes.find(key);
+        if (loaded != indexes.end()) {
+            return loaded->second->covers(dir) ? loaded->second.get() : nullptr;
+        }
+        
+        fs::path location = FileIndex::defaultLocation(current);
+        if (fs::exists(location)) {
+            std::unique_ptr<FileIndex> index;
+            try {
+                index = std::make_unique<FileIndex>(location);
+            } catch (const fs::filesystem_error&) {
+                return nullptr;
+            }
+            FileIndex* result = index.get();
+            indexes[key] = std::move(index);
+            return result->covers(dir) ? result : nullptr;
+        }
+        
+        if (!current.has_relative_path()) break;
+        current = current.parent_path();
+    }
+    
+    return nullptr;
+}
+
+FindSummary FileEngine::find(const fs::path& dir, const std::vector<std::string>& patterns, const FindOptions& options, const MatchVisitor& onMatch) {
+    static LatencyHistogram& latency = Metrics::histogram("find.search");
+    MetricTimer timer(latency);
+    
+    GlobMatcher matcher(patterns);
+    FindSummary summary;
+    std::mutex errorMutex;
+    std::atomic<std::uint64_t> found(0);
+    
+    auto record = [&](std::string_view directory, std::string_view name, unsigned worker) {
+        std::uint64_t index = found.fetch_add(1, std::memory_order_relaxed);
+        if (options.limit != 0 && index >= options.limit) return false;
+        return onMatch(directory, name, worker) && (options.limit == 0 || index + 1 < options.limit);
+    };
+    
+    auto onError = [&](const std::string& path, const std::error_code& error) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        recordError(summary, path, error);
+        if (options.onError) options.onError(path, error);
+    };
+    
+    if (options.useIndex) {
+        std::error_code error;
+        fs::path root = fs::weakly_canonical(dir, error);
+        
+        std::vector<std::string> paths;
+        
+        {
+            std::lock_guard<std::mutex> lock(indexMutex);
+            try {
+                FileIndex* index = error ? nullptr : loadIndex(root);
+                if (index) {
+                    summary.indexed = true;
+                    index->query(root, matcher, [&](const std::string& path) {
+                        if (options.limit == 0 || paths.size() < options.limit) paths.push_back(path);
+                    });
+                }
+            } catch (const fs::filesystem_error& e) {
+                onError(e.path1().string(), e.code());
+                summary.indexed = false;
+                paths.clear();
+            }
+        }
+        
+        const char separator = static_cast<char>(fs::path::preferred_separator);
+        for (const auto& path : paths) {
+            std::string_view view(path);
+            std::size_t split = view.rfind(separator);
+            bool proceed = split == std::string_view::npos
+                ? record(std::string_view(), view, 0)
+                : record(view.substr(0, split == 0 ? 1 : split), view.substr(split + 1), 0);
+            if (!proceed) break;
+        }
+    }
+    
+    if (!summary.indexed) {
+        if (options.threads == 1) {
+            walkCached(dir.string(), [&](const std::string& directory, const ListEntry& entry) {
+                return !matcher.matches(entry.name) || record(directory, entry.name, 0);
+            }, onError);
+        } else {
+            DirectoryWalker walker(options.threads);
+            walker.walk(dir,
+                [&](const WalkEntry& entry) {
+                    std::string_view name(entry.name, entry.nameLength);
+                    if (matcher.matches(name) && !record(entry.directory, name, entry.worker)) {
+                        walker.stop();
+                        return false;
+                    }
+                    return true;
+                },
+                [&](const std::string& directory, const std::error_code& error, unsigned) {
+                    onError(directory, error);
+                });
+        }
+    }
+    
+    summary.matches = found.load();
+    if (options.limit != 0 && summary.matches >= options.limit) {
+        summary.matches = options.limit;
+        summary.limited = true;
+    }
+    return summary;
+}
+
+FindSummary FileEngine::find(const fs::path& dir, const FindQuery& query, const FindOptions& options, const MatchVisitor& onMatch) {
+    static LatencyHistogram& latency = Metrics::histogram("find.query");
+    MetricTimer timer(latency);
+    
+    FindSummary summary;
+    std::mutex errorMutex;
+    std::atomic<std::uint64_t> found(0);
+    
+    const char separator = static_cast<char>(fs::path::preferred_separator);
+    std::string root = dir.string();
+    while (root.size() > 1 && root.back() == separator) root.pop_back();
+    
+    auto depthOf = [&](const std::string& directory) {
+        if (directory.size() <= root.size()) return std::size_t(1);
+        std::size_t start = root.size() == 1 ? 0 : root.size();
+        return std::size_t(1) + static_cast<std::size_t>(std::count(directory.begin() + start, directory.end(), separator));
+    };
+    
+    if (query.maxDepth() == 0) return summary;
+    
+    DirectoryWalker walker(options.threads);
+    walker.walk(root,
+        [&](const WalkEntry& entry) {
+            std::string_view name(entry.name, entry.nameLength);
+            bool directory = entry.type == EntryType::Directory;
+            if (directory && query.prunes(name)) return false;
+            
+            std::size_t depth = query.limitsDepth() ? depthOf(entry.directory) : 1;
+            if (depth > query.maxDepth()) return false;
+            if (depth >= query.minDepth() && query.matches(entry)) {
+                std::uint64_t index = found.fetch_add(1, std::memory_order_relaxed);
+                if ((options.limit != 0 && index >= options.limit) || !onMatch(entry.directory, name, entry.worker) ||
+                    (options.limit != 0 && index + 1 >= options.limit)) {
+                    walker.stop();
+                    return false;
+                }
+            }
+            return depth < query.maxDepth();
+        },
+        [&](const std::string& directory, const std::error_code& error, unsigned) {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            recordError(summary, directory, error);
+            if (options.onError) options.onError(directory, error);
+        });
+    
+    summary.matches = found.load();
+    if (options.limit != 0 && summary.matches >= options.limit) {
+        summary.matches = options.limit;
+        summary.limited = true;
+    }
+    return summary;
+}
+
+SearchSummary FileEngine::grep(const fs::path& dir, const std::string& pattern, const std::vector<std::string>& includes,
+                               const SearchOptions& options, const ErrorCallback& onError) {
+    static LatencyHistogram& latency = Metrics::histogram("grep.search");
+    
+    GlobMatcher matcher(includes.empty() ? std::vector<std::string>{"*"} : includes);
+    ContentSearcher searcher(pattern, options);
+    MetricTimer timer(latency);
+    
+    std::mutex errorMutex;
+    auto reportError = [&](const std::string& directory, const std::error_code& error) {
+        Metrics::add(MetricCounter::Errors);
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (onError) onError(directory, error);
+    };
+    
+    if (options.threads == 1) {
+        walkCached(dir.string(), [&](const std::string& directory, const ListEntry& entry) {
+            if ((entry.type == EntryType::File || entry.type == EntryType::Unknown) && matcher.matches(entry.name)) {
+                searcher.submit(joinPath(directory, entry.name));
+            }
+            return true;
+        }, reportError);
+    } else {
+        DirectoryWalker walker(options.threads);
+        walker.walk(dir,
+            [&](const WalkEntry& entry) {
+                if ((entry.type == EntryType::File || entry.type == EntryType::Unknown) &&
+                    matcher.matches(std::string_view(entry.name, entry.nameLength))) {
+                    searcher.submit(entry.path());
+                }
+                return true;
+            },
+            [&](const std::string& directory, const std::error_code& error, unsigned) {
+                reportError(directory, error);
+            });
+    }
+    
+    return searcher.finish();
+}
+
+DupeSummary FileEngine::findDuplicates(const fs::path& dir, const DupeOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("dupes.search");
+    MetricTimer timer(latency);
+    DuplicateFinder finder(options);
+    return finder.find(dir);
+}
+
+DiskUsageSummary FileEngine::diskUsage(const fs::path& dir, const DiskUsageOptions& options) {
+    static LatencyHistogram& latency = Metrics::histogram("du.scan");
+    MetricTimer timer(latency);
+    
+    std::lock_guard<std::mutex> lock(usageMutex);
+    DiskUsageOptions effective = options;
+    if (!effective.cache) effective.cache = &usageCache;
+    
+    DiskUsageScanner scanner(effective);
+    return scanner.scan(dir);
+}
+
+IndexSummary FileEngine::buildIndex(const fs::path& dir, unsigned threads) {
+    IndexSummary summary;
+    std::error_code error;
+    
+    fs::path root = fs::weakly_canonical(dir, error);
+    if (error) {
+        recordError(summary, dir.string(), error);
+        return summary;
+    }
+    
+    fs::path location = FileIndex::defaultLocation(root);
+    summary.location = location.string();
+    
+    std::lock_guard<std::mutex> lock(indexMutex);
+    indexes.erase(root.string());
+    try {
+        summary.stats = FileIndex::build(root, location, threads);
+    } catch (const fs::filesystem_error& e) {
+        recordError(summary, e.path1().string(), e.code());
+    }
+    return summary;
+}
+
+IndexSummary FileEngine::updateIndex(const fs::path& dir) {
+    IndexSummary summary;
+    std::error_code error;
+    
+    fs::path root = fs::weakly_canonical(dir, error);
+    if (error) {
+        recordError(summary, dir.string(), error);
+        return summary;
+    }
+    
+    fs::path location = FileIndex::defaultLocation(root);
+    summary.location = location.string();
+    
+    std::lock_guard<std::mutex> lock(indexMutex);
+    try {
+        auto loaded = indexes.find(root.string());
+        if (loaded == indexes.end()) {
+            if (!fs::exists(location)) {
+                recordError(summary, root.string(), std::make_error_code(std::errc::no_such_file_or_directory));
+                return summary;
+            }
+            loaded = indexes.emplace(root.string(), std::make_unique<FileIndex>(location)).first;
+        }
+        
+        summary.changedDirectories = loaded->second->refresh();
+        summary.stats = loaded->second->save();
+    } catch (const fs::filesystem_error& e) {
+        recordError(summary, e.path1().string(), e.code());
+    }
+    return summary;
+}
+
+IndexSummary FileEngine::dropIndex(const fs::path& dir) {
+    IndexSummary summary;
+    std::error_code error;
+    
+    fs::path root = fs::weakly_canonical(dir, error);
+    if (error) {
+        recordError(summary, dir.string(), error);
+        return summary;
+    }
+    
+    fs::path location = FileIndex::defaultLocation(root);
+    summary.location = location.string();
+    
+    std::lock_guard<std::mutex> lock(indexMutex);
+    indexes.erase(root.string());
+    if (!fs::remove(location, error)) {
+        recordError(summary, root.string(), error ? error : std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+    return summary;
+}
+
+CacheStats FileEngine::cacheStats() const {
+    return cache.stats();
+}
+
+void FileEngine::clearCache() {
+    cache.clear();
+    
+    std::lock_guard<std::mutex> lock(usageMutex);
+    usageCache.clear();
+}
+
+void FileEngine::setCacheLimit(std::size_t limit) {
+    cache.setMemoryLimit(limit);
+}
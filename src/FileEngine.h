@@ -0,0 +1,111 @@
+#ifndef FILE_ENGINE_H
+#define FILE_ENGINE_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+#include <system_error>
+#include "DirectoryLister.h"
+#include "DirectoryCache.h"
+#include "TreeCopier.h"
+#include "TreeMover.h"
+#include "TreeRemover.h"
+#include "TreeSyncer.h"
+#include "TarArchive.h"
+#include "DiskUsage.h"
+#include "ContentSearcher.h"
+#include "DuplicateFinder.h"
+#include "FileIndex.h"
+#include "GlobMatcher.h"
+#include "FindQuery.h"
+
+namespace fs = std::filesystem;
+
+using ErrorCallback = std::function<void(const std::string& path, const std::error_code& error)>;
+
+struct MakeDirectorySummary {
+    bool created = false;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+struct FindOptions {
+    unsigned threads = 0;
+    bool useIndex = true;
+    std::uint64_t limit = 0;
+    ErrorCallback onError;
+};
+
+struct FindSummary {
+    std::uint64_t matches = 0;
+    bool limited = false;
+    bool indexed = false;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+struct IndexSummary {
+    IndexStats stats;
+    std::size_t changedDirectories = 0;
+    std::string location;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class FileEngine {
+public:
+    using EntryVisitor = std::function<bool(const ListEntry& entry)>;
+    using MatchVisitor = std::function<bool(std::string_view directory, std::string_view name, unsigned worker)>;
+    
+private:
+    DirectoryCache cache;
+    std::mutex indexMutex;
+    std::map<std::string, std::unique_ptr<FileIndex>> indexes;
+    std::mutex usageMutex;
+    DiskUsageCache usageCache;
+    
+    FileIndex* loadIndex(const fs::path& dir);
+    bool walkCached(const std::string& dir, const std::function<bool(const std::string& dir, const ListEntry& entry)>& visitor,
+                    const ErrorCallback& onError);
+    
+public:
+    explicit FileEngine(std::size_t cacheLimit = 64 * 1024 * 1024);
+    
+    FileEngine(const FileEngine&) = delete;
+    FileEngine& operator=(const FileEngine&) = delete;
+    
+    ListSummary list(const fs::path& dir, const ListOptions& options, const EntryVisitor& visitor);
+    TreeCopySummary copy(const fs::path& source, const fs::path& dest, const TreeCopyOptions& options = TreeCopyOptions());
+    MoveSummary move(const fs::path& source, const fs::path& dest, const MoveOptions& options = MoveOptions());
+    RemoveSummary remove(const fs::path& path, const RemoveOptions& options = RemoveOptions());
+    SyncSummary sync(const fs::path& source, const fs::path& dest, const SyncOptions& options = SyncOptions());
+    MakeDirectorySummary makeDirectory(const fs::path& path);
+    PackSummary pack(const fs::path& root, const fs::path& archive, const PackOptions& options = PackOptions());
+    UnpackSummary unpack(const fs::path& archive, const fs::path& dest, const UnpackOptions& options = UnpackOptions());
+    
+    FindSummary find(const fs::path& dir, const std::vector<std::string>& patterns, const FindOptions& options, const MatchVisitor& onMatch);
+    FindSummary find(const fs::path& dir, const FindQuery& query, const FindOptions& options, const MatchVisitor& onMatch);
+    SearchSummary grep(const fs::path& dir, const std::string& pattern, const std::vector<std::string>& includes,
+                       const SearchOptions& options, const ErrorCallback& onError = ErrorCallback());
+    DupeSummary findDuplicates(const fs::path& dir, const DupeOptions& options = DupeOptions());
+    DiskUsageSummary diskUsage(const fs::path& dir, const DiskUsageOptions& options = DiskUsageOptions());
+    
+    IndexSummary buildIndex(const fs::path& dir, unsigned threads = 0);
+    IndexSummary updateIndex(const fs::path& dir);
+    IndexSummary dropIndex(const fs::path& dir);
+    
+    CacheStats cacheStats() const;
+    void clearCache();
+    void setCacheLimit(std::size_t limit);
+};
+
+#endif
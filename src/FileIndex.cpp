@@ -0,0 +1,895 @@
+#include "FileIndex.h"
+#include <fstream>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include <cstdlib>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+const char indexMagic[8] = {'S', 'F', 'M', 'I', 'D', 'X', '1', '\0'};
+const std::uint32_t noParent = 0xFFFFFFFFu;
+
+struct IndexHeader {
+    char magic[8];
+    std::uint64_t dirCount;
+    std::uint64_t entryCount;
+    std::uint64_t trigramCount;
+    std::uint64_t dirsOffset;
+    std::uint64_t entriesOffset;
+    std::uint64_t trigramsOffset;
+    std::uint64_t postingsOffset;
+    std::uint64_t namesOffset;
+    std::uint64_t namesSize;
+};
+
+struct DirRecord {
+    std::uint32_t parent;
+    std::uint32_t pathLength;
+    std::uint64_t pathOffset;
+    std::int64_t mtime;
+};
+
+struct EntryRecord {
+    std::uint64_t nameOffset;
+    std::uint32_t dir;
+    std::uint16_t nameLength;
+    std::uint8_t type;
+    std::uint8_t reserved;
+};
+
+struct TrigramRecord {
+    std::uint32_t trigram;
+    std::uint32_t count;
+    std::uint64_t offset;
+};
+
+struct BuildDir {
+    std::string path;
+    std::uint32_t parent;
+    std::int64_t mtime;
+};
+
+struct BuildEntry {
+    std::uint32_t dir;
+    std::string name;
+    EntryType type;
+};
+
+std::int64_t directoryMtime(const std::string& path, bool& exists) {
+#ifdef OS_LINUX
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        exists = false;
+        return 0;
+    }
+    exists = true;
+    return static_cast<std::int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#else
+    std::error_code error;
+    exists = fs::is_directory(path, error);
+    if (!exists) return 0;
+    return static_cast<std::int64_t>(fs::last_write_time(path, error).time_since_epoch().count());
+#endif
+}
+
+std::uint32_t packTrigram(const char* text) {
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(text[0])) << 16) |
+           (static_cast<std::uint32_t>(static_cast<unsigned char>(text[1])) << 8) |
+           static_cast<std::uint32_t>(static_cast<unsigned char>(text[2]));
+}
+
+void collectTrigrams(std::string_view text, std::vector<std::uint32_t>& trigrams) {
+    for (std::size_t i = 0; i + 3 <= text.size(); ++i) {
+        trigrams.push_back(packTrigram(text.data() + i));
+    }
+}
+
+void uniqueSorted(std::vector<std::uint32_t>& values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+}
+
+std::uint64_t alignUp(std::uint64_t value) {
+    return (value + 7) & ~std::uint64_t(7);
+}
+
+bool sectionFits(std::uint64_t offset, std::uint64_t count, std::uint64_t size, std::uint64_t limit) {
+    return offset % 8 == 0 && offset <= limit && count <= (limit - offset) / size;
+}
+
+bool indexIsConsistent(const char* data, std::size_t dataSize, const IndexHeader& header) {
+    if (header.dirCount == 0 || header.dirCount >= noParent || header.entryCount > noParent) return false;
+    if (header.namesOffset > dataSize || header.namesSize > dataSize - header.namesOffset) return false;
+    if (header.postingsOffset % 8 != 0 || header.postingsOffset > header.namesOffset) return false;
+    if (!sectionFits(header.dirsOffset, header.dirCount, sizeof(DirRecord), header.postingsOffset) ||
+        !sectionFits(header.entriesOffset, header.entryCount, sizeof(EntryRecord), header.postingsOffset) ||
+        !sectionFits(header.trigramsOffset, header.trigramCount, sizeof(TrigramRecord), header.postingsOffset)) {
+        return false;
+    }
+    
+    const auto* dirs = reinterpret_cast<const DirRecord*>(data + header.dirsOffset);
+    for (std::uint64_t i = 0; i < header.dirCount; ++i) {
+        if (dirs[i].pathOffset > header.namesSize || dirs[i].pathLength > header.namesSize - dirs[i].pathOffset) return false;
+        if (i == 0 ? dirs[i].parent != noParent : dirs[i].parent != noParent && dirs[i].parent >= i) return false;
+    }
+    
+    const auto* entries = reinterpret_cast<const EntryRecord*>(data + header.entriesOffset);
+    for (std::uint64_t i = 0; i < header.entryCount; ++i) {
+        if (entries[i].nameOffset > header.namesSize || entries[i].nameLength > header.namesSize - entries[i].nameOffset) return false;
+        if (entries[i].dir >= header.dirCount) return false;
+    }
+    
+    std::uint64_t postingCount = (header.namesOffset - header.postingsOffset) / sizeof(std::uint32_t);
+    const auto* trigrams = reinterpret_cast<const TrigramRecord*>(data + header.trigramsOffset);
+    for (std::uint64_t i = 0; i < header.trigramCount; ++i) {
+        if (trigrams[i].offset > postingCount || trigrams[i].count > postingCount - trigrams[i].offset) return false;
+    }
+    
+    const auto* postings = reinterpret_cast<const std::uint32_t*>(data + header.postingsOffset);
+    for (std::uint64_t i = 0; i < postingCount; ++i) {
+        if (postings[i] >= header.entryCount) return false;
+    }
+    return true;
+}
+
+IndexStats writeIndex(const fs::path& file, std::vector<BuildDir>& dirs, std::vector<BuildEntry>& entries) {
+    std::vector<std::uint32_t> order(dirs.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return dirs[a].path < dirs[b].path; });
+    
+    std::vector<std::uint32_t> newId(dirs.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) newId[order[i]] = i;
+    
+    for (auto& entry : entries) entry.dir = newId[entry.dir];
+    std::sort(entries.begin(), entries.end(), [](const BuildEntry& a, const BuildEntry& b) {
+        return a.name != b.name ? a.name < b.name : a.dir < b.dir;
+    });
+    
+    std::string namesBlob;
+    std::vector<DirRecord> dirRecords(dirs.size());
+    for (std::uint32_t i = 0; i < order.size(); ++i) {
+        const BuildDir& dir = dirs[order[i]];
+        dirRecords[i].parent = dir.parent == noParent ? noParent : newId[dir.parent];
+        dirRecords[i].pathLength = static_cast<std::uint32_t>(dir.path.size());
+        dirRecords[i].pathOffset = namesBlob.size();
+        dirRecords[i].mtime = dir.mtime;
+        namesBlob += dir.path;
+    }
+    
+    std::vector<EntryRecord> entryRecords(entries.size());
+    std::unordered_map<std::uint32_t, std::uint32_t> trigramCounts;
+    std::vector<std::uint32_t> trigrams;
+    
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        const BuildEntry& entry = entries[i];
+        std::size_t length = std::min<std::size_t>(entry.name.size(), 0xFFFF);
+        entryRecords[i] = {namesBlob.size(), entry.dir, static_cast<std::uint16_t>(length), static_cast<std::uint8_t>(entry.type), 0};
+        namesBlob.append(entry.name, 0, length);
+        
+        trigrams.clear();
+        collectTrigrams(std::string_view(entry.name.data(), length), trigrams);
+        uniqueSorted(trigrams);
+        for (std::uint32_t trigram : trigrams) ++trigramCounts[trigram];
+    }
+    
+    std::vector<TrigramRecord> trigramRecords;
+    trigramRecords.reserve(trigramCounts.size());
+    for (const auto& item : trigramCounts) trigramRecords.push_back({item.first, item.second, 0});
+    std::sort(trigramRecords.begin(), trigramRecords.end(), [](const TrigramRecord& a, const TrigramRecord& b) {
+        return a.trigram < b.trigram;
+    });
+    
+    std::uint64_t totalPostings = 0;
+    std::unordered_map<std::uint32_t, std::uint64_t> cursors;
+    cursors.reserve(trigramRecords.size());
+    for (auto& record : trigramRecords) {
+        record.offset = totalPostings;
+        cursors[record.trigram] = totalPostings;
+        totalPostings += record.count;
+    }
+    
+    std::vector<std::uint32_t> postings(totalPostings);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        trigrams.clear();
+        collectTrigrams(std::string_view(namesBlob.data() + entryRecords[i].nameOffset, entryRecords[i].nameLength), trigrams);
+        uniqueSorted(trigrams);
+        for (std::uint32_t trigram : trigrams) postings[cursors[trigram]++] = static_cast<std::uint32_t>(i);
+    }
+    
+    IndexHeader header;
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.dirCount = dirRecords.size();
+    header.entryCount = entryRecords.size();
+    header.trigramCount = trigramRecords.size();
+    header.dirsOffset = alignUp(sizeof(IndexHeader));
+    header.entriesOffset = alignUp(header.dirsOffset + dirRecords.size() * sizeof(DirRecord));
+    header.trigramsOffset = alignUp(header.entriesOffset + entryRecords.size() * sizeof(EntryRecord));
+    header.postingsOffset = alignUp(header.trigramsOffset + trigramRecords.size() * sizeof(TrigramRecord));
+    header.namesOffset = alignUp(header.postingsOffset + postings.size() * sizeof(std::uint32_t));
+    header.namesSize = namesBlob.size();
+    
+    fs::create_directories(file.parent_path());
+    fs::path temporary = file;
+    temporary += ".tmp";
+    
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw fs::filesystem_error("cannot write index", temporary, std::make_error_code(std::errc::io_error));
+        }
+        
+        auto writeAt = [&](std::uint64_t offset, const void* bytes, std::size_t size) {
+            static const char padding[8] = {};
+            std::uint64_t position = static_cast<std::uint64_t>(out.tellp());
+            out.write(padding, static_cast<std::streamsize>(offset - position));
+            out.write(static_cast<const char*>(bytes), static_cast<std::streamsize>(size));
+        };
+        
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        writeAt(header.dirsOffset, dirRecords.data(), dirRecords.size() * sizeof(DirRecord));
+        writeAt(header.entriesOffset, entryRecords.data(), entryRecords.size() * sizeof(EntryRecord));
+        writeAt(header.trigramsOffset, trigramRecords.data(), trigramRecords.size() * sizeof(TrigramRecord));
+        writeAt(header.postingsOffset, postings.data(), postings.size() * sizeof(std::uint32_t));
+        writeAt(header.namesOffset, namesBlob.data(), namesBlob.size());
+        
+        if (!out) {
+            throw fs::filesystem_error("cannot write index", temporary, std::make_error_code(std::errc::io_error));
+        }
+    }
+    
+    fs::rename(temporary, file);
+    
+    IndexStats stats;
+    stats.directories = header.dirCount;
+    stats.entries = header.entryCount;
+    stats.trigrams = header.trigramCount;
+    return stats;
+}
+
+std::uint64_t fnv1a(const std::string& text) {
+    std::uint64_t hash = 1469598103934665603ull;
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+#ifdef OS_LINUX
+class IndexWatcher {
+private:
+    int inotifyFd;
+    int stopPipe[2];
+    std::thread thread;
+    
+    std::mutex mutex;
+    std::unordered_map<int, std::uint32_t> watches;
+    std::vector<std::uint32_t> dirty;
+    
+    std::atomic<bool> ready;
+    std::atomic<bool> failed;
+    std::atomic<bool> overflow;
+    std::atomic<bool> stopping;
+    
+    void run(std::vector<std::pair<std::uint32_t, std::string>> directories) {
+        for (const auto& directory : directories) {
+            if (stopping) return;
+            watch(directory.first, directory.second);
+        }
+        ready = true;
+        
+        std::vector<char> buffer(64 * 1024);
+        pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+        
+        while (!stopping) {
+            if (::poll(fds, 2, -1) < 0) {
+                if (errno == EINTR) continue;
+                failed = true;
+                return;
+            }
+            if (fds[1].revents) return;
+            
+            ssize_t bytes = ::read(inotifyFd, buffer.data(), buffer.size());
+            if (bytes <= 0) continue;
+            
+            std::lock_guard<std::mutex> lock(mutex);
+            for (ssize_t offset = 0; offset < bytes;) {
+                const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+                offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+                
+                if (event->mask & IN_Q_OVERFLOW) {
+                    overflow = true;
+                    continue;
+                }
+                
+                auto found = watches.find(event->wd);
+                if (found == watches.end()) continue;
+                
+                dirty.push_back(found->second);
+                if (event->mask & IN_IGNORED) watches.erase(found);
+            }
+        }
+    }
+    
+public:
+    explicit IndexWatcher(std::vector<std::pair<std::uint32_t, std::string>> directories)
+        : ready(false), failed(false), overflow(false), stopping(false) {
+        inotifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0 || ::pipe2(stopPipe, O_CLOEXEC) != 0) {
+            if (inotifyFd >= 0) ::close(inotifyFd);
+            inotifyFd = -1;
+            failed = true;
+            return;
+        }
+        thread = std::thread(&IndexWatcher::run, this, std::move(directories));
+    }
+    
+    ~IndexWatcher() {
+        if (inotifyFd < 0) return;
+        stopping = true;
+        char signal = 1;
+        ssize_t ignored = ::write(stopPipe[1], &signal, 1);
+        (void)ignored;
+        thread.join();
+        ::close(stopPipe[0]);
+        ::close(stopPipe[1]);
+        ::close(inotifyFd);
+    }
+    
+    void watch(std::uint32_t id, const std::string& path) {
+        if (inotifyFd < 0 || failed) return;
+        
+        const std::uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO |
+                                   IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+        int wd = ::inotify_add_watch(inotifyFd, path.c_str(), mask);
+        if (wd < 0) {
+            if (errno == ENOSPC || errno == ENOMEM) failed = true;
+            return;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex);
+        watches[wd] = id;
+    }
+    
+    bool active() const {
+        return ready && !failed;
+    }
+    
+    bool overflowed() {
+        return overflow.exchange(false);
+    }
+    
+    std::vector<std::uint32_t> takeDirty() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::uint32_t> result;
+        result.swap(dirty);
+        uniqueSorted(result);
+        return result;
+    }
+};
+#else
+class IndexWatcher {
+public:
+    explicit IndexWatcher(std::vector<std::pair<std::uint32_t, std::string>>) {}
+    void watch(std::uint32_t, const std::string&) {}
+    bool active() const { return false; }
+    bool overflowed() { return false; }
+    std::vector<std::uint32_t> takeDirty() { return {}; }
+};
+#endif
+
+FileIndex::FileIndex(const fs::path& indexFile)
+    : indexFile(indexFile), data(nullptr), dataSize(0), baseDirCount(0), baseEntryCount(0), trigramCount(0),
+      names(nullptr), dirRecords(nullptr), entryRecords(nullptr), trigramRecords(nullptr), postings(nullptr),
+      overlaySize(0), sweepDone(false) {
+    load();
+}
+
+FileIndex::~FileIndex() {
+    watcher.reset();
+    unload();
+}
+
+fs::path FileIndex::defaultLocation(const fs::path& root) {
+    fs::path base;
+    const char* cache = std::getenv("XDG_CACHE_HOME");
+    const char* home = std::getenv("HOME");
+    
+    if (cache && *cache) {
+        base = cache;
+    } else if (home && *home) {
+        base = fs::path(home) / ".cache";
+    } else {
+        base = fs::temp_directory_path();
+    }
+    
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.idx", static_cast<unsigned long long>(fnv1a(root.string())));
+    return base / "simplefm" / name;
+}
+
+void FileIndex::load() {
+#ifdef OS_LINUX
+    int fd = ::open(indexFile.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw fs::filesystem_error("cannot open index", indexFile, std::error_code(errno, std::generic_category()));
+    }
+    
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(IndexHeader)) {
+        ::close(fd);
+        throw fs::filesystem_error("index file is damaged", indexFile, std::make_error_code(std::errc::invalid_argument));
+    }
+    
+    dataSize = static_cast<std::size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, dataSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw fs::filesystem_error("cannot map index", indexFile, std::error_code(errno, std::generic_category()));
+    }
+    data = static_cast<const char*>(mapping);
+#else
+    std::ifstream in(indexFile, std::ios::binary);
+    if (!in) {
+        throw fs::filesystem_error("cannot open index", indexFile, std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+    fallbackData.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = fallbackData.data();
+    dataSize = fallbackData.size();
+#endif
+    
+    IndexHeader header;
+    if (dataSize >= sizeof(header)) std::memcpy(&header, data, sizeof(header));
+    
+    if (dataSize < sizeof(header) || std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 ||
+        !indexIsConsistent(data, dataSize, header)) {
+        unload();
+        throw fs::filesystem_error("index file is damaged", indexFile, std::make_error_code(std::errc::invalid_argument));
+    }
+    
+    baseDirCount = header.dirCount;
+    baseEntryCount = header.entryCount;
+    trigramCount = header.trigramCount;
+    dirRecords = data + header.dirsOffset;
+    entryRecords = data + header.entriesOffset;
+    trigramRecords = data + header.trigramsOffset;
+    postings = reinterpret_cast<const std::uint32_t*>(data + header.postingsOffset);
+    names = data + header.namesOffset;
+    
+    const auto* dirs = static_cast<const DirRecord*>(dirRecords);
+    dirParents.resize(baseDirCount);
+    dirMtimes.resize(baseDirCount);
+    dirPaths.resize(baseDirCount);
+    dirRemoved.assign(baseDirCount, 0);
+    dirChildren.assign(baseDirCount, {});
+    dirIds.clear();
+    dirIds.reserve(baseDirCount);
+    
+    for (std::uint64_t i = 0; i < baseDirCount; ++i) {
+        dirParents[i] = dirs[i].parent;
+        dirMtimes[i] = dirs[i].mtime;
+        dirPaths[i].assign(names + dirs[i].pathOffset, dirs[i].pathLength);
+        dirIds[dirPaths[i]] = static_cast<std::uint32_t>(i);
+        if (dirs[i].parent != noParent) dirChildren[dirs[i].parent].push_back(static_cast<std::uint32_t>(i));
+    }
+    
+    root = dirPaths[0];
+    
+    std::vector<std::pair<std::uint32_t, std::string>> directories;
+    directories.reserve(baseDirCount);
+    for (std::uint64_t i = 0; i < baseDirCount; ++i) {
+        directories.emplace_back(static_cast<std::uint32_t>(i), dirPaths[i]);
+    }
+    watcher = std::make_unique<IndexWatcher>(std::move(directories));
+    sweepDone = false;
+}
+
+void FileIndex::unload() {
+#ifdef OS_LINUX
+    if (data) ::munmap(const_cast<char*>(data), dataSize);
+#else
+    fallbackData.clear();
+#endif
+    data = nullptr;
+    dataSize = 0;
+}
+
+const std::string& FileIndex::rootPath() const {
+    return root;
+}
+
+bool FileIndex::covers(const fs::path& dir) const {
+    auto found = dirIds.find(dir.string());
+    return found != dirIds.end() && !dirRemoved[found->second];
+}
+
+std::string_view FileIndex::entryName(std::uint64_t id) const {
+    const auto& record = static_cast<const EntryRecord*>(entryRecords)[id];
+    return std::string_view(names + record.nameOffset, record.nameLength);
+}
+
+std::uint32_t FileIndex::entryDir(std::uint64_t id) const {
+    return static_cast<const EntryRecord*>(entryRecords)[id].dir;
+}
+
+std::uint8_t FileIndex::entryType(std::uint64_t id) const {
+    return static_cast<const EntryRecord*>(entryRecords)[id].type;
+}
+
+bool FileIndex::postingList(std::uint32_t trigram, const std::uint32_t*& list, std::uint32_t& count) const {
+    const auto* begin = static_cast<const TrigramRecord*>(trigramRecords);
+    const auto* end = begin + trigramCount;
+    const auto* found = std::lower_bound(begin, end, trigram, [](const TrigramRecord& record, std::uint32_t value) {
+        return record.trigram < value;
+    });
+    
+    if (found == end || found->trigram != trigram) return false;
+    
+    list = postings + found->offset;
+    count = found->count;
+    return true;
+}
+
+bool FileIndex::candidates(const GlobMatcher& matcher, std::vector<std::uint32_t>& ids) const {
+    for (const auto& pattern : matcher.sourcePatterns()) {
+        std::vector<std::uint32_t> trigrams;
+        std::size_t runStart = 0;
+        for (std::size_t i = 0; i <= pattern.size(); ++i) {
+            if (i == pattern.size() || pattern[i] == '*' || pattern[i] == '?') {
+                collectTrigrams(std::string_view(pattern).substr(runStart, i - runStart), trigrams);
+                runStart = i + 1;
+            }
+        }
+        
+        if (trigrams.empty()) return false;
+        uniqueSorted(trigrams);
+        
+        std::vector<std::pair<const std::uint32_t*, std::uint32_t>> lists;
+        bool missing = false;
+        for (std::uint32_t trigram : trigrams) {
+            const std::uint32_t* list;
+            std::uint32_t count;
+            if (!postingList(trigram, list, count)) {
+                missing = true;
+                break;
+            }
+            lists.emplace_back(list, count);
+        }
+        if (missing) continue;
+        
+        std::sort(lists.begin(), lists.end(), [](const auto& a, const auto& b) { return a.second < b.second; });
+        
+        std::vector<std::uint32_t> current(lists[0].first, lists[0].first + lists[0].second);
+        std::vector<std::uint32_t> next;
+        for (std::size_t i = 1; i < lists.size() && !current.empty(); ++i) {
+            next.clear();
+            std::set_intersection(current.begin(), current.end(),
+                                  lists[i].first, lists[i].first + lists[i].second, std::back_inserter(next));
+            current.swap(next);
+        }
+        
+        ids.insert(ids.end(), current.begin(), current.end());
+    }
+    
+    uniqueSorted(ids);
+    return true;
+}
+
+std::uint32_t FileIndex::addDirectory(const std::string& path, std::uint32_t parent, std::int64_t mtime) {
+    std::uint32_t id = static_cast<std::uint32_t>(dirParents.size());
+    dirParents.push_back(parent);
+    dirMtimes.push_back(mtime);
+    dirPaths.push_back(path);
+    dirRemoved.push_back(0);
+    dirChildren.emplace_back();
+    dirChildren[parent].push_back(id);
+    dirIds[path] = id;
+    
+    if (watcher) watcher->watch(id, path);
+    return id;
+}
+
+void FileIndex::rescanDirectory(std::uint32_t id) {
+    const std::string path = dirPaths[id];
+    bool exists;
+    std::int64_t mtime = directoryMtime(path, exists);
+    if (!exists) {
+        dirRemoved[id] = 1;
+        return;
+    }
+    
+    std::vector<OverlayEntry> list;
+    std::vector<std::string> subdirectories;
+    std::error_code error;
+    
+    for (fs::directory_iterator it(path, error), end; !error && it != end; it.increment(error)) {
+        std::string name = it->path().filename().string();
+        EntryType type = entryTypeFromStatus(it->symlink_status(error));
+        if (type == EntryType::Directory) subdirectories.push_back(joinPath(path, name));
+        list.push_back({std::move(name), type});
+    }
+    
+    std::sort(subdirectories.begin(), subdirectories.end());
+    for (std::uint32_t child : dirChildren[id]) {
+        if (!dirRemoved[child] && !std::binary_search(subdirectories.begin(), subdirectories.end(), dirPaths[child])) {
+            dirRemoved[child] = 1;
+        }
+    }
+    
+    for (const auto& subdirectory : subdirectories) {
+        auto found = dirIds.find(subdirectory);
+        if (found != dirIds.end() && !dirRemoved[found->second]) continue;
+        
+        bool childExists;
+        std::int64_t childMtime = directoryMtime(subdirectory, childExists);
+        if (childExists) scanNewTree(addDirectory(subdirectory, id, childMtime));
+    }
+    
+    dirMtimes[id] = mtime;
+    overlaySize += list.size() + 1;
+    overrides[id] = std::move(list);
+}
+
+void FileIndex::scanNewTree(std::uint32_t id) {
+    std::vector<std::uint32_t> stack{id};
+    
+    while (!stack.empty()) {
+        std::uint32_t current = stack.back();
+        stack.pop_back();
+        
+        std::vector<OverlayEntry> list;
+        std::error_code error;
+        const std::string path = dirPaths[current];
+        
+        for (fs::directory_iterator it(path, error), end; !error && it != end; it.increment(error)) {
+            std::string name = it->path().filename().string();
+            EntryType type = entryTypeFromStatus(it->symlink_status(error));
+            
+            if (type == EntryType::Directory) {
+                std::string child = joinPath(path, name);
+                bool exists;
+                std::int64_t mtime = directoryMtime(child, exists);
+                if (exists) stack.push_back(addDirectory(child, current, mtime));
+            }
+            list.push_back({std::move(name), type});
+        }
+        
+        overlaySize += list.size() + 1;
+        overrides[current] = std::move(list);
+    }
+}
+
+std::size_t FileIndex::refresh() {
+    std::vector<std::uint32_t> changed;
+    bool watching = watcher && watcher->active();
+    
+    if (sweepDone && watching && !watcher->overflowed()) {
+        changed = watcher->takeDirty();
+    } else {
+        if (watcher) watcher->takeDirty();
+        
+        std::size_t count = dirPaths.size();
+        std::vector<std::int64_t> mtimes(count);
+        std::vector<char> present(count);
+        unsigned threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), static_cast<unsigned>(count / 4096 + 1)));
+        std::vector<std::thread> workers;
+        
+        for (unsigned t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t]() {
+                for (std::size_t id = t; id < count; id += threads) {
+                    if (dirRemoved[id]) continue;
+                    bool exists;
+                    mtimes[id] = directoryMtime(dirPaths[id], exists);
+                    present[id] = exists;
+                }
+            });
+        }
+        for (auto& worker : workers) worker.join();
+        
+        for (std::size_t id = 0; id < count; ++id) {
+            if (dirRemoved[id]) continue;
+            if (!present[id]) {
+                dirRemoved[id] = 1;
+            } else if (mtimes[id] != dirMtimes[id]) {
+                changed.push_back(static_cast<std::uint32_t>(id));
+            }
+        }
+        
+        sweepDone = watching;
+    }
+    
+    for (std::uint32_t id : changed) {
+        if (id < dirRemoved.size() && !dirRemoved[id]) rescanDirectory(id);
+    }
+    
+    return changed.size();
+}
+
+IndexStats FileIndex::save() {
+    std::size_t count = dirPaths.size();
+    std::vector<char> live(count);
+    std::vector<std::uint32_t> buildId(count, noParent);
+    std::vector<BuildDir> dirs;
+    std::vector<BuildEntry> entries;
+    
+    for (std::size_t id = 0; id < count; ++id) {
+        live[id] = !dirRemoved[id] && (dirParents[id] == noParent || live[dirParents[id]]);
+        if (!live[id]) continue;
+        
+        buildId[id] = static_cast<std::uint32_t>(dirs.size());
+        std::uint32_t parent = dirParents[id] == noParent ? noParent : buildId[dirParents[id]];
+        dirs.push_back({dirPaths[id], parent, dirMtimes[id]});
+    }
+    
+    if (dirs.empty()) {
+        throw fs::filesystem_error("index root no longer exists", fs::path(root), std::make_error_code(std::errc::no_such_file_or_directory));
+    }
+    
+    entries.reserve(baseEntryCount + overlaySize);
+    for (std::uint64_t id = 0; id < baseEntryCount; ++id) {
+        std::uint32_t dir = entryDir(id);
+        if (!live[dir] || overrides.count(dir)) continue;
+        entries.push_back({buildId[dir], std::string(entryName(id)), static_cast<EntryType>(entryType(id))});
+    }
+    
+    for (const auto& item : overrides) {
+        if (!live[item.first]) continue;
+        for (const auto& entry : item.second) {
+            entries.push_back({buildId[item.first], entry.name, entry.type});
+        }
+    }
+    
+    IndexStats stats = writeIndex(indexFile, dirs, entries);
+    
+    watcher.reset();
+    unload();
+    overrides.clear();
+    overlaySize = 0;
+    load();
+    
+    return stats;
+}
+
+IndexStats FileIndex::stats() const {
+    IndexStats stats;
+    stats.directories = baseDirCount;
+    stats.entries = baseEntryCount;
+    stats.trigrams = trigramCount;
+    stats.pendingChanges = overlaySize;
+    return stats;
+}
+
+IndexStats FileIndex::build(const fs::path& rootDir, const fs::path& indexFile, unsigned threads) {
+    struct Block {
+        std::string directory;
+        std::vector<std::pair<std::string, EntryType>> items;
+    };
+    
+    struct PendingDir {
+        std::string path;
+        std::string parent;
+        std::int64_t mtime;
+    };
+    
+    struct WorkerData {
+        std::vector<Block> blocks;
+        std::vector<PendingDir> dirs;
+    };
+    
+    std::string rootString = rootDir.string();
+    bool exists;
+    std::int64_t rootMtime = directoryMtime(rootString, exists);
+    if (!exists) {
+        throw fs::filesystem_error("index root is not a directory", rootDir, std::make_error_code(std::errc::not_a_directory));
+    }
+    
+    DirectoryWalker walker(threads);
+    std::vector<WorkerData> workers(walker.threadCount());
+    
+    walker.walk(rootDir,
+        [&](const WalkEntry& entry) {
+            WorkerData& local = workers[entry.worker];
+            if (local.blocks.empty() || local.blocks.back().directory != entry.directory) {
+                local.blocks.push_back({entry.directory, {}});
+            }
+            local.blocks.back().items.emplace_back(std::string(entry.name, entry.nameLength), entry.type);
+            
+            if (entry.type == EntryType::Directory) {
+                std::string path = entry.path();
+                bool present;
+                std::int64_t mtime = directoryMtime(path, present);
+                local.dirs.push_back({std::move(path), entry.directory, mtime});
+            }
+            return true;
+        },
+        [](const std::string&, const std::error_code&, unsigned) {});
+    
+    std::vector<BuildDir> dirs;
+    std::unordered_map<std::string, std::uint32_t> dirIndex;
+    dirs.push_back({rootString, noParent, rootMtime});
+    dirIndex[rootString] = 0;
+    
+    for (const auto& worker : workers) {
+        for (const auto& dir : worker.dirs) {
+            dirIndex[dir.path] = static_cast<std::uint32_t>(dirs.size());
+            dirs.push_back({dir.path, noParent, dir.mtime});
+        }
+    }
+    
+    for (const auto& worker : workers) {
+        for (const auto& dir : worker.dirs) {
+            auto parent = dirIndex.find(dir.parent);
+            if (parent != dirIndex.end()) dirs[dirIndex[dir.path]].parent = parent->second;
+        }
+    }
+    
+    std::vector<BuildEntry> entries;
+    for (auto& worker : workers) {
+        for (auto& block : worker.blocks) {
+            auto found = dirIndex.find(block.directory);
+            if (found == dirIndex.end()) continue;
+            for (auto& item : block.items) {
+                entries.push_back({found->second, std::move(item.first), item.second});
+            }
+        }
+        worker.blocks.clear();
+    }
+    
+    return writeIndex(indexFile, dirs, entries);
+}
+
+void FileIndex::query(const fs::path& dir, const GlobMatcher& matcher, const std::function<void(const std::string& path)>& onMatch) {
+    refresh();
+    if (overlaySize > std::max<std::uint64_t>(65536, baseEntryCount / 8)) save();
+    
+    auto target = dirIds.find(dir.string());
+    if (target == dirIds.end() || dirRemoved[target->second]) return;
+    
+    std::size_t count = dirPaths.size();
+    std::vector<char> scope(count, 0);
+    for (std::size_t id = 0; id < count; ++id) {
+        if (dirRemoved[id]) continue;
+        bool inScope = id == target->second || (dirParents[id] != noParent && scope[dirParents[id]] != 0);
+        if (inScope) scope[id] = overrides.count(static_cast<std::uint32_t>(id)) ? 2 : 1;
+    }
+    
+    auto visitBase = [&](std::uint64_t id) {
+        std::uint32_t entryDirectory = entryDir(id);
+        if (scope[entryDirectory] != 1) return;
+        std::string_view name = entryName(id);
+        if (matcher.matches(name)) onMatch(joinPath(dirPaths[entryDirectory], name));
+    };
+    
+    std::vector<std::uint32_t> ids;
+    if (candidates(matcher, ids)) {
+        for (std::uint32_t id : ids) visitBase(id);
+    } else {
+        for (std::uint64_t id = 0; id < baseEntryCount; ++id) visitBase(id);
+    }
+    
+    for (const auto& item : overrides) {
+        if (scope[item.first] != 2) continue;
+        for (const auto& entry : item.second) {
+            if (matcher.matches(entry.name)) onMatch(joinPath(dirPaths[item.first], entry.name));
+        }
+    }
+}
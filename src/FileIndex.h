@@ -0,0 +1,93 @@
+#ifndef FILE_INDEX_H
+#define FILE_INDEX_H
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <memory>
+#include <cstdint>
+#include "DirectoryWalker.h"
+#include "GlobMatcher.h"
+
+namespace fs = std::filesystem;
+
+class IndexWatcher;
+
+struct IndexStats {
+    std::uint64_t directories = 0;
+    std::uint64_t entries = 0;
+    std::uint64_t trigrams = 0;
+    std::uint64_t pendingChanges = 0;
+};
+
+class FileIndex {
+private:
+    struct OverlayEntry {
+        std::string name;
+        EntryType type;
+    };
+    
+    fs::path indexFile;
+    std::string root;
+    
+    const char* data;
+    std::size_t dataSize;
+    std::vector<char> fallbackData;
+    
+    std::uint64_t baseDirCount;
+    std::uint64_t baseEntryCount;
+    std::uint64_t trigramCount;
+    const char* names;
+    const void* dirRecords;
+    const void* entryRecords;
+    const void* trigramRecords;
+    const std::uint32_t* postings;
+    
+    std::vector<std::uint32_t> dirParents;
+    std::vector<std::int64_t> dirMtimes;
+    std::vector<std::string> dirPaths;
+    std::vector<char> dirRemoved;
+    std::vector<std::vector<std::uint32_t>> dirChildren;
+    std::unordered_map<std::string, std::uint32_t> dirIds;
+    std::unordered_map<std::uint32_t, std::vector<OverlayEntry>> overrides;
+    std::uint64_t overlaySize;
+    bool sweepDone;
+    
+    std::unique_ptr<IndexWatcher> watcher;
+    
+    void load();
+    void unload();
+    std::string_view entryName(std::uint64_t id) const;
+    std::uint32_t entryDir(std::uint64_t id) const;
+    std::uint8_t entryType(std::uint64_t id) const;
+    bool postingList(std::uint32_t trigram, const std::uint32_t*& list, std::uint32_t& count) const;
+    bool candidates(const GlobMatcher& matcher, std::vector<std::uint32_t>& ids) const;
+    
+    std::uint32_t addDirectory(const std::string& path, std::uint32_t parent, std::int64_t mtime);
+    void rescanDirectory(std::uint32_t id);
+    void scanNewTree(std::uint32_t id);
+    
+public:
+    explicit FileIndex(const fs::path& indexFile);
+    ~FileIndex();
+    
+    FileIndex(const FileIndex&) = delete;
+    FileIndex& operator=(const FileIndex&) = delete;
+    
+    static IndexStats build(const fs::path& root, const fs::path& indexFile, unsigned threads = 0);
+    static fs::path defaultLocation(const fs::path& root);
+    
+    const std::string& rootPath() const;
+    bool covers(const fs::path& dir) const;
+    
+    std::size_t refresh();
+    IndexStats save();
+    IndexStats stats() const;
+    
+    void query(const fs::path& dir, const GlobMatcher& matcher, const std::function<void(const std::string& path)>& onMatch);
+};
+
+#endif
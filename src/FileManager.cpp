@@ -1,13 +1,24 @@
 #include "FileManager.h"
+#include "FileStreamer.h"
+#include "Metrics.h"
+#include "PathStore.h"
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
 #include <ctime>
+#include <iterator>
+#include <stdexcept>
+#include <limits>
+#include <atomic>
+#include <mutex>
+#include <memory>
 
 #ifdef OS_WINDOWS
 #include <windows.h>
 #include <codecvt>
 #include <locale>
+#include <io.h>
+#include <cstdio>
 
 tstring toTString(const std::string& str) {
     if (str.empty()) return L"";
@@ -27,6 +38,7 @@ std::string toString(const tstring& wstr) {
     return strTo;
 }
 #else
+#include <unistd.h>
 
 tstring toTString(const std::string& str) {
     return str;
@@ -37,69 +49,59 @@ std::string toString(const tstring& str) {
 }
 #endif
 
-Logger::Logger(const std::string& logPath) {
-    logFile.open(logPath, std::ios::app);
-}
-
-Logger::~Logger() {
-    if (logFile.is_open()) {
-        logFile.close();
-    }
-}
-
-void Logger::log(const std::string& message) {
-    if (!logFile.is_open()) return;
-    
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    
-    std::tm timeInfo;
-#ifdef OS_WINDOWS
-    localtime_s(&timeInfo, &time);
-#else
-    localtime_r(&time, &timeInfo);
-#endif
-    
-    logFile << std::put_time(&timeInfo, "[%Y-%m-%d %H:%M:%S] ") << message << std::endl;
-}
-
-FileManager::FileManager() : running(true) {
+FileManager::FileManager(const LoggerOptions& loggerOptions) : logger(loggerOptions), running(true), interactive(false), outputFormat(OutputFormat::Text) {
     currentPath = fs::current_path();
     registerCommands();
 }
 
 void FileManager::registerCommands() {
-    commands["ls"] = [this](const std::vector<std::string>& args) { this->listDirectory(args); };
-    commands["cp"] = [this](const std::vector<std::string>& args) { this->copyFile(args); };
-    commands["mv"] = [this](const std::vector<std::string>& args) { this->moveFile(args); };
-    commands["rm"] = [this](const std::vector<std::string>& args) { this->removeFile(args); };
-    commands["mkdir"] = [this](const std::vector<std::string>& args) { this->makeDirectory(args); };
-    commands["cat"] = [this](const std::vector<std::string>& args) { this->displayFileContent(args); };
-    commands["find"] = [this](const std::vector<std::string>& args) { this->findFiles(args); };
-    commands["help"] = [this](const std::vector<std::string>& args) { this->showHelp(args); };
-    commands["exit"] = [this](const std::vector<std::string>& args) { this->exitProgram(args); };
+    commands["ls"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->listDirectory(args, out); };
+    commands["cp"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->copyFile(args, out); };
+    commands["mv"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->moveFile(args, out); };
+    commands["rm"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->removeFile(args, out); };
+    commands["sync"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->syncTree(args, out); };
+    commands["pack"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->packArchive(args, out); };
+    commands["unpack"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->unpackArchive(args, out); };
+    commands["mkdir"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->makeDirectory(args, out); };
+    commands["cat"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->displayFileContent(args, out); };
+    commands["head"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->showHead(args, out); };
+    commands["tail"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->showTail(args, out); };
+    commands["find"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->findFiles(args, out); };
+    commands["grep"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->grepFiles(args, out); };
+    commands["dupes"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->findDuplicates(args, out); };
+    commands["du"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->diskUsage(args, out); };
+    commands["index"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->indexCommand(args, out); };
+    commands["cache"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->cacheCommand(args, out); };
+    commands["stats"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->showStats(args, out); };
+    commands["help"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->showHelp(args, out); };
+    commands["format"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->formatCommand(args, out); };
+    commands["exit"] = [this](const std::vector<std::string>& args, OutputSink& out) { this->exitProgram(args, out); };
 }
 
 std::vector<std::string> FileManager::parseCommand(const std::string& input) {
     std::vector<std::string> args;
     std::string arg;
     bool inQuotes = false;
+    std::size_t start = 0;
     
-    for (char c : input) {
+    for (std::size_t i = 0; i < input.size(); ++i) {
+        char c = input[i];
+        if (c != '"' && (c != ' ' || inQuotes)) continue;
+        
+        arg.append(input, start, i - start);
+        start = i + 1;
+        
         if (c == '"') {
             inQuotes = !inQuotes;
-        } else if (c == ' ' && !inQuotes) {
-            if (!arg.empty()) {
-                args.push_back(arg);
-                arg.clear();
-            }
-        } else {
-            arg += c;
+        } else if (!arg.empty()) {
+            args.push_back(std::move(arg));
+            arg.clear();
         }
     }
     
+    arg.append(input, start, std::string::npos);
     if (!arg.empty()) {
-        args.push_back(arg);
+        args.push_back(std::move(arg));
     }
     
     return args;
@@ -107,6 +109,7 @@ std::vector<std::string> FileManager::parseCommand(const std::string& input) {
 
 void FileManager::run() {
     std::string input;
+    interactive = true;
     
     tcout << toTString("SimpleFileManager запущен. Введите 'help' для справки.\n");
     
@@ -116,29 +119,217 @@ void FileManager::run() {
         
         if (input.empty()) continue;
         
-        std::vector<std::string> args = parseCommand(input);
-        std::string cmd = args[0];
-        args.erase(args.begin());
+        execute(input);
+    }
+}
+
+bool FileManager::execute(const std::string& input) {
+    std::vector<std::string> args = parseCommand(input);
+    if (args.empty()) return true;
+    
+    std::string cmd = args[0];
+    args.erase(args.begin());
+    
+    auto command = commands.find(cmd);
+    if (command != commands.end()) {
+        Metrics::add(MetricCounter::Commands);
+        MetricTimer timer(Metrics::histogram("command." + cmd));
         
-        if (commands.find(cmd) != commands.end()) {
-            try {
-                commands[cmd](args);
-                logger.log("Выполнена команда: " + input);
-            } catch (const std::exception& e) {
-                tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
-                logger.log("Ошибка при выполнении команды: " + input + " - " + e.what());
+        try {
+            runCommand(command->second, std::move(args));
+            logger.log("Выполнена команда: " + input);
+            return true;
+        } catch (const std::exception& e) {
+            Metrics::add(MetricCounter::Errors);
+            tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+            logger.log("Ошибка при выполнении команды: " + input + " - " + e.what());
+        }
+    } else {
+        tcout << toTString("Неизвестная команда. Введите 'help' для справки.\n");
+    }
+    
+    return false;
+}
+
+bool FileManager::runBatch(std::istream& input, const BatchOptions& options, const std::string& reportFile) {
+    BatchRunner runner(options,
+        [this](const std::string& line) { return parseCommand(line); },
+        [this](const std::vector<std::string>& args) {
+            auto it = commands.find(args[0]);
+            if (it == commands.end()) {
+                throw std::invalid_argument("неизвестная команда: " + args[0]);
             }
+            Metrics::add(MetricCounter::Commands);
+            MetricTimer timer(Metrics::histogram("command." + args[0]));
+            runCommand(it->second, std::vector<std::string>(args.begin() + 1, args.end()));
+        },
+        [this](const std::string& arg) {
+            fs::path path = arg;
+            return path.is_relative() ? currentPath / path : path;
+        });
+    
+    bool success = runner.run(input);
+    
+    for (const auto& status : runner.report()) {
+        if (status.success) {
+            logger.log("Выполнена команда: " + status.command);
         } else {
-            tcout << toTString("Неизвестная команда. Введите 'help' для справки.\n");
+            Metrics::add(MetricCounter::Errors);
+            logger.log("Ошибка при выполнении команды: " + status.command + " - " + status.error);
+        }
+    }
+    
+    if (!reportFile.empty()) {
+        std::ofstream report(reportFile);
+        if (!report) {
+            tcerr << toTString("Не удалось открыть файл отчета: " + reportFile) << std::endl;
+        } else {
+            runner.writeReport(report);
+        }
+    }
+    
+    std::size_t failed = runner.failures();
+    tcout << toTString("Выполнено команд: " + std::to_string(runner.report().size()) +
+                       ", с ошибками: " + std::to_string(failed)) << std::endl;
+    
+    for (const auto& status : runner.report()) {
+        if (!status.success) {
+            tcerr << toTString("  строка " + std::to_string(status.line) + ": " + status.command + " - " + status.error) << std::endl;
         }
     }
+    
+    return success;
 }
 
 bool FileManager::isRunning() const {
     return running;
 }
 
-void FileManager::listDirectory(const std::vector<std::string>& args) {
+void FileManager::setOutputFormat(OutputFormat format) {
+    outputFormat = format;
+}
+
+void FileManager::runCommand(const Command& command, std::vector<std::string> args) {
+    OutputFormat format = outputFormat;
+    std::string value;
+    if (takeOption(args, "--format", value) && !OutputSink::parseFormat(value, format)) {
+        throw std::invalid_argument("неизвестный формат вывода: " + value);
+    }
+    
+    OutputSink out(format, writeOutput);
+    command(args, out);
+    out.flush();
+}
+
+bool FileManager::takeOption(std::vector<std::string>& args, const std::string& name, std::string& value) {
+    for (auto it = args.begin(); it != args.end(); ++it) {
+        if (*it == name && it + 1 != args.end()) {
+            value = *(it + 1);
+            args.erase(it, it + 2);
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+bool FileManager::takeFlag(std::vector<std::string>& args, const std::string& name) {
+    auto it = std::find(args.begin(), args.end(), name);
+    if (it == args.end()) return false;
+    
+    args.erase(it);
+    return true;
+}
+
+std::uint64_t FileManager::parseCount(const std::string& value) {
+    std::size_t parsed = 0;
+    std::uint64_t result = 0;
+    
+    try {
+        result = std::stoull(value, &parsed);
+    } catch (const std::exception&) {
+        parsed = 0;
+    }
+    
+    if (parsed == 0 || parsed != value.size() || value[0] == '-') {
+        throw std::invalid_argument("некорректное число: " + value);
+    }
+    
+    return result;
+}
+
+void FileManager::parseRange(const std::string& value, std::uint64_t& first, std::uint64_t& second) {
+    std::size_t colon = value.find(':');
+    
+    first = parseCount(value.substr(0, colon));
+    if (colon != std::string::npos && colon + 1 < value.size()) {
+        second = parseCount(value.substr(colon + 1));
+    }
+}
+
+unsigned FileManager::takeThreadsOption(std::vector<std::string>& args) {
+    unsigned threads = 0;
+    
+    for (auto it = args.begin(); it != args.end();) {
+        if (*it == "-j" && it + 1 != args.end()) {
+            int value = 0;
+            try {
+                value = std::stoi(*(it + 1));
+            } catch (const std::exception&) {
+                value = 0;
+            }
+            
+            if (value <= 0) {
+                throw std::invalid_argument("некорректное число потоков: " + *(it + 1));
+            }
+            threads = static_cast<unsigned>(value);
+            it = args.erase(it, it + 2);
+        } else {
+            ++it;
+        }
+    }
+    
+    return threads;
+}
+
+void FileManager::writeOutput(const char* data, std::size_t size) {
+#ifdef OS_WINDOWS
+    tcout << toTString(std::string(data, size));
+#else
+    tcout.write(data, static_cast<std::streamsize>(size));
+#endif
+    tcout.flush();
+}
+
+bool FileManager::isTerminal() {
+#ifdef OS_WINDOWS
+    return _isatty(_fileno(stdout)) != 0;
+#else
+    return ::isatty(STDOUT_FILENO) != 0;
+#endif
+}
+
+bool FileManager::isInteractiveInput() {
+#ifdef OS_WINDOWS
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return ::isatty(STDIN_FILENO) != 0;
+#endif
+}
+
+void FileManager::listDirectory(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    ListOptions options;
+    options.threads = takeThreadsOption(args);
+    options.longFormat = takeFlag(args, "-l");
+    options.reverse = takeFlag(args, "-r");
+    
+    std::string sortOption;
+    if (takeOption(args, "--sort", sortOption) && !DirectoryLister::parseSort(sortOption, options.sort)) {
+        tcerr << toTString("Использование: ls [-l] [-r] [--sort name|size|mtime|none] [path]") << std::endl;
+        return;
+    }
+    
     fs::path path = currentPath;
     
     if (!args.empty()) {
@@ -158,26 +349,104 @@ void FileManager::listDirectory(const std::vector<std::string>& args) {
         return;
     }
     
-    tcout << toTString("Содержимое директории: " + path.string()) << std::endl;
+    out.message("Содержимое директории: " + path.string());
     
-    for (const auto& entry : fs::directory_iterator(path)) {
-        std::string entryType = entry.is_directory() ? "[DIR]" : "[FILE]";
-        std::string entrySize = entry.is_directory() ? "" : 
-                               std::to_string(fs::file_size(entry)) + " bytes";
-        
-        std::string output = entryType;
-        while (output.length() < 10) output += " ";
-        output += entry.path().filename().string();
-        while (output.length() < 50) output += " ";
-        output += entrySize;
+    ListSummary summary = engine.list(path, options, [&](const ListEntry& entry) {
+        out.entry(entry, options.longFormat);
+        return true;
+    });
+    
+    if (summary.firstError) {
+        tcerr << toTString("Ошибка чтения директории: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    } else if (summary.errors > 0) {
+        tcerr << toTString("Не удалось получить сведения о " + std::to_string(summary.errors) + " элементах") << std::endl;
+    }
+}
+
+void FileManager::copyFile(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    TreeCopyOptions options;
+    
+    try {
+        options.threads = takeThreadsOption(args);
         
-        tcout << toTString(output) << std::endl;
+        std::string value;
+        if (takeOption(args, "--queue-depth", value)) {
+            std::uint64_t depth = parseCount(value);
+            if (depth == 0 || depth > 4096) {
+                throw std::invalid_argument("некорректная глубина очереди: " + value);
+            }
+            options.queueDepth = static_cast<unsigned>(depth);
+        }
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (args.size() < 2) {
+        tcerr << toTString("Использование: cp [-j <потоки>] [--queue-depth <N>] <источник> <назначение>") << std::endl;
+        return;
+    }
+    
+    fs::path source = args[0];
+    fs::path dest = args[1];
+    
+    if (source.is_relative()) {
+        source = currentPath / source;
+    }
+    
+    if (dest.is_relative()) {
+        dest = currentPath / dest;
     }
+    
+    if (!fs::exists(source)) {
+        tcerr << toTString("Источник не существует: " + source.string()) << std::endl;
+        return;
+    }
+    
+    bool directory = fs::is_directory(source);
+    if (directory && fs::exists(dest) && !fs::is_directory(dest)) {
+        tcerr << toTString("Назначение должно быть директорией: " + dest.string()) << std::endl;
+        return;
+    }
+    
+    if (!directory && fs::is_directory(dest)) {
+        dest = dest / source.filename();
+    }
+    
+    TreeCopySummary summary = engine.copy(source, dest, options);
+    
+    if (!directory) {
+        if (summary.errors > 0) {
+            tcerr << toTString("Ошибка копирования: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+        } else {
+            out.message("Файл скопирован: " + source.string() + " -> " + dest.string());
+        }
+        return;
+    }
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка копирования: " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    }
+    
+    std::string message = "Директория скопирована: " + source.string() + " -> " + dest.string() +
+                          " (директорий: " + std::to_string(summary.directories) +
+                          ", файлов: " + std::to_string(summary.files);
+    if (summary.ringUsed) {
+        message += ", через io_uring: " + std::to_string(summary.ringFiles);
+    }
+    message += ", " + std::to_string(summary.bytesCopied) + " байт)";
+    out.message(message);
 }
 
-void FileManager::copyFile(const std::vector<std::string>& args) {
+void FileManager::moveFile(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    MoveOptions options;
+    options.threads = takeThreadsOption(args);
+    
     if (args.size() < 2) {
-        tcerr << toTString("Использование: cp <источник> <назначение>") << std::endl;
+        tcerr << toTString("Использование: mv [-j <потоки>] <источник> <назначение>") << std::endl;
         return;
     }
     
@@ -197,53 +466,58 @@ void FileManager::copyFile(const std::vector<std::string>& args) {
         return;
     }
     
-    try {
-        if (fs::is_directory(source)) {
-            if (!fs::exists(dest)) {
-                fs::create_directories(dest);
-            } else if (!fs::is_directory(dest)) {
-                tcerr << toTString("Назначение должно быть директорией: " + dest.string()) << std::endl;
-                return;
-            }
-            
-            copyRecursive(source, dest);
-            tcout << toTString("Директория скопирована: " + source.string() + " -> " + dest.string()) << std::endl;
+    if (fs::is_directory(dest) && !fs::is_directory(source)) {
+        dest = dest / source.filename();
+    }
+    
+    MoveSummary summary = engine.move(source, dest, options);
+    
+    if (!summary.crossDevice) {
+        if (summary.errors > 0) {
+            tcerr << toTString("Ошибка перемещения: " + summary.firstErrorPath + " -> " + dest.string() + ": " +
+                               summary.firstError.message()) << std::endl;
         } else {
-            if (fs::is_directory(dest)) {
-                dest = dest / source.filename();
-            }
-            
-            fs::copy_file(source, dest, fs::copy_options::overwrite_existing);
-            tcout << toTString("Файл скопирован: " + source.string() + " -> " + dest.string()) << std::endl;
+            out.message("Файл перемещен/переименован: " + source.string() + " -> " + dest.string());
         }
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка копирования: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка перемещения: не удалось перенести " + std::to_string(summary.errors) +
+                           " элементов, первый: " + summary.firstErrorPath + ": " + summary.firstError.message() +
+                           ". Повторите команду, чтобы завершить перемещение.") << std::endl;
     }
+    
+    std::string message = "Перемещено между файловыми системами: " + source.string() + " -> " + dest.string() +
+                          " (" + std::to_string(summary.files) + " файлов, " + std::to_string(summary.bytes) + " байт";
+    if (summary.resumed > 0) {
+        message += ", " + std::to_string(summary.resumed) + " уже были на месте";
+    }
+    out.message(message + ")");
 }
 
-void FileManager::copyRecursive(const fs::path& source, const fs::path& dest) {
+void FileManager::syncTree(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    SyncOptions options;
+    
     try {
-        for (const auto& entry : fs::directory_iterator(source)) {
-            fs::path currentDest = dest / entry.path().filename();
-            
-            if (fs::is_directory(entry)) {
-                if (!fs::exists(currentDest)) {
-                    fs::create_directories(currentDest);
-                }
-                copyRecursive(entry.path(), currentDest);
-            } else {
-                fs::copy_file(entry.path(), currentDest, fs::copy_options::overwrite_existing);
+        options.threads = takeThreadsOption(args);
+        options.deleteExtraneous = takeFlag(args, "--delete");
+        
+        std::string value;
+        if (takeOption(args, "--block-size", value)) {
+            options.blockSize = static_cast<std::size_t>(parseCount(value));
+            if (options.blockSize == 0) {
+                throw std::invalid_argument("некорректный размер блока: " + value);
             }
         }
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка при рекурсивном копировании: ") << toTString(e.what()) << std::endl;
-        throw;
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
     }
-}
-
-void FileManager::moveFile(const std::vector<std::string>& args) {
-    if (args.size() < 2) {
-        tcerr << toTString("Использование: mv <источник> <назначение>") << std::endl;
+    
+    if (args.size() != 2) {
+        tcerr << toTString("Использование: sync [-j <потоки>] [--delete] [--block-size <байт>] <источник> <назначение>") << std::endl;
         return;
     }
     
@@ -263,21 +537,140 @@ void FileManager::moveFile(const std::vector<std::string>& args) {
         return;
     }
     
+    if (!fs::is_directory(source) && fs::is_directory(dest)) {
+        dest = dest / source.filename();
+    }
+    
+    SyncSummary summary = engine.sync(source, dest, options);
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка синхронизации: " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    }
+    
+    std::string message = "Синхронизировано: " + source.string() + " -> " + dest.string() +
+                          " (файлов: " + std::to_string(summary.files) +
+                          ", без изменений: " + std::to_string(summary.unchanged) +
+                          ", скопировано: " + std::to_string(summary.copied) +
+                          ", обновлено по блокам: " + std::to_string(summary.patched) +
+                          " (" + std::to_string(summary.blocksRewritten) + " блоков)" +
+                          ", записано " + std::to_string(summary.bytesWritten) + " байт";
+    if (options.deleteExtraneous || summary.deleted > 0) {
+        message += ", удалено: " + std::to_string(summary.deleted);
+    }
+    out.message(message + ")");
+}
+
+void FileManager::packArchive(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    PackOptions options;
+    
     try {
-        if (fs::is_directory(dest) && !fs::is_directory(source)) {
-            dest = dest / source.filename();
-        }
-        
-        fs::rename(source, dest);
-        tcout << toTString("Файл перемещен/переименован: " + source.string() + " -> " + dest.string()) << std::endl;
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка перемещения: ") << toTString(e.what()) << std::endl;
+        options.threads = takeThreadsOption(args);
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (args.size() != 2) {
+        tcerr << toTString("Использование: pack [-j <потоки>] <папка> <архив.tar>") << std::endl;
+        return;
+    }
+    
+    fs::path source = args[0];
+    fs::path archive = args[1];
+    
+    if (source.is_relative()) {
+        source = currentPath / source;
+    }
+    
+    if (archive.is_relative()) {
+        archive = currentPath / archive;
+    }
+    
+    if (!fs::is_directory(source)) {
+        tcerr << toTString("Папка не существует: " + source.string()) << std::endl;
+        return;
+    }
+    
+    PackSummary summary = engine.pack(source, archive, options);
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка архивации: " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+        if (summary.archiveBytes == 0) return;
+    }
+    
+    std::string message = "Архив создан: " + source.string() + " -> " + archive.string() +
+                          " (директорий: " + std::to_string(summary.directories) +
+                          ", файлов: " + std::to_string(summary.files) +
+                          ", ссылок: " + std::to_string(summary.symlinks) +
+                          ", данных: " + std::to_string(summary.bytes) + " байт" +
+                          ", архив: " + std::to_string(summary.archiveBytes) + " байт";
+    if (summary.skipped > 0) {
+        message += ", пропущено: " + std::to_string(summary.skipped);
+    }
+    out.message(message + ")");
+}
+
+void FileManager::unpackArchive(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    UnpackOptions options;
+    
+    try {
+        options.threads = takeThreadsOption(args);
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (args.size() != 2) {
+        tcerr << toTString("Использование: unpack [-j <потоки>] <архив.tar> <папка>") << std::endl;
+        return;
+    }
+    
+    fs::path archive = args[0];
+    fs::path dest = args[1];
+    
+    if (archive.is_relative()) {
+        archive = currentPath / archive;
+    }
+    
+    if (dest.is_relative()) {
+        dest = currentPath / dest;
+    }
+    
+    if (!fs::is_regular_file(archive)) {
+        tcerr << toTString("Архив не существует: " + archive.string()) << std::endl;
+        return;
+    }
+    
+    UnpackSummary summary = engine.unpack(archive, dest, options);
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка распаковки: " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+        if (summary.directories + summary.files + summary.symlinks + summary.hardlinks == 0) return;
+    }
+    
+    std::string message = "Архив распакован: " + archive.string() + " -> " + dest.string() +
+                          " (директорий: " + std::to_string(summary.directories) +
+                          ", файлов: " + std::to_string(summary.files) +
+                          ", ссылок: " + std::to_string(summary.symlinks + summary.hardlinks) +
+                          ", данных: " + std::to_string(summary.bytes) + " байт";
+    if (summary.skipped > 0) {
+        message += ", пропущено: " + std::to_string(summary.skipped);
     }
+    out.message(message + ")");
 }
 
-void FileManager::removeFile(const std::vector<std::string>& args) {
+void FileManager::removeFile(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    RemoveOptions options;
+    options.threads = takeThreadsOption(args);
+    
     if (args.empty()) {
-        tcerr << toTString("Использование: rm <путь>") << std::endl;
+        tcerr << toTString("Использование: rm [-j <потоки>] <путь>") << std::endl;
         return;
     }
     
@@ -287,25 +680,42 @@ void FileManager::removeFile(const std::vector<std::string>& args) {
         path = currentPath / path;
     }
     
-    if (!fs::exists(path)) {
+    fs::file_status status = fs::symlink_status(path);
+    if (!fs::exists(status)) {
         tcerr << toTString("Файл не существует: " + path.string()) << std::endl;
         return;
     }
     
-    try {
-        if (fs::is_directory(path)) {
-            std::uintmax_t count = fs::remove_all(path);
-            tcout << toTString("Удалена директория и " + std::to_string(count) + " элементов.") << std::endl;
+    bool directory = fs::is_directory(status);
+    if (directory && interactive && isTerminal()) {
+        options.onProgress = [](std::uint64_t removed) {
+            tcout << toTString("\rУдалено элементов: " + std::to_string(removed)) << std::flush;
+        };
+    }
+    
+    RemoveSummary summary = engine.remove(path, options);
+    
+    if (options.onProgress) {
+        tcout << toTString("\r") << std::flush;
+    }
+    
+    if (!directory) {
+        if (summary.errors > 0) {
+            tcerr << toTString("Ошибка удаления: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
         } else {
-            fs::remove(path);
-            tcout << toTString("Файл удален: " + path.string()) << std::endl;
+            out.message("Файл удален: " + path.string());
         }
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка удаления: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка удаления: не удалось удалить " + std::to_string(summary.errors) +
+                           " элементов, первый: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
     }
+    out.message("Удалена директория и " + std::to_string(summary.removed) + " элементов.");
 }
 
-void FileManager::makeDirectory(const std::vector<std::string>& args) {
+void FileManager::makeDirectory(const std::vector<std::string>& args, OutputSink& out) {
     if (args.empty()) {
         tcerr << toTString("Использование: mkdir <путь>") << std::endl;
         return;
@@ -317,24 +727,19 @@ void FileManager::makeDirectory(const std::vector<std::string>& args) {
         path = currentPath / path;
     }
     
-    try {
-        if (fs::create_directories(path)) {
-            tcout << toTString("Директория создана: " + path.string()) << std::endl;
-        } else {
-            tcout << toTString("Директория уже существует: " + path.string()) << std::endl;
-        }
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка создания директории: ") << toTString(e.what()) << std::endl;
+    MakeDirectorySummary summary = engine.makeDirectory(path);
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Ошибка создания директории: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    } else if (summary.created) {
+        out.message("Директория создана: " + path.string());
+    } else {
+        out.message("Директория уже существует: " + path.string());
     }
 }
 
-void FileManager::displayFileContent(const std::vector<std::string>& args) {
-    if (args.empty()) {
-        tcerr << toTString("Использование: cat <файл>") << std::endl;
-        return;
-    }
-    
-    fs::path path = args[0];
+bool FileManager::resolveFile(const std::string& arg, fs::path& path) {
+    path = arg;
     
     if (path.is_relative()) {
         path = currentPath / path;
@@ -342,94 +747,187 @@ void FileManager::displayFileContent(const std::vector<std::string>& args) {
     
     if (!fs::exists(path)) {
         tcerr << toTString("Файл не существует: " + path.string()) << std::endl;
-        return;
+        return false;
     }
     
     if (fs::is_directory(path)) {
         tcerr << toTString("Путь указывает на директорию, а не файл: " + path.string()) << std::endl;
+        return false;
+    }
+    
+    return true;
+}
+
+void FileManager::displayFileContent(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    std::string bytesOption;
+    std::string linesOption;
+    bool hasBytes = takeOption(args, "--bytes", bytesOption);
+    bool hasLines = takeOption(args, "--lines", linesOption);
+    
+    if (args.empty()) {
+        tcerr << toTString("Использование: cat [--bytes <смещение>[:<длина>]] [--lines <с>[:<по>]] <файл>") << std::endl;
         return;
     }
     
+    fs::path path;
+    if (!resolveFile(args[0], path)) return;
+    
     try {
-        std::ifstream file(path);
-        if (!file) {
-            tcerr << toTString("Не удалось открыть файл: " + path.string()) << std::endl;
-            return;
+        ByteRange range{0, std::numeric_limits<std::uint64_t>::max()};
+        
+        if (hasLines) {
+            std::uint64_t first = 1;
+            std::uint64_t last = std::numeric_limits<std::uint64_t>::max();
+            parseRange(linesOption, first, last);
+            range = FileStreamer::lineRange(path, first, last);
+        } else if (hasBytes) {
+            parseRange(bytesOption, range.offset, range.length);
         }
         
-        tcout << toTString("Содержимое файла: " + path.string()) << std::endl;
-        tcout << toTString("----------------------------------------") << std::endl;
+        out.message("Содержимое файла: " + path.string());
+        out.message("----------------------------------------");
+        out.flush();
         
-        std::string line;
-        while (std::getline(file, line)) {
-            tcout << toTString(line) << std::endl;
+        StreamResult result = FileStreamer::streamRange(path, range);
+        if (!result.endsWithNewline) {
+            out.write("\n");
         }
         
-        tcout << toTString("----------------------------------------") << std::endl;
+        out.message("----------------------------------------");
         
     } catch (const std::exception& e) {
         tcerr << toTString("Ошибка чтения файла: ") << toTString(e.what()) << std::endl;
     }
 }
 
-bool FileManager::matchWildcard(const std::string& name, const std::string& pattern) {
-    if (pattern.empty()) return name.empty();
+void FileManager::showHead(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    std::string linesOption = "10";
+    std::string bytesOption;
+    takeOption(args, "-n", linesOption);
+    bool hasBytes = takeOption(args, "-c", bytesOption);
     
-    std::size_t nameIndex = 0;
-    std::size_t patternIndex = 0;
-    std::size_t starIndex = std::string::npos;
-    std::size_t matchIndex = 0;
+    if (args.empty()) {
+        tcerr << toTString("Использование: head [-n <строк>] [-c <байт>] <файл>") << std::endl;
+        return;
+    }
     
-    while (nameIndex < name.size()) {
-        if (patternIndex < pattern.size() && 
-            (pattern[patternIndex] == '?' || pattern[patternIndex] == name[nameIndex])) {
-            ++nameIndex;
-            ++patternIndex;
-        } else if (patternIndex < pattern.size() && pattern[patternIndex] == '*') {
-            starIndex = patternIndex;
-            matchIndex = nameIndex;
-            ++patternIndex;
-        } else if (starIndex != std::string::npos) {
-            patternIndex = starIndex + 1;
-            nameIndex = ++matchIndex;
-        } else {
-            return false;
+    fs::path path;
+    if (!resolveFile(args[0], path)) return;
+    
+    try {
+        ByteRange range = hasBytes ? ByteRange{0, parseCount(bytesOption)}
+                                   : FileStreamer::lineRange(path, 1, parseCount(linesOption));
+        
+        out.flush();
+        StreamResult result = FileStreamer::streamRange(path, range);
+        if (!result.endsWithNewline) {
+            out.write("\n");
         }
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка чтения файла: ") << toTString(e.what()) << std::endl;
     }
+}
+
+void FileManager::showTail(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    std::string linesOption = "10";
+    std::string bytesOption;
+    takeOption(args, "-n", linesOption);
+    bool hasBytes = takeOption(args, "-c", bytesOption);
+    bool followMode = takeFlag(args, "-f");
     
-    while (patternIndex < pattern.size() && pattern[patternIndex] == '*') {
-        ++patternIndex;
+    if (args.empty()) {
+        tcerr << toTString("Использование: tail [-n <строк>] [-c <байт>] [-f] <файл>") << std::endl;
+        return;
     }
     
-    return patternIndex == pattern.size();
-}
-
-void FileManager::findRecursive(const fs::path& dir, const std::string& pattern, std::vector<fs::path>& results) {
+    if (followMode && (!interactive || !isInteractiveInput())) {
+        tcerr << toTString("Режим -f доступен только в интерактивном режиме с вводом с терминала") << std::endl;
+        return;
+    }
+    
+    fs::path path;
+    if (!resolveFile(args[0], path)) return;
+    
     try {
-        for (const auto& entry : fs::directory_iterator(dir)) {
-            std::string filename = entry.path().filename().string();
-            
-            if (matchWildcard(filename, pattern)) {
-                results.push_back(entry.path());
-            }
-            
-            if (fs::is_directory(entry)) {
-                findRecursive(entry.path(), pattern, results);
+        ByteRange range = hasBytes ? FileStreamer::tailBytes(path, parseCount(bytesOption))
+                                   : FileStreamer::tailLines(path, parseCount(linesOption));
+        
+        out.flush();
+        StreamResult result = FileStreamer::streamRange(path, range);
+        
+        if (!followMode) {
+            if (!result.endsWithNewline) {
+                out.write("\n");
             }
+            return;
         }
-    } catch (const fs::filesystem_error& e) {
-        tcerr << toTString("Ошибка поиска в директории " + dir.string() + ": ") << toTString(e.what()) << std::endl;
+        
+        tcerr << toTString("Ожидание новых данных, Enter - остановка...") << std::endl;
+        if (!FileStreamer::follow(path, range.offset + result.bytes, 0)) {
+            tcerr << toTString("Режим слежения не поддерживается на этой платформе") << std::endl;
+            return;
+        }
+        
+        std::string line;
+        std::getline(std::cin, line);
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка чтения файла: ") << toTString(e.what()) << std::endl;
     }
 }
 
-void FileManager::findFiles(const std::vector<std::string>& args) {
+void FileManager::findFiles(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    FindOptions options;
+    options.threads = takeThreadsOption(args);
+    options.useIndex = !takeFlag(args, "--no-index");
+    bool sorted = takeFlag(args, "--sort");
+    
+    std::string value;
+    if (takeOption(args, "--limit", value)) {
+        options.limit = parseCount(value);
+    }
+    
     if (args.size() < 2) {
-        tcerr << toTString("Использование: find <директория> <шаблон>") << std::endl;
+        tcerr << toTString("Использование: find [-j <потоки>] [--no-index] [--sort] [--limit N] <директория> [шаблон...] [выражение]") << std::endl;
         return;
     }
     
     fs::path dir = args[0];
-    std::string pattern = args[1];
+    std::size_t first = 1;
+    while (first < args.size() && !FindQuery::isExpression(args[first])) {
+        ++first;
+    }
+    std::vector<std::string> patterns(args.begin() + 1, args.begin() + first);
+    std::vector<std::string> expression(args.begin() + first, args.end());
+    
+    std::string pattern;
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        pattern += (i == 1 ? "" : expression.empty() ? "', '" : " ") + args[i];
+    }
+    
+    std::unique_ptr<FindQuery> query;
+    if (!expression.empty()) {
+        if (!patterns.empty()) {
+            std::vector<std::string> names = {"("};
+            for (const auto& name : patterns) {
+                if (names.size() > 1) names.push_back("-o");
+                names.push_back("-name");
+                names.push_back(name);
+            }
+            names.push_back(")");
+            expression.insert(expression.begin(), names.begin(), names.end());
+        }
+        
+        try {
+            query = std::make_unique<FindQuery>(expression);
+        } catch (const std::exception& e) {
+            tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+            return;
+        }
+    }
     
     if (dir.is_relative()) {
         dir = currentPath / dir;
@@ -445,39 +943,393 @@ void FileManager::findFiles(const std::vector<std::string>& args) {
         return;
     }
     
-    std::vector<fs::path> results;
+    const std::size_t flushBytes = 64 * 1024;
+    unsigned workers = options.threads ? options.threads : ThreadPool::defaultThreads();
+    
+    std::vector<std::string> buffers(workers);
+    std::vector<PathStore> stores(sorted ? workers : 0);
+    std::mutex outputMutex;
+    
+    options.onError = [](const std::string& directory, const std::error_code& error) {
+        tcerr << toTString("Ошибка поиска в директории " + directory + ": " + error.message()) << std::endl;
+    };
     
     try {
-        findRecursive(dir, pattern, results);
+        FileEngine::MatchVisitor onMatch = [&](std::string_view directory, std::string_view name, unsigned worker) {
+            if (sorted) {
+                stores[worker].add(directory, name);
+                return true;
+            }
+            
+            std::string& buffer = buffers[worker];
+            out.appendPath(buffer, directory, name);
+            
+            if (buffer.size() >= flushBytes) {
+                std::lock_guard<std::mutex> lock(outputMutex);
+                out.write(buffer);
+                buffer.clear();
+            }
+            return true;
+        };
         
-        if (results.empty()) {
-            tcout << toTString("Файлы, соответствующие шаблону '" + pattern + "', не найдены.") << std::endl;
-        } else {
-            tcout << toTString("Найдено " + std::to_string(results.size()) + " файлов:") << std::endl;
-            for (const auto& path : results) {
-                tcout << toTString(path.string()) << std::endl;
+        FindSummary summary = query ? engine.find(dir, *query, options, onMatch) : engine.find(dir, patterns, options, onMatch);
+        
+        if (sorted) {
+            for (std::size_t i = 1; i < stores.size(); ++i) {
+                stores[0].append(std::move(stores[i]));
             }
+            stores[0].sort();
+            
+            std::string path;
+            for (std::size_t i = 0; i < stores[0].size(); ++i) {
+                path.clear();
+                stores[0].appendPath(i, path);
+                out.path(path);
+            }
+        }
+        
+        for (auto& buffer : buffers) {
+            if (!buffer.empty()) out.write(buffer);
+        }
+        
+        if (summary.matches == 0) {
+            out.message(std::string(query ? "Файлы, соответствующие условию '" : "Файлы, соответствующие шаблону '") + pattern + "', не найдены.");
+        } else if (summary.limited) {
+            out.message("Показаны первые " + std::to_string(summary.matches) + " файлов (--limit).");
+        } else {
+            out.message("Найдено " + std::to_string(summary.matches) + " файлов.");
+        }
+    } catch (const std::exception& e) {
+        Metrics::add(MetricCounter::Errors);
+        tcerr << toTString("Ошибка поиска: ") << toTString(e.what()) << std::endl;
+    }
+}
+
+void FileManager::grepFiles(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    SearchOptions options;
+    options.threads = takeThreadsOption(args);
+    options.onMatch = [&out](const std::string& path, std::uint64_t line, std::string_view text) { out.match(path, line, text); };
+    
+    std::vector<std::string> includes;
+    std::string include;
+    while (takeOption(args, "--include", include)) {
+        includes.push_back(include);
+    }
+    
+    if (args.size() != 2) {
+        tcerr << toTString("Использование: grep [-j <потоки>] [--include <шаблон>]... <директория> <выражение>") << std::endl;
+        return;
+    }
+    
+    fs::path dir = args[0];
+    if (dir.is_relative()) {
+        dir = currentPath / dir;
+    }
+    
+    if (!fs::is_directory(dir)) {
+        tcerr << toTString("Указанный путь не является директорией: " + dir.string()) << std::endl;
+        return;
+    }
+    
+    try {
+        SearchSummary summary = engine.grep(dir, args[1], includes, options, [](const std::string& directory, const std::error_code& error) {
+            tcerr << toTString("Ошибка поиска в директории " + directory + ": " + error.message()) << std::endl;
+        });
+        
+        if (summary.errors > 0) {
+            tcerr << toTString("Не удалось прочитать " + std::to_string(summary.errors) + " файлов, первый: " +
+                               summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+        }
+        
+        std::string message = summary.matches == 0
+            ? "Совпадения не найдены"
+            : "Найдено " + std::to_string(summary.matches) + " совпадений в " + std::to_string(summary.matchedFiles) + " файлах";
+        message += " (просмотрено файлов: " + std::to_string(summary.files);
+        if (summary.binarySkipped > 0) {
+            message += ", пропущено двоичных: " + std::to_string(summary.binarySkipped);
         }
+        out.message(message + ").");
     } catch (const std::exception& e) {
+        Metrics::add(MetricCounter::Errors);
         tcerr << toTString("Ошибка поиска: ") << toTString(e.what()) << std::endl;
     }
 }
 
-void FileManager::showHelp(const std::vector<std::string>& args) {
-    tcout << toTString("SimpleFileManager - Консольный файловый менеджер\n"
+void FileManager::findDuplicates(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    DupeOptions options;
+    
+    try {
+        options.threads = takeThreadsOption(args);
+        
+        std::string value;
+        if (takeOption(args, "--min-size", value)) {
+            options.minSize = std::max<std::uint64_t>(parseCount(value), 1);
+        }
+        if (takeOption(args, "--link", value)) {
+            if (value == "hard") {
+                options.link = LinkMode::Hard;
+            } else if (value == "reflink") {
+                options.link = LinkMode::Reflink;
+            } else {
+                throw std::invalid_argument("неизвестный тип ссылки: " + value);
+            }
+        }
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (args.size() != 1) {
+        tcerr << toTString("Использование: dupes [-j <потоки>] [--min-size <байт>] [--link hard|reflink] <директория>") << std::endl;
+        return;
+    }
+    
+    fs::path dir = args[0];
+    if (dir.is_relative()) {
+        dir = currentPath / dir;
+    }
+    
+    if (!fs::is_directory(dir)) {
+        tcerr << toTString("Указанный путь не является директорией: " + dir.string()) << std::endl;
+        return;
+    }
+    
+    DupeSummary summary = engine.findDuplicates(dir, options);
+    
+    for (std::size_t i = 0; i < summary.groups.size(); ++i) {
+        out.group(i + 1, summary.groups[i].size, summary.groups[i].paths);
+    }
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Не удалось обработать " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    }
+    
+    out.message("Просмотрено файлов: " + std::to_string(summary.files) +
+                       ", групп дубликатов: " + std::to_string(summary.groups.size()) +
+                       ", лишние копии занимают " + std::to_string(summary.wastedBytes) + " байт" +
+                       " (жестких ссылок пропущено: " + std::to_string(summary.hardlinksSkipped) +
+                       ", частичных хешей: " + std::to_string(summary.partialHashed) +
+                       ", полных хешей: " + std::to_string(summary.fullHashed) + ").");
+    
+    if (options.link != LinkMode::None) {
+        out.message("Заменено ссылками: " + std::to_string(summary.linked) + " файлов, освобождено " +
+                           std::to_string(summary.reclaimedBytes) + " байт.");
+    }
+}
+
+void FileManager::diskUsage(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    DiskUsageOptions options;
+    
+    try {
+        options.threads = takeThreadsOption(args);
+        options.apparentSize = takeFlag(args, "--apparent");
+        options.cached = takeFlag(args, "--cached");
+        
+        std::string value;
+        if (takeOption(args, "--top", value)) {
+            options.top = static_cast<std::size_t>(parseCount(value));
+        }
+    } catch (const std::exception& e) {
+        tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        return;
+    }
+    
+    if (args.size() != 1) {
+        tcerr << toTString("Использование: du [-j <потоки>] [--top N] [--apparent] [--cached] <директория>") << std::endl;
+        return;
+    }
+    
+    fs::path dir = args[0];
+    if (dir.is_relative()) {
+        dir = currentPath / dir;
+    }
+    
+    if (!fs::is_directory(dir)) {
+        tcerr << toTString("Указанный путь не является директорией: " + dir.string()) << std::endl;
+        return;
+    }
+    
+    DiskUsageSummary summary = engine.diskUsage(dir, options);
+    
+    for (const auto& subtree : summary.largest) {
+        out.usage(subtree.path, subtree.totals.allocated, subtree.totals.apparent);
+    }
+    out.usage(dir.string(), summary.totals.allocated, summary.totals.apparent);
+    
+    if (summary.errors > 0) {
+        tcerr << toTString("Не удалось прочитать " + std::to_string(summary.errors) + " элементов, первый: " +
+                           summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+    }
+    
+    std::string cached = options.cached ? ", из кэша: " + std::to_string(summary.cachedDirectories) : std::string();
+    out.message("Занято " + std::to_string(summary.totals.allocated) + " байт, данных " +
+                std::to_string(summary.totals.apparent) + " байт" +
+                " (файлов: " + std::to_string(summary.totals.files) +
+                ", директорий: " + std::to_string(summary.totals.directories) +
+                ", повторных жестких ссылок: " + std::to_string(summary.duplicateLinks) +
+                ", прочитано директорий: " + std::to_string(summary.scannedDirectories) + cached + ").");
+}
+
+void FileManager::indexCommand(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    unsigned threads = takeThreadsOption(args);
+    
+    if (args.size() < 2 || (args[0] != "build" && args[0] != "update" && args[0] != "drop")) {
+        tcerr << toTString("Использование: index build [-j <потоки>] <директория> | index update <директория> | index drop <директория>") << std::endl;
+        return;
+    }
+    
+    fs::path dir = args[1];
+    
+    if (dir.is_relative()) {
+        dir = currentPath / dir;
+    }
+    
+    if (!fs::is_directory(dir)) {
+        tcerr << toTString("Указанный путь не является директорией: " + dir.string()) << std::endl;
+        return;
+    }
+    
+    dir = fs::weakly_canonical(dir);
+    
+    IndexSummary summary;
+    if (args[0] == "build") {
+        summary = engine.buildIndex(dir, threads);
+    } else if (args[0] == "update") {
+        summary = engine.updateIndex(dir);
+    } else {
+        summary = engine.dropIndex(dir);
+    }
+    
+    if (summary.errors > 0) {
+        if (args[0] != "build" && summary.firstError == std::errc::no_such_file_or_directory) {
+            tcerr << toTString("Индекс для директории не найден: " + dir.string()) << std::endl;
+        } else {
+            tcerr << toTString("Ошибка индекса: " + summary.firstErrorPath + ": " + summary.firstError.message()) << std::endl;
+        }
+        return;
+    }
+    
+    if (args[0] == "build") {
+        out.message("Индекс построен: " + std::to_string(summary.stats.entries) + " записей, " +
+                           std::to_string(summary.stats.directories) + " директорий -> " + summary.location);
+    } else if (args[0] == "update") {
+        out.message("Индекс обновлен: изменено директорий " + std::to_string(summary.changedDirectories) + ", " +
+                           std::to_string(summary.stats.entries) + " записей");
+    } else {
+        out.message("Индекс удален: " + summary.location);
+    }
+}
+
+void FileManager::cacheCommand(const std::vector<std::string>& args, OutputSink& out) {
+    std::string action = args.empty() ? "stats" : args[0];
+    
+    if (action == "stats" && args.size() <= 1) {
+        CacheStats stats = engine.cacheStats();
+        std::uint64_t lookups = stats.hits + stats.misses;
+        std::uint64_t rate = lookups ? stats.hits * 100 / lookups : 0;
+        
+        out.message("Кэш директорий: " + std::to_string(stats.directories) + " директорий, " +
+                           std::to_string(stats.entries) + " записей, память " + std::to_string(stats.memoryUsage) +
+                           " из " + std::to_string(stats.memoryLimit) + " байт, наблюдений " +
+                           std::to_string(stats.watches) + " из " + std::to_string(stats.watchLimit));
+        out.message("Обращения: " + std::to_string(lookups) + ", попадания: " + std::to_string(stats.hits) +
+                           " (" + std::to_string(rate) + "%), промахи: " + std::to_string(stats.misses));
+        out.message("Сброшено списков: " + std::to_string(stats.invalidations) + ", точечных обновлений: " +
+                           std::to_string(stats.entryUpdates) + ", вытеснено: " + std::to_string(stats.evictions));
+        if (!stats.watching) {
+            out.message("inotify недоступен, кэширование отключено.");
+        }
+    } else if (action == "clear" && args.size() == 1) {
+        engine.clearCache();
+        out.message("Кэш директорий очищен.");
+    } else if (action == "limit" && args.size() == 2) {
+        try {
+            engine.setCacheLimit(static_cast<std::size_t>(parseCount(args[1])));
+            out.message("Лимит памяти кэша: " + args[1] + " байт");
+        } catch (const std::exception& e) {
+            tcerr << toTString("Ошибка: ") << toTString(e.what()) << std::endl;
+        }
+    } else {
+        tcerr << toTString("Использование: cache [stats|clear|limit <байт>]") << std::endl;
+    }
+}
+
+void FileManager::showStats(const std::vector<std::string>& rawArgs, OutputSink& out) {
+    std::vector<std::string> args = rawArgs;
+    std::string jsonFile;
+    bool json = takeOption(args, "--json", jsonFile);
+    bool reset = takeFlag(args, "--reset");
+    
+    if (!args.empty()) {
+        tcerr << toTString("Использование: stats [--json <файл>] [--reset]") << std::endl;
+        return;
+    }
+    
+    if (json) {
+        fs::path jsonPath(jsonFile);
+        if (jsonPath.is_relative()) {
+            jsonPath = currentPath / jsonPath;
+        }
+        
+        std::ofstream file(jsonPath, std::ios::trunc);
+        if (!file || !(file << Metrics::formatJson())) {
+            tcerr << toTString("Не удалось записать метрики в файл: " + jsonPath.string()) << std::endl;
+            return;
+        }
+        out.message("Метрики сохранены в файл: " + jsonPath.string());
+    } else {
+        out.write(out.outputFormat() == OutputFormat::JsonLines ? Metrics::formatJson() : Metrics::formatText());
+    }
+    
+    if (reset) {
+        Metrics::reset();
+        out.message("Метрики сброшены.");
+    }
+}
+
+void FileManager::showHelp(const std::vector<std::string>& args, OutputSink& out) {
+    out.message("SimpleFileManager - Консольный файловый менеджер\n"
                "Доступные команды:\n"
-               "  ls [path]               - Вывод списка файлов и папок\n"
-               "  cp <source> <dest>      - Копирование файла/папки\n"
-               "  mv <source> <dest>      - Перемещение/переименование\n"
-               "  rm <path>               - Удаление файла/папки\n"
+               "  ls [-l] [-r] [--sort name|size|mtime] [path] - Вывод списка файлов и папок\n"
+               "  cp [-j N] [--queue-depth N] <source> <dest> - Копирование файла/папки (конвейер, мелкие файлы через io_uring)\n"
+               "  mv [-j N] <source> <dest> - Перемещение/переименование (между ФС - потоковое копирование с удалением источника)\n"
+               "  rm [-j N] <path>        - Удаление файла/папки (параллельно по поддеревьям)\n"
+               "  sync [-j N] [--delete] <src> <dst> - Инкрементальная синхронизация (только измененные файлы и блоки)\n"
+               "  pack [-j N] <dir> <file.tar> - Упаковка папки в tar (ustar/pax, параллельное чтение, sendfile)\n"
+               "  unpack [-j N] <file.tar> <dir> - Распаковка tar (каркас директорий, затем файлы пулом потоков)\n"
                "  mkdir <path>            - Создание директории\n"
-               "  cat <file>              - Вывод содержимого файла\n"
-               "  find <dir> <name>       - Поиск файла по имени (поддерживает *, ?)\n"
+               "  cat [--bytes O:L] [--lines A:B] <file> - Вывод содержимого файла или его части\n"
+               "  head [-n N] [-c N] <file> - Вывод начала файла\n"
+               "  tail [-n N] [-c N] [-f] <file> - Вывод конца файла, -f - слежение\n"
+               "  find [-j N] [--sort] [--limit N] <dir> [name...] [-type f -size +1M ...] - Потоковый поиск по шаблонам (*, ?) и условиям\n"
+               "  grep [-j N] [--include <name>] <dir> <regex> - Поиск строк в содержимом файлов\n"
+               "  dupes [-j N] [--min-size N] [--link hard|reflink] <dir> - Поиск дубликатов файлов\n"
+               "  du [-j N] [--top N] [--apparent] [--cached] <dir> - Занятое место с учетом жестких ссылок, N крупнейших поддеревьев\n"
+               "  index build|update|drop <dir> - Индекс имен файлов для мгновенного find\n"
+               "  cache [stats|clear|limit N] - Кэш списков директорий для ls и find -j 1 (инвалидация через inotify)\n"
+               "  stats [--json <file>] [--reset] - Метрики команд: счетчики и гистограммы задержек\n"
+               "  format text|json|nul    - Формат вывода: текст, JSON lines или пути через NUL (--format для одной команды)\n"
                "  help                    - Вывод списка команд\n"
-               "  exit                    - Выход из программы\n") << std::endl;
+               "  exit                    - Выход из программы\n");
+}
+
+void FileManager::formatCommand(const std::vector<std::string>& args, OutputSink& out) {
+    OutputFormat format;
+    if (args.size() != 1 || !OutputSink::parseFormat(args[0], format)) {
+        tcerr << toTString("Использование: format text|json|nul") << std::endl;
+        return;
+    }
+    
+    outputFormat = format;
+    out.message("Формат вывода: " + args[0]);
 }
 
-void FileManager::exitProgram(const std::vector<std::string>& args) {
+void FileManager::exitProgram(const std::vector<std::string>& args, OutputSink& out) {
     running = false;
-    tcout << toTString("Выход из программы...\n") << std::endl;
+    out.message("Выход из программы...\n");
 } 
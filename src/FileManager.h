@@ -9,6 +9,12 @@
 #include <functional>
 #include <map>
 #include <chrono>
+#include <memory>
+#include <atomic>
+#include "Logger.h"
+#include "BatchRunner.h"
+#include "FileEngine.h"
+#include "OutputSink.h"
 
 namespace fs = std::filesystem;
 
@@ -27,46 +33,64 @@ using tstring = std::string;
 tstring toTString(const std::string& str);
 std::string toString(const tstring& str);
 
-class Logger {
-private:
-    std::ofstream logFile;
-    
-public:
-    Logger(const std::string& logPath = "log.txt");
-    ~Logger();
-    
-    void log(const std::string& message);
-};
-
 class FileManager {
 private:
+    using Command = std::function<void(const std::vector<std::string>& args, OutputSink& out)>;
+    
     fs::path currentPath;
     Logger logger;
     bool running;
+    bool interactive;
+    std::atomic<OutputFormat> outputFormat;
     
-    std::map<std::string, std::function<void(const std::vector<std::string>&)>> commands;
+    std::map<std::string, Command> commands;
+    FileEngine engine;
     
     void registerCommands();
     std::vector<std::string> parseCommand(const std::string& input);
+    void runCommand(const Command& command, std::vector<std::string> args);
+    
+    void listDirectory(const std::vector<std::string>& args, OutputSink& out);
+    void copyFile(const std::vector<std::string>& args, OutputSink& out);
+    void moveFile(const std::vector<std::string>& args, OutputSink& out);
+    void removeFile(const std::vector<std::string>& args, OutputSink& out);
+    void syncTree(const std::vector<std::string>& args, OutputSink& out);
+    void packArchive(const std::vector<std::string>& args, OutputSink& out);
+    void unpackArchive(const std::vector<std::string>& args, OutputSink& out);
+    void makeDirectory(const std::vector<std::string>& args, OutputSink& out);
+    void displayFileContent(const std::vector<std::string>& args, OutputSink& out);
+    void showHead(const std::vector<std::string>& args, OutputSink& out);
+    void showTail(const std::vector<std::string>& args, OutputSink& out);
+    void findFiles(const std::vector<std::string>& args, OutputSink& out);
+    void grepFiles(const std::vector<std::string>& args, OutputSink& out);
+    void findDuplicates(const std::vector<std::string>& args, OutputSink& out);
+    void diskUsage(const std::vector<std::string>& args, OutputSink& out);
+    void indexCommand(const std::vector<std::string>& args, OutputSink& out);
+    void cacheCommand(const std::vector<std::string>& args, OutputSink& out);
+    void showStats(const std::vector<std::string>& args, OutputSink& out);
+    void showHelp(const std::vector<std::string>& args, OutputSink& out);
+    void formatCommand(const std::vector<std::string>& args, OutputSink& out);
+    void exitProgram(const std::vector<std::string>& args, OutputSink& out);
+    
+    bool resolveFile(const std::string& arg, fs::path& path);
     
-    void listDirectory(const std::vector<std::string>& args);
-    void copyFile(const std::vector<std::string>& args);
-    void moveFile(const std::vector<std::string>& args);
-    void removeFile(const std::vector<std::string>& args);
-    void makeDirectory(const std::vector<std::string>& args);
-    void displayFileContent(const std::vector<std::string>& args);
-    void findFiles(const std::vector<std::string>& args);
-    void showHelp(const std::vector<std::string>& args);
-    void exitProgram(const std::vector<std::string>& args);
+    static void writeOutput(const char* data, std::size_t size);
+    static bool isTerminal();
+    static bool isInteractiveInput();
     
-    void copyRecursive(const fs::path& source, const fs::path& dest);
-    bool matchWildcard(const std::string& name, const std::string& pattern);
-    void findRecursive(const fs::path& dir, const std::string& pattern, std::vector<fs::path>& results);
+    static bool takeOption(std::vector<std::string>& args, const std::string& name, std::string& value);
+    static bool takeFlag(std::vector<std::string>& args, const std::string& name);
+    static std::uint64_t parseCount(const std::string& value);
+    static void parseRange(const std::string& value, std::uint64_t& first, std::uint64_t& second);
+    static unsigned takeThreadsOption(std::vector<std::string>& args);
     
 public:
-    FileManager();
+    explicit FileManager(const LoggerOptions& loggerOptions = LoggerOptions());
     void run();
+    bool execute(const std::string& input);
+    bool runBatch(std::istream& input, const BatchOptions& options, const std::string& reportFile = std::string());
     bool isRunning() const;
+    void setOutputFormat(OutputFormat format);
 };
 
 #endif 
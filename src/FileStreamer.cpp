@@ -0,0 +1,407 @@
+#include "FileStreamer.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <vector>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <system_error>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/inotify.h>
+#else
+#include <fstream>
+#include <iostream>
+#ifdef OS_WINDOWS
+#define NOMINMAX
+#include <windows.h>
+#endif
+#endif
+
+namespace {
+
+const std::uint64_t windowSize = 64ull * 1024 * 1024;
+const std::size_t scanBlock = 64 * 1024;
+
+#ifdef OS_LINUX
+int openForReading(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw fs::filesystem_error("cannot open file", path, std::error_code(errno, std::generic_category()));
+    }
+    return fd;
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+std::uint64_t streamWithSplice(int in, int out, std::uint64_t offset, std::uint64_t end) {
+    while (offset < end) {
+        loff_t inOffset = static_cast<loff_t>(offset);
+        ssize_t moved = ::splice(in, &inOffset, out, nullptr, static_cast<std::size_t>(std::min(end - offset, windowSize)),
+                                 SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (moved < 0 && errno == EINTR) continue;
+        if (moved <= 0) break;
+        offset += static_cast<std::uint64_t>(moved);
+    }
+    return offset;
+}
+
+std::uint64_t streamWithSendfile(int in, int out, std::uint64_t offset, std::uint64_t end) {
+    while (offset < end) {
+        off_t inOffset = static_cast<off_t>(offset);
+        ssize_t sent = ::sendfile(out, in, &inOffset, static_cast<std::size_t>(std::min(end - offset, windowSize)));
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) break;
+        offset += static_cast<std::uint64_t>(sent);
+    }
+    return offset;
+}
+
+std::uint64_t streamWithMmap(int in, int out, std::uint64_t offset, std::uint64_t end) {
+    const std::uint64_t pageSize = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+    
+    while (offset < end) {
+        std::uint64_t base = offset - offset % pageSize;
+        std::uint64_t length = std::min(end - base, windowSize);
+        void* mapping = ::mmap(nullptr, static_cast<std::size_t>(length), PROT_READ, MAP_PRIVATE, in, static_cast<off_t>(base));
+        
+        if (mapping == MAP_FAILED) {
+            std::vector<char> buffer(scanBlock);
+            ssize_t readBytes = ::pread(in, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+            if (readBytes <= 0) break;
+            std::size_t useful = static_cast<std::size_t>(std::min<std::uint64_t>(static_cast<std::uint64_t>(readBytes), end - offset));
+            if (!writeAll(out, buffer.data(), useful)) break;
+            offset += useful;
+            continue;
+        }
+        
+        ::madvise(mapping, static_cast<std::size_t>(length), MADV_SEQUENTIAL);
+        const char* data = static_cast<const char*>(mapping) + (offset - base);
+        bool written = writeAll(out, data, static_cast<std::size_t>(base + length - offset));
+        ::munmap(mapping, static_cast<std::size_t>(length));
+        
+        if (!written) break;
+        offset = base + length;
+    }
+    
+    return offset;
+}
+
+template <typename Visitor>
+bool scanForward(int in, std::uint64_t offset, std::uint64_t end, Visitor visitor) {
+    std::vector<char> buffer(scanBlock);
+    
+    while (offset < end) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(end - offset, buffer.size()));
+        ssize_t readBytes = ::pread(in, buffer.data(), chunk, static_cast<off_t>(offset));
+        if (readBytes < 0 && errno == EINTR) continue;
+        if (readBytes <= 0) break;
+        
+        const char* begin = buffer.data();
+        const char* limit = begin + readBytes;
+        for (const char* p = begin; (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(limit - p)))); ++p) {
+            if (!visitor(offset + static_cast<std::uint64_t>(p - begin))) return true;
+        }
+        offset += static_cast<std::uint64_t>(readBytes);
+    }
+    
+    return false;
+}
+#else
+class ConsoleWriter {
+private:
+    std::string pending;
+    
+    void emit(std::size_t count) {
+#ifdef OS_WINDOWS
+        if (count == 0) return;
+        int size = MultiByteToWideChar(CP_UTF8, 0, pending.data(), static_cast<int>(count), NULL, 0);
+        std::wstring text(static_cast<std::size_t>(size), L'\0');
+        MultiByteToWideChar(CP_UTF8, 0, pending.data(), static_cast<int>(count), &text[0], size);
+        std::wcout.write(text.data(), static_cast<std::streamsize>(text.size()));
+#else
+        std::cout.write(pending.data(), static_cast<std::streamsize>(count));
+#endif
+        pending.erase(0, count);
+    }
+    
+public:
+    void write(const char* data, std::size_t size) {
+        pending.append(data, size);
+        
+        std::size_t complete = pending.size();
+        std::size_t trailing = 0;
+        while (trailing < 3 && trailing < complete &&
+               (static_cast<unsigned char>(pending[complete - 1 - trailing]) & 0xc0) == 0x80) {
+            ++trailing;
+        }
+        if (trailing < complete) {
+            unsigned char lead = static_cast<unsigned char>(pending[complete - 1 - trailing]);
+            std::size_t length = lead >= 0xf0 ? 4 : lead >= 0xe0 ? 3 : lead >= 0xc0 ? 2 : 1;
+            if (length > trailing + 1) complete -= trailing + 1;
+        }
+        emit(complete);
+    }
+    
+    void flush() {
+        emit(pending.size());
+#ifdef OS_WINDOWS
+        std::wcout.flush();
+#else
+        std::cout.flush();
+#endif
+    }
+};
+#endif
+
+}
+
+void FileStreamer::writeStdout(const char* data, std::size_t size) {
+#ifdef OS_LINUX
+    writeAll(STDOUT_FILENO, data, size);
+#else
+    ConsoleWriter console;
+    console.write(data, size);
+    console.flush();
+#endif
+}
+
+std::uint64_t FileStreamer::fileSize(const fs::path& path) {
+    return static_cast<std::uint64_t>(fs::file_size(path));
+}
+
+StreamResult FileStreamer::streamRange(const fs::path& path, ByteRange range) {
+    StreamResult result;
+    std::uint64_t size = fileSize(path);
+    if (range.offset >= size) return result;
+    
+    std::uint64_t end = range.offset + std::min(range.length, size - range.offset);
+    
+#ifdef OS_LINUX
+    FileDescriptor in(openForReading(path));
+    int out = STDOUT_FILENO;
+    
+    struct stat outInfo;
+    bool isPipe = false;
+    bool isFileOrSocket = false;
+    if (::fstat(out, &outInfo) == 0) {
+        isPipe = S_ISFIFO(outInfo.st_mode);
+        isFileOrSocket = S_ISREG(outInfo.st_mode) || S_ISSOCK(outInfo.st_mode);
+    }
+    
+    ::posix_fadvise(in.get(), static_cast<off_t>(range.offset), static_cast<off_t>(end - range.offset), POSIX_FADV_SEQUENTIAL);
+    
+    std::uint64_t offset = range.offset;
+    if (isPipe) offset = streamWithSplice(in.get(), out, offset, end);
+    if (isPipe || isFileOrSocket) offset = streamWithSendfile(in.get(), out, offset, end);
+    offset = streamWithMmap(in.get(), out, offset, end);
+    
+    result.bytes = offset - range.offset;
+    if (result.bytes > 0) {
+        char last = '\n';
+        ::pread(in.get(), &last, 1, static_cast<off_t>(offset - 1));
+        result.endsWithNewline = last == '\n';
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw fs::filesystem_error("cannot open file", path, std::make_error_code(std::errc::permission_denied));
+    }
+    
+    in.seekg(static_cast<std::streamoff>(range.offset));
+    std::vector<char> buffer(scanBlock);
+    ConsoleWriter console;
+    std::uint64_t offset = range.offset;
+    char last = '\n';
+    
+    while (offset < end && in) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(end - offset, buffer.size()));
+        in.read(buffer.data(), static_cast<std::streamsize>(chunk));
+        std::streamsize readBytes = in.gcount();
+        if (readBytes <= 0) break;
+        
+        console.write(buffer.data(), static_cast<std::size_t>(readBytes));
+        last = buffer[static_cast<std::size_t>(readBytes - 1)];
+        offset += static_cast<std::uint64_t>(readBytes);
+    }
+    console.flush();
+    
+    result.bytes = offset - range.offset;
+    result.endsWithNewline = last == '\n';
+#endif
+    
+    Metrics::add(MetricCounter::BytesRead, result.bytes);
+    Metrics::add(MetricCounter::BytesWritten, result.bytes);
+    return result;
+}
+
+ByteRange FileStreamer::lineRange(const fs::path& path, std::uint64_t firstLine, std::uint64_t lastLine) {
+    ByteRange range;
+    std::uint64_t size = fileSize(path);
+    if (firstLine == 0) firstLine = 1;
+    if (lastLine < firstLine) return range;
+    
+    std::uint64_t start = firstLine == 1 ? 0 : size;
+    std::uint64_t end = size;
+    std::uint64_t line = 1;
+    
+#ifdef OS_LINUX
+    FileDescriptor in(openForReading(path));
+    scanForward(in.get(), 0, size, [&](std::uint64_t newline) {
+        ++line;
+        if (line == firstLine) start = newline + 1;
+        if (line == lastLine + 1) {
+            end = newline + 1;
+            return false;
+        }
+        return true;
+    });
+#else
+    std::ifstream in(path, std::ios::binary);
+    std::uint64_t offset = 0;
+    char c;
+    while (in.get(c)) {
+        ++offset;
+        if (c != '\n') continue;
+        ++line;
+        if (line == firstLine) start = offset;
+        if (line == lastLine + 1) {
+            end = offset;
+            break;
+        }
+    }
+#endif
+    
+    if (start < end) {
+        range.offset = start;
+        range.length = end - start;
+    }
+    return range;
+}
+
+ByteRange FileStreamer::tailBytes(const fs::path& path, std::uint64_t count) {
+    std::uint64_t size = fileSize(path);
+    ByteRange range;
+    range.offset = count >= size ? 0 : size - count;
+    range.length = size - range.offset;
+    return range;
+}
+
+ByteRange FileStreamer::tailLines(const fs::path& path, std::uint64_t count) {
+    std::uint64_t size = fileSize(path);
+    ByteRange range;
+    range.length = size;
+    if (count == 0) {
+        range.offset = size;
+        range.length = 0;
+        return range;
+    }
+    
+#ifdef OS_LINUX
+    FileDescriptor in(openForReading(path));
+    std::vector<char> buffer(scanBlock);
+    std::uint64_t end = size;
+    std::uint64_t found = 0;
+    
+    char last = 0;
+    if (size > 0 && ::pread(in.get(), &last, 1, static_cast<off_t>(size - 1)) == 1 && last == '\n') {
+        end = size - 1;
+    }
+    
+    while (end > 0) {
+        std::uint64_t chunkStart = end > buffer.size() ? end - buffer.size() : 0;
+        std::size_t chunk = static_cast<std::size_t>(end - chunkStart);
+        ssize_t readBytes = ::pread(in.get(), buffer.data(), chunk, static_cast<off_t>(chunkStart));
+        if (readBytes < 0 && errno == EINTR) continue;
+        if (readBytes != static_cast<ssize_t>(chunk)) break;
+        
+        for (std::size_t i = chunk; i > 0; --i) {
+            if (buffer[i - 1] == '\n' && ++found == count) {
+                range.offset = chunkStart + i;
+                range.length = size - range.offset;
+                return range;
+            }
+        }
+        end = chunkStart;
+    }
+#else
+    std::ifstream in(path, std::ios::binary);
+    std::vector<std::uint64_t> lineStarts{0};
+    std::uint64_t offset = 0;
+    char c;
+    while (in.get(c)) {
+        ++offset;
+        if (c == '\n' && offset < size) lineStarts.push_back(offset);
+    }
+    if (lineStarts.size() > count) {
+        range.offset = lineStarts[lineStarts.size() - count];
+        range.length = size - range.offset;
+        return range;
+    }
+#endif
+    
+    range.offset = 0;
+    return range;
+}
+
+bool FileStreamer::follow(const fs::path& path, std::uint64_t offset, int stopFd) {
+#ifdef OS_LINUX
+    int inotifyFd = ::inotify_init1(IN_CLOEXEC);
+    if (inotifyFd < 0) return false;
+    FileDescriptor notify(inotifyFd);
+    
+    if (::inotify_add_watch(inotifyFd, path.c_str(), IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+        throw fs::filesystem_error("cannot watch file", path, std::error_code(errno, std::generic_category()));
+    }
+    
+    std::vector<char> events(4096);
+    pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopFd, POLLIN, 0}};
+    
+    while (true) {
+        std::error_code error;
+        std::uint64_t size = static_cast<std::uint64_t>(fs::file_size(path, error));
+        if (error) return true;
+        
+        if (size < offset) offset = 0;
+        if (size > offset) {
+            offset += streamRange(path, {offset, size - offset}).bytes;
+        }
+        
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return true;
+        }
+        if (fds[1].revents) return true;
+        
+        ssize_t readBytes = ::read(inotifyFd, events.data(), events.size());
+        for (ssize_t position = 0; position < readBytes;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(events.data() + position);
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) return true;
+            position += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+#else
+    (void)path;
+    (void)offset;
+    (void)stopFd;
+    return false;
+#endif
+}
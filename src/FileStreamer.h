@@ -0,0 +1,30 @@
+#ifndef FILE_STREAMER_H
+#define FILE_STREAMER_H
+
+#include <filesystem>
+#include <cstdint>
+
+namespace fs = std::filesystem;
+
+struct ByteRange {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+};
+
+struct StreamResult {
+    std::uint64_t bytes = 0;
+    bool endsWithNewline = true;
+};
+
+class FileStreamer {
+public:
+    static std::uint64_t fileSize(const fs::path& path);
+    static void writeStdout(const char* data, std::size_t size);
+    static StreamResult streamRange(const fs::path& path, ByteRange range);
+    static ByteRange lineRange(const fs::path& path, std::uint64_t firstLine, std::uint64_t lastLine);
+    static ByteRange tailLines(const fs::path& path, std::uint64_t count);
+    static ByteRange tailBytes(const fs::path& path, std::uint64_t count);
+    static bool follow(const fs::path& path, std::uint64_t offset, int stopFd);
+};
+
+#endif
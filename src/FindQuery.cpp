@@ -0,0 +1,339 @@
+#include "FindQuery.h"
+#include "Metrics.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <chrono>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+const unsigned sizeField = 1;
+const unsigned mtimeField = 2;
+const int metadataCost = 10;
+
+unsigned typeBit(EntryType type) {
+    return 1u << static_cast<unsigned>(type);
+}
+
+const std::string& argument(const std::vector<std::string>& tokens, std::size_t& position, const std::string& option) {
+    if (position >= tokens.size()) {
+        throw std::invalid_argument("ожидается значение после " + option);
+    }
+    return tokens[position++];
+}
+
+std::uint64_t parseNumber(const std::string& value, std::size_t first, std::size_t last, const std::string& token) {
+    std::uint64_t result = 0;
+    if (first >= last) throw std::invalid_argument("некорректное число: " + token);
+    
+    for (std::size_t i = first; i < last; ++i) {
+        if (value[i] < '0' || value[i] > '9' || result > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) {
+            throw std::invalid_argument("некорректное число: " + token);
+        }
+        result = result * 10 + static_cast<std::uint64_t>(value[i] - '0');
+    }
+    return result;
+}
+
+int parseComparison(const std::string& value, std::size_t& first) {
+    first = 0;
+    if (!value.empty() && (value[0] == '+' || value[0] == '-')) {
+        first = 1;
+        return value[0] == '+' ? 1 : -1;
+    }
+    return 0;
+}
+
+bool compare(std::int64_t actual, int comparison, std::uint64_t expected) {
+    if (comparison > 0) return actual > 0 && static_cast<std::uint64_t>(actual) > expected;
+    if (comparison < 0) return actual < 0 || static_cast<std::uint64_t>(actual) < expected;
+    return actual >= 0 && static_cast<std::uint64_t>(actual) == expected;
+}
+
+}
+
+FindQuery::FindQuery(const std::vector<std::string>& tokens)
+    : rootNode(0), minimumDepth(0), maximumDepth(std::numeric_limits<std::size_t>::max()), metadataFields(0),
+      now(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count()) {
+    std::size_t position = 0;
+    
+    if (tokens.empty()) {
+        rootNode = addNode(Node());
+    } else {
+        rootNode = parseOr(tokens, position);
+        if (position < tokens.size()) {
+            throw std::invalid_argument("лишний аргумент выражения: " + tokens[position]);
+        }
+    }
+    
+    optimize(rootNode);
+}
+
+bool FindQuery::isExpression(const std::string& token) {
+    return token == "(" || token == "!" || (token.size() > 1 && token[0] == '-');
+}
+
+std::size_t FindQuery::addNode(Node node) {
+    nodes.push_back(std::move(node));
+    return nodes.size() - 1;
+}
+
+std::size_t FindQuery::parseOr(const std::vector<std::string>& tokens, std::size_t& position) {
+    std::size_t left = parseAnd(tokens, position);
+    
+    while (position < tokens.size() && (tokens[position] == "-o" || tokens[position] == "-or")) {
+        ++position;
+        std::size_t right = parseAnd(tokens, position);
+        
+        Node node;
+        node.kind = Kind::Or;
+        node.children = {left, right};
+        left = addNode(std::move(node));
+    }
+    return left;
+}
+
+std::size_t FindQuery::parseAnd(const std::vector<std::string>& tokens, std::size_t& position) {
+    std::size_t left = parseUnary(tokens, position);
+    
+    while (position < tokens.size() && tokens[position] != "-o" && tokens[position] != "-or" && tokens[position] != ")") {
+        if (tokens[position] == "-a" || tokens[position] == "-and") ++position;
+        std::size_t right = parseUnary(tokens, position);
+        
+        Node node;
+        node.kind = Kind::And;
+        node.children = {left, right};
+        left = addNode(std::move(node));
+    }
+    return left;
+}
+
+std::size_t FindQuery::parseUnary(const std::vector<std::string>& tokens, std::size_t& position) {
+    if (position < tokens.size() && (tokens[position] == "!" || tokens[position] == "-not")) {
+        ++position;
+        Node node;
+        node.kind = Kind::Not;
+        node.children = {parseUnary(tokens, position)};
+        return addNode(std::move(node));
+    }
+    return parsePrimary(tokens, position);
+}
+
+std::size_t FindQuery::parsePrimary(const std::vector<std::string>& tokens, std::size_t& position) {
+    if (position >= tokens.size()) {
+        throw std::invalid_argument("выражение обрывается");
+    }
+    
+    const std::string token = tokens[position++];
+    Node node;
+    
+    if (token == "(") {
+        std::size_t inner = parseOr(tokens, position);
+        if (position >= tokens.size() || tokens[position] != ")") {
+            throw std::invalid_argument("ожидается ')'");
+        }
+        ++position;
+        return inner;
+    }
+    
+    if (token == "-name") {
+        node.kind = Kind::Name;
+        node.cost = 1;
+        node.matcher = matchers.size();
+        matchers.push_back(std::make_unique<GlobMatcher>(argument(tokens, position, token)));
+    } else if (token == "-type") {
+        const std::string& value = argument(tokens, position, token);
+        node.kind = Kind::Type;
+        for (std::size_t i = 0; i < value.size(); ++i) {
+            switch (value[i]) {
+                case 'f': node.types |= typeBit(EntryType::File); break;
+                case 'd': node.types |= typeBit(EntryType::Directory); break;
+                case 'l': node.types |= typeBit(EntryType::Symlink); break;
+                case 'o': node.types |= typeBit(EntryType::Other); break;
+                default: throw std::invalid_argument("неизвестный тип: " + value);
+            }
+            if (i + 1 < value.size() && value[++i] != ',') {
+                throw std::invalid_argument("неизвестный тип: " + value);
+            }
+        }
+        if (node.types == 0) throw std::invalid_argument("неизвестный тип: " + value);
+    } else if (token == "-size") {
+        const std::string& value = argument(tokens, position, token);
+        std::size_t first;
+        std::size_t last = value.size();
+        
+        node.kind = Kind::Size;
+        node.cost = metadataCost;
+        node.comparison = parseComparison(value, first);
+        node.unit = 512;
+        if (last > first && !(value[last - 1] >= '0' && value[last - 1] <= '9')) {
+            switch (value[--last]) {
+                case 'c': node.unit = 1; break;
+                case 'b': node.unit = 512; break;
+                case 'k': node.unit = 1024ull; break;
+                case 'M': node.unit = 1024ull * 1024; break;
+                case 'G': node.unit = 1024ull * 1024 * 1024; break;
+                case 'T': node.unit = 1024ull * 1024 * 1024 * 1024; break;
+                default: throw std::invalid_argument("некорректный размер: " + value);
+            }
+        }
+        node.value = parseNumber(value, first, last, value);
+        metadataFields |= sizeField;
+    } else if (token == "-mtime" || token == "-mmin") {
+        const std::string& value = argument(tokens, position, token);
+        std::size_t first;
+        
+        node.kind = Kind::ModifiedTime;
+        node.cost = metadataCost;
+        node.comparison = parseComparison(value, first);
+        node.unit = token == "-mtime" ? 24 * 60 * 60 : 60;
+        node.value = parseNumber(value, first, value.size(), value);
+        metadataFields |= mtimeField;
+    } else if (token == "-maxdepth" || token == "-mindepth") {
+        const std::string& value = argument(tokens, position, token);
+        std::size_t depth = static_cast<std::size_t>(parseNumber(value, 0, value.size(), value));
+        (token == "-maxdepth" ? maximumDepth : minimumDepth) = depth;
+    } else if (token == "-prune") {
+        pruneMatcher = std::make_unique<GlobMatcher>(argument(tokens, position, token));
+    } else if (token == "-true") {
+    } else {
+        throw std::invalid_argument("неизвестное условие: " + token);
+    }
+    
+    return addNode(std::move(node));
+}
+
+void FindQuery::optimize(std::size_t index) {
+    Node& node = nodes[index];
+    if (node.children.empty()) return;
+    
+    std::vector<std::size_t> children;
+    for (std::size_t child : node.children) {
+        optimize(child);
+        const Node& current = nodes[child];
+        if (current.kind == node.kind && node.kind != Kind::Not) {
+            children.insert(children.end(), current.children.begin(), current.children.end());
+        } else if (!(node.kind == Kind::And && current.kind == Kind::True)) {
+            children.push_back(child);
+        }
+    }
+    
+    std::stable_sort(children.begin(), children.end(),
+                     [this](std::size_t a, std::size_t b) { return nodes[a].cost < nodes[b].cost; });
+    
+    Node& updated = nodes[index];
+    updated.children = std::move(children);
+    updated.cost = 0;
+    for (std::size_t child : updated.children) {
+        updated.cost = std::max(updated.cost, nodes[child].cost);
+    }
+}
+
+bool FindQuery::limitsDepth() const {
+    return minimumDepth > 0 || maximumDepth != std::numeric_limits<std::size_t>::max();
+}
+
+std::size_t FindQuery::minDepth() const {
+    return minimumDepth;
+}
+
+std::size_t FindQuery::maxDepth() const {
+    return maximumDepth;
+}
+
+bool FindQuery::prunes(std::string_view name) const {
+    return pruneMatcher && pruneMatcher->matches(name);
+}
+
+bool FindQuery::matches(const WalkEntry& entry) const {
+    Metadata metadata;
+    return evaluate(rootNode, entry, metadata);
+}
+
+bool FindQuery::load(const WalkEntry& entry, Metadata& metadata) const {
+    if (metadata.loaded) return metadata.available;
+    metadata.loaded = true;
+    Metrics::add(MetricCounter::StatCalls);
+
+#ifdef OS_LINUX
+    int directoryFd = entry.directoryFd >= 0 ? entry.directoryFd : AT_FDCWD;
+    std::string path = entry.directoryFd >= 0 ? std::string() : entry.path();
+    const char* name = entry.directoryFd >= 0 ? entry.name : path.c_str();
+    
+    unsigned mask = 0;
+    if (metadataFields & sizeField) mask |= STATX_SIZE;
+    if (metadataFields & mtimeField) mask |= STATX_MTIME;
+    
+    struct statx info;
+    if (::statx(directoryFd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &info) == 0) {
+        metadata.size = info.stx_size;
+        metadata.mtime = info.stx_mtime.tv_sec;
+        metadata.available = (info.stx_mask & mask) == mask;
+    } else if (errno == ENOSYS) {
+        struct stat fallback;
+        if (::fstatat(directoryFd, name, &fallback, AT_SYMLINK_NOFOLLOW) == 0) {
+            metadata.size = static_cast<std::uint64_t>(fallback.st_size);
+            metadata.mtime = fallback.st_mtime;
+            metadata.available = true;
+        }
+    }
+#else
+    std::error_code error;
+    fs::path path = entry.path();
+    if (metadataFields & sizeField) {
+        metadata.size = entry.type == EntryType::File ? fs::file_size(path, error) : 0;
+    }
+    if (!error && (metadataFields & mtimeField)) {
+        auto time = fs::last_write_time(path, error);
+        auto system = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+            time - fs::file_time_type::clock::now() + std::chrono::system_clock::now());
+        metadata.mtime = std::chrono::duration_cast<std::chrono::seconds>(system.time_since_epoch()).count();
+    }
+    metadata.available = !error;
+#endif
+
+    if (!metadata.available) Metrics::add(MetricCounter::Errors);
+    return metadata.available;
+}
+
+bool FindQuery::evaluate(std::size_t index, const WalkEntry& entry, Metadata& metadata) const {
+    const Node& node = nodes[index];
+    
+    switch (node.kind) {
+        case Kind::True:
+            return true;
+        case Kind::Name:
+            return matchers[node.matcher]->matches(std::string_view(entry.name, entry.nameLength));
+        case Kind::Type:
+            return (node.types & typeBit(entry.type)) != 0;
+        case Kind::Size:
+            if (!load(entry, metadata)) return false;
+            return compare(static_cast<std::int64_t>((metadata.size + node.unit - 1) / node.unit), node.comparison, node.value);
+        case Kind::ModifiedTime: {
+            if (!load(entry, metadata)) return false;
+            std::int64_t age = now - metadata.mtime;
+            std::int64_t unit = static_cast<std::int64_t>(node.unit);
+            std::int64_t periods = age >= 0 ? age / unit : -((-age + unit - 1) / unit);
+            return compare(periods, node.comparison, node.value);
+        }
+        case Kind::Not:
+            return !evaluate(node.children[0], entry, metadata);
+        case Kind::And:
+            for (std::size_t child : node.children) {
+                if (!evaluate(child, entry, metadata)) return false;
+            }
+            return true;
+        case Kind::Or:
+            for (std::size_t child : node.children) {
+                if (evaluate(child, entry, metadata)) return true;
+            }
+            return false;
+    }
+    return false;
+}
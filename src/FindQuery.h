@@ -0,0 +1,77 @@
+#ifndef FIND_QUERY_H
+#define FIND_QUERY_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "DirectoryWalker.h"
+#include "GlobMatcher.h"
+
+class FindQuery {
+private:
+    enum class Kind {
+        True,
+        Name,
+        Type,
+        Size,
+        ModifiedTime,
+        Not,
+        And,
+        Or
+    };
+    
+    struct Node {
+        Kind kind = Kind::True;
+        int cost = 0;
+        std::size_t matcher = 0;
+        unsigned types = 0;
+        int comparison = 0;
+        std::uint64_t value = 0;
+        std::uint64_t unit = 1;
+        std::vector<std::size_t> children;
+    };
+    
+    struct Metadata {
+        bool loaded = false;
+        bool available = false;
+        std::uint64_t size = 0;
+        std::int64_t mtime = 0;
+    };
+    
+    std::vector<Node> nodes;
+    std::vector<std::unique_ptr<GlobMatcher>> matchers;
+    std::unique_ptr<GlobMatcher> pruneMatcher;
+    std::size_t rootNode;
+    std::size_t minimumDepth;
+    std::size_t maximumDepth;
+    unsigned metadataFields;
+    std::int64_t now;
+    
+    std::size_t addNode(Node node);
+    std::size_t parseOr(const std::vector<std::string>& tokens, std::size_t& position);
+    std::size_t parseAnd(const std::vector<std::string>& tokens, std::size_t& position);
+    std::size_t parseUnary(const std::vector<std::string>& tokens, std::size_t& position);
+    std::size_t parsePrimary(const std::vector<std::string>& tokens, std::size_t& position);
+    void optimize(std::size_t index);
+    
+    bool evaluate(std::size_t index, const WalkEntry& entry, Metadata& metadata) const;
+    bool load(const WalkEntry& entry, Metadata& metadata) const;
+    
+public:
+    explicit FindQuery(const std::vector<std::string>& tokens);
+    
+    FindQuery(const FindQuery&) = delete;
+    FindQuery& operator=(const FindQuery&) = delete;
+    
+    static bool isExpression(const std::string& token);
+    
+    bool limitsDepth() const;
+    std::size_t minDepth() const;
+    std::size_t maxDepth() const;
+    bool prunes(std::string_view name) const;
+    bool matches(const WalkEntry& entry) const;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "GlobMatcher.h"
+#include <algorithm>
+
+namespace {
+
+std::string collapseStars(const std::string& pattern) {
+    std::string result;
+    result.reserve(pattern.size());
+    for (char c : pattern) {
+        if (c == '*' && !result.empty() && result.back() == '*') continue;
+        result += c;
+    }
+    return result;
+}
+
+bool startsWith(std::string_view name, const std::string& prefix) {
+    return name.size() >= prefix.size() && name.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(std::string_view name, const std::string& suffix) {
+    return name.size() >= suffix.size() &&
+           name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+void shiftOr(const std::vector<std::uint64_t>& source, std::vector<std::uint64_t>& target) {
+    std::uint64_t carry = 0;
+    for (std::size_t w = 0; w < source.size(); ++w) {
+        target[w] |= (source[w] << 1) | carry;
+        carry = source[w] >> 63;
+    }
+}
+
+}
+
+GlobMatcher::GlobMatcher(const std::string& pattern) : GlobMatcher(std::vector<std::string>{pattern}) {}
+
+GlobMatcher::GlobMatcher(const std::vector<std::string>& patterns) : patterns(patterns), matchAll(false), stateWords(0) {
+    std::vector<std::string> generalPatterns;
+    
+    for (const auto& pattern : patterns) {
+        compile(pattern, generalPatterns);
+    }
+    
+    for (const auto& name : exactNames) {
+        exact.insert(name);
+    }
+    
+    buildAutomaton(generalPatterns);
+}
+
+const std::vector<std::string>& GlobMatcher::sourcePatterns() const {
+    return patterns;
+}
+
+void GlobMatcher::compile(const std::string& rawPattern, std::vector<std::string>& generalPatterns) {
+    std::string pattern = collapseStars(rawPattern);
+    
+    if (pattern == "*") {
+        matchAll = true;
+        return;
+    }
+    
+    bool hasQuestion = pattern.find('?') != std::string::npos;
+    std::size_t stars = static_cast<std::size_t>(std::count(pattern.begin(), pattern.end(), '*'));
+    
+    if (stars == 0 && !hasQuestion) {
+        exactNames.push_back(pattern);
+        return;
+    }
+    
+    if (!hasQuestion && stars <= 2) {
+        std::size_t first = pattern.find('*');
+        std::size_t last = pattern.rfind('*');
+        std::string head = pattern.substr(0, first);
+        std::string tail = pattern.substr(last + 1);
+        
+        SimplePattern simplePattern;
+        if (stars == 1) {
+            simplePattern.prefix = head;
+            simplePattern.suffix = tail;
+            if (tail.empty()) {
+                simplePattern.shape = Shape::Prefix;
+                prefixBuckets[static_cast<unsigned char>(head[0])].push_back(simple.size());
+            } else if (head.empty()) {
+                simplePattern.shape = Shape::Suffix;
+                suffixBuckets[static_cast<unsigned char>(tail.back())].push_back(simple.size());
+            } else {
+                simplePattern.shape = Shape::PrefixSuffix;
+                otherSimple.push_back(simple.size());
+            }
+            simple.push_back(simplePattern);
+            return;
+        }
+        
+        if (head.empty() && tail.empty()) {
+            simplePattern.shape = Shape::Contains;
+            simplePattern.prefix = pattern.substr(1, last - 1);
+            otherSimple.push_back(simple.size());
+            simple.push_back(simplePattern);
+            return;
+        }
+    }
+    
+    generalPatterns.push_back(pattern);
+}
+
+void GlobMatcher::buildAutomaton(const std::vector<std::string>& generalPatterns) {
+    std::size_t states = 0;
+    for (const auto& pattern : generalPatterns) {
+        states += pattern.size() + 1;
+    }
+    
+    stateWords = (states + 63) / 64;
+    charMasks.assign(256 * stateWords, 0);
+    starMask.assign(stateWords, 0);
+    acceptMask.assign(stateWords, 0);
+    
+    std::size_t state = 0;
+    for (const auto& pattern : generalPatterns) {
+        GeneralPattern compiled;
+        compiled.startState = state;
+        compiled.hasStar = pattern.find('*') != std::string::npos;
+        compiled.minLength = pattern.size() - static_cast<std::size_t>(std::count(pattern.begin(), pattern.end(), '*'));
+        
+        std::size_t firstWildcard = pattern.find_first_of("*?");
+        std::size_t lastWildcard = pattern.find_last_of("*?");
+        compiled.prefix = pattern.substr(0, firstWildcard);
+        compiled.suffix = pattern.substr(lastWildcard + 1);
+        
+        std::size_t runStart = 0;
+        for (std::size_t i = 0; i <= pattern.size(); ++i) {
+            if (i == pattern.size() || pattern[i] == '*' || pattern[i] == '?') {
+                if (i - runStart > compiled.literal.size()) {
+                    compiled.literal = pattern.substr(runStart, i - runStart);
+                }
+                runStart = i + 1;
+            }
+        }
+        
+        for (char c : pattern) {
+            std::size_t word = state / 64;
+            std::uint64_t bit = std::uint64_t(1) << (state % 64);
+            
+            if (c == '*') {
+                starMask[word] |= bit;
+            } else if (c == '?') {
+                for (std::size_t value = 0; value < 256; ++value) {
+                    charMasks[value * stateWords + word] |= bit;
+                }
+            } else {
+                charMasks[static_cast<unsigned char>(c) * stateWords + word] |= bit;
+            }
+            ++state;
+        }
+        
+        acceptMask[state / 64] |= std::uint64_t(1) << (state % 64);
+        ++state;
+        
+        general.push_back(compiled);
+    }
+}
+
+bool GlobMatcher::matchSimple(const SimplePattern& pattern, std::string_view name) const {
+    switch (pattern.shape) {
+        case Shape::Prefix:
+            return startsWith(name, pattern.prefix);
+        case Shape::Suffix:
+            return endsWith(name, pattern.suffix);
+        case Shape::PrefixSuffix:
+            return name.size() >= pattern.prefix.size() + pattern.suffix.size() &&
+                   startsWith(name, pattern.prefix) && endsWith(name, pattern.suffix);
+        case Shape::Contains:
+            return name.find(pattern.prefix) != std::string_view::npos;
+    }
+    return false;
+}
+
+bool GlobMatcher::matchGeneral(std::string_view name) const {
+    thread_local std::vector<std::uint64_t> active;
+    thread_local std::vector<std::uint64_t> next;
+    thread_local std::vector<std::uint64_t> starred;
+    
+    active.assign(stateWords, 0);
+    bool anyCandidate = false;
+    
+    for (const auto& pattern : general) {
+        if (name.size() < pattern.minLength) continue;
+        if (!pattern.hasStar && name.size() != pattern.minLength) continue;
+        if (!startsWith(name, pattern.prefix) || !endsWith(name, pattern.suffix)) continue;
+        if (!pattern.literal.empty() && name.find(pattern.literal) == std::string_view::npos) continue;
+        
+        active[pattern.startState / 64] |= std::uint64_t(1) << (pattern.startState % 64);
+        anyCandidate = true;
+    }
+    
+    if (!anyCandidate) return false;
+    
+    starred.resize(stateWords);
+    next.resize(stateWords);
+    
+    for (std::size_t w = 0; w < stateWords; ++w) starred[w] = active[w] & starMask[w];
+    shiftOr(starred, active);
+    
+    for (char c : name) {
+        const std::uint64_t* mask = &charMasks[static_cast<unsigned char>(c) * stateWords];
+        std::uint64_t carry = 0;
+        bool alive = false;
+        
+        for (std::size_t w = 0; w < stateWords; ++w) {
+            std::uint64_t matched = active[w] & mask[w];
+            next[w] = (matched << 1) | carry | (active[w] & starMask[w]);
+            carry = matched >> 63;
+        }
+        
+        for (std::size_t w = 0; w < stateWords; ++w) starred[w] = next[w] & starMask[w];
+        shiftOr(starred, next);
+        
+        for (std::size_t w = 0; w < stateWords; ++w) alive |= next[w] != 0;
+        if (!alive) return false;
+        
+        active.swap(next);
+    }
+    
+    for (std::size_t w = 0; w < stateWords; ++w) {
+        if (active[w] & acceptMask[w]) return true;
+    }
+    return false;
+}
+
+bool GlobMatcher::matches(std::string_view name) const {
+    if (matchAll) return true;
+    
+    if (!exact.empty() && exact.count(name)) return true;
+    
+    if (!name.empty()) {
+        for (std::size_t index : prefixBuckets[static_cast<unsigned char>(name.front())]) {
+            if (startsWith(name, simple[index].prefix)) return true;
+        }
+        for (std::size_t index : suffixBuckets[static_cast<unsigned char>(name.back())]) {
+            if (endsWith(name, simple[index].suffix)) return true;
+        }
+    }
+    
+    for (std::size_t index : otherSimple) {
+        if (matchSimple(simple[index], name)) return true;
+    }
+    
+    return !general.empty() && matchGeneral(name);
+}
@@ -0,0 +1,68 @@
+#ifndef GLOB_MATCHER_H
+#define GLOB_MATCHER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <unordered_set>
+#include <cstdint>
+
+class GlobMatcher {
+private:
+    enum class Shape {
+        Prefix,
+        Suffix,
+        PrefixSuffix,
+        Contains
+    };
+    
+    struct SimplePattern {
+        Shape shape;
+        std::string prefix;
+        std::string suffix;
+    };
+    
+    struct GeneralPattern {
+        std::string prefix;
+        std::string suffix;
+        std::string literal;
+        std::size_t minLength;
+        bool hasStar;
+        std::size_t startState;
+    };
+    
+    std::vector<std::string> patterns;
+    bool matchAll;
+    
+    std::vector<std::string> exactNames;
+    std::unordered_set<std::string_view> exact;
+    
+    std::vector<SimplePattern> simple;
+    std::array<std::vector<std::size_t>, 256> prefixBuckets;
+    std::array<std::vector<std::size_t>, 256> suffixBuckets;
+    std::vector<std::size_t> otherSimple;
+    
+    std::vector<GeneralPattern> general;
+    std::size_t stateWords;
+    std::vector<std::uint64_t> charMasks;
+    std::vector<std::uint64_t> starMask;
+    std::vector<std::uint64_t> acceptMask;
+    
+    void compile(const std::string& pattern, std::vector<std::string>& generalPatterns);
+    void buildAutomaton(const std::vector<std::string>& generalPatterns);
+    bool matchSimple(const SimplePattern& pattern, std::string_view name) const;
+    bool matchGeneral(std::string_view name) const;
+    
+public:
+    explicit GlobMatcher(const std::vector<std::string>& patterns);
+    explicit GlobMatcher(const std::string& pattern);
+    
+    GlobMatcher(const GlobMatcher&) = delete;
+    GlobMatcher& operator=(const GlobMatcher&) = delete;
+    
+    bool matches(std::string_view name) const;
+    const std::vector<std::string>& sourcePatterns() const;
+};
+
+#endif
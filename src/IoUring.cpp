@@ -0,0 +1,347 @@
+#include "IoUring.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cerrno>
+
+#if defined(OS_LINUX) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_FILE_INDEX_ALLOC
+#define SFM_IO_URING 1
+#endif
+#endif
+#endif
+
+#ifdef SFM_IO_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+struct IoUring::Rings {
+    int fd = -1;
+    unsigned entries = 0;
+    
+    void* sqMap = MAP_FAILED;
+    std::size_t sqMapSize = 0;
+    void* cqMap = MAP_FAILED;
+    std::size_t cqMapSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqesSize = 0;
+    
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    
+    unsigned localTail = 0;
+    unsigned submittedTail = 0;
+    
+    ~Rings() {
+        if (sqes != MAP_FAILED) ::munmap(sqes, sqesSize);
+        if (cqMap != MAP_FAILED && cqMap != sqMap) ::munmap(cqMap, cqMapSize);
+        if (sqMap != MAP_FAILED) ::munmap(sqMap, sqMapSize);
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+namespace {
+
+template <typename T>
+T* at(void* base, std::uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+bool supportsOperations(int fd) {
+    std::vector<char> storage(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (::syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+    
+    for (int op : {IORING_OP_OPENAT, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE}) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+    }
+    return true;
+}
+
+}
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {}
+
+bool IoUring::open(unsigned entries, unsigned fileSlots, std::error_code& error) {
+    auto opened = std::make_unique<Rings>();
+    
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    opened->fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (opened->fd < 0) {
+        error = std::error_code(errno, std::generic_category());
+        return false;
+    }
+    
+    if (!supportsOperations(opened->fd)) {
+        error = std::make_error_code(std::errc::operation_not_supported);
+        return false;
+    }
+    
+    std::vector<int> slots(fileSlots, -1);
+    if (::syscall(__NR_io_uring_register, opened->fd, IORING_REGISTER_FILES, slots.data(), fileSlots) < 0) {
+        error = std::error_code(errno, std::generic_category());
+        return false;
+    }
+    
+    opened->sqMapSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    opened->cqMapSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        opened->sqMapSize = opened->cqMapSize = std::max(opened->sqMapSize, opened->cqMapSize);
+    }
+    
+    opened->sqMap = ::mmap(nullptr, opened->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                           opened->fd, IORING_OFF_SQ_RING);
+    if (opened->sqMap == MAP_FAILED) {
+        error = std::error_code(errno, std::generic_category());
+        return false;
+    }
+    
+    if (singleMap) {
+        opened->cqMap = opened->sqMap;
+    } else {
+        opened->cqMap = ::mmap(nullptr, opened->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                               opened->fd, IORING_OFF_CQ_RING);
+        if (opened->cqMap == MAP_FAILED) {
+            error = std::error_code(errno, std::generic_category());
+            return false;
+        }
+    }
+    
+    opened->sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, opened->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        opened->fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        error = std::error_code(errno, std::generic_category());
+        return false;
+    }
+    opened->sqes = static_cast<io_uring_sqe*>(sqes);
+    
+    opened->entries = params.sq_entries;
+    opened->sqHead = at<unsigned>(opened->sqMap, params.sq_off.head);
+    opened->sqTail = at<unsigned>(opened->sqMap, params.sq_off.tail);
+    opened->sqMask = *at<unsigned>(opened->sqMap, params.sq_off.ring_mask);
+    opened->sqArray = at<unsigned>(opened->sqMap, params.sq_off.array);
+    opened->cqHead = at<unsigned>(opened->cqMap, params.cq_off.head);
+    opened->cqTail = at<unsigned>(opened->cqMap, params.cq_off.tail);
+    opened->cqMask = *at<unsigned>(opened->cqMap, params.cq_off.ring_mask);
+    opened->cqes = at<io_uring_cqe>(opened->cqMap, params.cq_off.cqes);
+    opened->localTail = opened->submittedTail = *opened->sqTail;
+    
+    rings = std::move(opened);
+    if (fileSlots == 0 || !opensDirect()) {
+        rings.reset();
+        error = std::make_error_code(std::errc::operation_not_supported);
+        return false;
+    }
+    return true;
+}
+
+bool IoUring::opensDirect() {
+    std::uint64_t userData = 0;
+    int result = -1;
+    if (!prepareOpen("/", O_RDONLY | O_DIRECTORY, 0, 0, 0, false) || submit(1) != 0 || !popCompletion(userData, result)) {
+        return false;
+    }
+    if (result > 0) ::close(result);
+    if (result != 0) return false;
+    
+    if (!prepareClose(0, 0, false) || submit(1) != 0 || !popCompletion(userData, result)) return false;
+    return result == 0;
+}
+
+bool IoUring::isOpen() const {
+    return rings != nullptr;
+}
+
+unsigned IoUring::entries() const {
+    return rings ? rings->entries : 0;
+}
+
+unsigned IoUring::spaceLeft() const {
+    if (!rings) return 0;
+    unsigned head = __atomic_load_n(rings->sqHead, __ATOMIC_ACQUIRE);
+    return rings->entries - (rings->localTail - head);
+}
+
+void* IoUring::acquire(std::uint64_t userData, bool link) {
+    if (spaceLeft() == 0) return nullptr;
+    
+    unsigned index = rings->localTail & rings->sqMask;
+    io_uring_sqe* sqe = &rings->sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = userData;
+    if (link) sqe->flags |= IOSQE_IO_LINK;
+    
+    rings->sqArray[index] = index;
+    ++rings->localTail;
+    return sqe;
+}
+
+bool IoUring::prepareOpen(const char* path, int flags, unsigned mode, unsigned slot, std::uint64_t userData, bool link) {
+    auto* sqe = static_cast<io_uring_sqe*>(acquire(userData, link));
+    if (!sqe) return false;
+    
+    sqe->opcode = IORING_OP_OPENAT;
+    sqe->fd = AT_FDCWD;
+    sqe->addr = reinterpret_cast<std::uint64_t>(path);
+    sqe->len = mode;
+    sqe->open_flags = static_cast<std::uint32_t>(flags);
+    sqe->file_index = slot + 1;
+    return true;
+}
+
+bool IoUring::prepareRead(unsigned slot, void* buffer, unsigned length, std::uint64_t offset, std::uint64_t userData, bool link) {
+    auto* sqe = static_cast<io_uring_sqe*>(acquire(userData, link));
+    if (!sqe) return false;
+    
+    sqe->opcode = IORING_OP_READ;
+    sqe->flags |= IOSQE_FIXED_FILE;
+    sqe->fd = static_cast<int>(slot);
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe->len = length;
+    sqe->off = offset;
+    return true;
+}
+
+bool IoUring::prepareWrite(unsigned slot, const void* buffer, unsigned length, std::uint64_t offset, std::uint64_t userData, bool link) {
+    auto* sqe = static_cast<io_uring_sqe*>(acquire(userData, link));
+    if (!sqe) return false;
+    
+    sqe->opcode = IORING_OP_WRITE;
+    sqe->flags |= IOSQE_FIXED_FILE;
+    sqe->fd = static_cast<int>(slot);
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer);
+    sqe->len = length;
+    sqe->off = offset;
+    return true;
+}
+
+bool IoUring::prepareClose(unsigned slot, std::uint64_t userData, bool link) {
+    auto* sqe = static_cast<io_uring_sqe*>(acquire(userData, link));
+    if (!sqe) return false;
+    
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = slot + 1;
+    return true;
+}
+
+int IoUring::submit(unsigned waitFor) {
+    if (!rings) return ENOSYS;
+    
+    __atomic_store_n(rings->sqTail, rings->localTail, __ATOMIC_RELEASE);
+    
+    for (;;) {
+        unsigned pending = rings->localTail - rings->submittedTail;
+        unsigned flags = waitFor > 0 ? IORING_ENTER_GETEVENTS : 0;
+        long submitted = ::syscall(__NR_io_uring_enter, rings->fd, pending, waitFor, flags, nullptr, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        rings->submittedTail += static_cast<unsigned>(submitted);
+        return 0;
+    }
+}
+
+bool IoUring::withdraw(std::uint64_t& userData) {
+    if (!rings) return false;
+    
+    unsigned head = __atomic_load_n(rings->sqHead, __ATOMIC_ACQUIRE);
+    if (rings->localTail == head) return false;
+    
+    --rings->localTail;
+    userData = rings->sqes[rings->sqArray[rings->localTail & rings->sqMask]].user_data;
+    rings->submittedTail = head;
+    __atomic_store_n(rings->sqTail, rings->localTail, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool IoUring::popCompletion(std::uint64_t& userData, int& result) {
+    if (!rings) return false;
+    
+    unsigned head = *rings->cqHead;
+    if (head == __atomic_load_n(rings->cqTail, __ATOMIC_ACQUIRE)) return false;
+    
+    const io_uring_cqe& cqe = rings->cqes[head & rings->cqMask];
+    userData = cqe.user_data;
+    result = cqe.res;
+    __atomic_store_n(rings->cqHead, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+#else
+
+struct IoUring::Rings {};
+
+IoUring::IoUring() {}
+
+IoUring::~IoUring() {}
+
+bool IoUring::open(unsigned, unsigned, std::error_code& error) {
+    error = std::make_error_code(std::errc::function_not_supported);
+    return false;
+}
+
+bool IoUring::isOpen() const {
+    return false;
+}
+
+unsigned IoUring::entries() const {
+    return 0;
+}
+
+unsigned IoUring::spaceLeft() const {
+    return 0;
+}
+
+void* IoUring::acquire(std::uint64_t, bool) {
+    return nullptr;
+}
+
+bool IoUring::opensDirect() {
+    return false;
+}
+
+bool IoUring::prepareOpen(const char*, int, unsigned, unsigned, std::uint64_t, bool) {
+    return false;
+}
+
+bool IoUring::prepareRead(unsigned, void*, unsigned, std::uint64_t, std::uint64_t, bool) {
+    return false;
+}
+
+bool IoUring::prepareWrite(unsigned, const void*, unsigned, std::uint64_t, std::uint64_t, bool) {
+    return false;
+}
+
+bool IoUring::prepareClose(unsigned, std::uint64_t, bool) {
+    return false;
+}
+
+int IoUring::submit(unsigned) {
+    return ENOSYS;
+}
+
+bool IoUring::withdraw(std::uint64_t&) {
+    return false;
+}
+
+bool IoUring::popCompletion(std::uint64_t&, int&) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef IO_URING_H
+#define IO_URING_H
+
+#include <memory>
+#include <cstdint>
+#include <system_error>
+
+class IoUring {
+private:
+    struct Rings;
+    
+    std::unique_ptr<Rings> rings;
+    
+    void* acquire(std::uint64_t userData, bool link);
+    bool opensDirect();
+    
+public:
+    IoUring();
+    ~IoUring();
+    
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+    
+    bool open(unsigned entries, unsigned fileSlots, std::error_code& error);
+    bool isOpen() const;
+    unsigned entries() const;
+    unsigned spaceLeft() const;
+    
+    bool prepareOpen(const char* path, int flags, unsigned mode, unsigned slot, std::uint64_t userData, bool link);
+    bool prepareRead(unsigned slot, void* buffer, unsigned length, std::uint64_t offset, std::uint64_t userData, bool link);
+    bool prepareWrite(unsigned slot, const void* buffer, unsigned length, std::uint64_t offset, std::uint64_t userData, bool link);
+    bool prepareClose(unsigned slot, std::uint64_t userData, bool link);
+    
+    int submit(unsigned waitFor);
+    bool withdraw(std::uint64_t& userData);
+    bool popCompletion(std::uint64_t& userData, int& result);
+};
+
+#endif
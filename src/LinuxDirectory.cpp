@@ -0,0 +1,81 @@
+#include "LinuxDirectory.h"
+
+#ifdef OS_LINUX
+#include <unistd.h>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+FileDescriptor::FileDescriptor(int fd) : fd(fd) {}
+
+FileDescriptor::~FileDescriptor() {
+    if (fd >= 0) ::close(fd);
+}
+
+int FileDescriptor::get() const {
+    return fd;
+}
+
+int FileDescriptor::release() {
+    int released = fd;
+    fd = -1;
+    return released;
+}
+
+DirentReader::DirentReader(int fd, std::vector<char>& buffer) : fd(fd), buffer(buffer), filled(0), offset(0), failure(0), reads(0) {}
+
+const LinuxDirent64* DirentReader::next() {
+    while (true) {
+        while (offset < filled) {
+            const auto* record = reinterpret_cast<const LinuxDirent64*>(buffer.data() + offset);
+            offset += record->length;
+            
+            const char* name = record->name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+            return record;
+        }
+        
+        if (failure != 0 || filled < 0) return nullptr;
+        
+        long bytes = ::syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        ++reads;
+        if (bytes < 0) {
+            if (errno == EINTR) continue;
+            failure = errno;
+            return nullptr;
+        }
+        if (bytes == 0) {
+            filled = -1;
+            return nullptr;
+        }
+        filled = bytes;
+        offset = 0;
+    }
+}
+
+int DirentReader::error() const {
+    return failure;
+}
+
+std::uint64_t DirentReader::readCalls() const {
+    return reads;
+}
+
+EntryType entryTypeFromDirent(unsigned char type) {
+    switch (type) {
+        case DT_REG: return EntryType::File;
+        case DT_DIR: return EntryType::Directory;
+        case DT_LNK: return EntryType::Symlink;
+        case DT_UNKNOWN: return EntryType::Unknown;
+        default: return EntryType::Other;
+    }
+}
+
+EntryType entryTypeFromMode(unsigned mode) {
+    if (S_ISREG(mode)) return EntryType::File;
+    if (S_ISDIR(mode)) return EntryType::Directory;
+    if (S_ISLNK(mode)) return EntryType::Symlink;
+    return EntryType::Other;
+}
+#endif
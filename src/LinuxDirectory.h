@@ -0,0 +1,54 @@
+#ifndef LINUX_DIRECTORY_H
+#define LINUX_DIRECTORY_H
+
+#ifdef OS_LINUX
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+#include "DirectoryWalker.h"
+
+struct LinuxDirent64 {
+    ino64_t ino;
+    off64_t offset;
+    unsigned short length;
+    unsigned char type;
+    char name[1];
+};
+
+class FileDescriptor {
+private:
+    int fd;
+    
+public:
+    explicit FileDescriptor(int fd);
+    ~FileDescriptor();
+    
+    FileDescriptor(const FileDescriptor&) = delete;
+    FileDescriptor& operator=(const FileDescriptor&) = delete;
+    
+    int get() const;
+    int release();
+};
+
+class DirentReader {
+private:
+    int fd;
+    std::vector<char>& buffer;
+    long filled;
+    long offset;
+    int failure;
+    std::uint64_t reads;
+    
+public:
+    DirentReader(int fd, std::vector<char>& buffer);
+    
+    const LinuxDirent64* next();
+    int error() const;
+    std::uint64_t readCalls() const;
+};
+
+EntryType entryTypeFromDirent(unsigned char type);
+EntryType entryTypeFromMode(unsigned mode);
+#endif
+
+#endif
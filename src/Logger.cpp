@@ -0,0 +1,191 @@
+#include "Logger.h"
+#include <ctime>
+
+#ifdef OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+std::size_t roundUpPowerOfTwo(std::size_t value) {
+    std::size_t result = 2;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+}
+
+Logger::Logger(const LoggerOptions& loggerOptions)
+    : options(loggerOptions), logFile(nullptr), slots(roundUpPowerOfTwo(loggerOptions.capacity)),
+      mask(slots.size() - 1), enqueuePosition(0), dequeuePosition(0), pending(false), stopping(false),
+      cachedSeconds(-1) {
+    for (std::size_t i = 0; i < slots.size(); ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    
+    logFile = std::fopen(options.path.c_str(), "a");
+    if (!logFile) return;
+    
+    writer = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    if (!logFile) return;
+    
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_one();
+    writer.join();
+    
+    std::fclose(logFile);
+}
+
+bool Logger::parseDurability(const std::string& name, LogDurability& durability) {
+    if (name == "buffered") {
+        durability = LogDurability::Buffered;
+    } else if (name == "flush") {
+        durability = LogDurability::Flush;
+    } else if (name == "sync") {
+        durability = LogDurability::Sync;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool Logger::tryPush(std::int64_t seconds, std::string& message) {
+    std::size_t position = enqueuePosition.load(std::memory_order_relaxed);
+    
+    while (true) {
+        Slot& slot = slots[position & mask];
+        std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+        std::intptr_t difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+        
+        if (difference == 0) {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                slot.seconds = seconds;
+                slot.message = std::move(message);
+                slot.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::wakeWriter() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        if (pending) return;
+        pending = true;
+    }
+    wakeCondition.notify_one();
+}
+
+void Logger::log(std::string message) {
+    if (!logFile) return;
+    
+    std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    
+    while (!tryPush(seconds, message)) {
+        wakeWriter();
+        std::this_thread::yield();
+    }
+    
+    std::size_t queued = enqueuePosition.load(std::memory_order_relaxed) - dequeuePosition.load(std::memory_order_relaxed);
+    if (queued > slots.size() / 2 || options.flushInterval.count() <= 0) {
+        wakeWriter();
+    }
+}
+
+const std::string& Logger::prefixFor(std::int64_t seconds) {
+    if (seconds == cachedSeconds) return cachedPrefix;
+    
+    std::time_t time = static_cast<std::time_t>(seconds);
+    std::tm timeInfo;
+#ifdef OS_WINDOWS
+    localtime_s(&timeInfo, &time);
+#else
+    localtime_r(&time, &timeInfo);
+#endif
+    
+    char buffer[32];
+    std::size_t length = std::strftime(buffer, sizeof(buffer), "[%Y-%m-%d %H:%M:%S] ", &timeInfo);
+    cachedPrefix.assign(buffer, length);
+    cachedSeconds = seconds;
+    return cachedPrefix;
+}
+
+std::size_t Logger::drain(std::string& batch) {
+    std::size_t count = 0;
+    
+    while (true) {
+        std::size_t position = dequeuePosition.load(std::memory_order_relaxed);
+        Slot& slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) break;
+        
+        batch += prefixFor(slot.seconds);
+        batch += slot.message;
+        batch += '\n';
+        slot.message.clear();
+        
+        slot.sequence.store(position + slots.size(), std::memory_order_release);
+        dequeuePosition.store(position + 1, std::memory_order_relaxed);
+        ++count;
+    }
+    
+    return count;
+}
+
+void Logger::writerLoop() {
+    std::string batch;
+    
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            auto woken = [this]() { return pending || stopping.load(); };
+            if (options.flushInterval.count() > 0) {
+                wakeCondition.wait_for(lock, options.flushInterval, woken);
+            } else {
+                wakeCondition.wait(lock, woken);
+            }
+            pending = false;
+        }
+        
+        bool finalPass = stopping;
+        batch.clear();
+        
+        if (drain(batch) > 0) {
+            std::fwrite(batch.data(), 1, batch.size(), logFile);
+            
+            if (options.durability != LogDurability::Buffered) {
+                std::fflush(logFile);
+            }
+#ifdef OS_LINUX
+            if (options.durability == LogDurability::Sync) {
+                ::fdatasync(fileno(logFile));
+            }
+#endif
+        }
+        
+        if (finalPass) {
+            batch.clear();
+            if (drain(batch) > 0) {
+                std::fwrite(batch.data(), 1, batch.size(), logFile);
+            }
+            std::fflush(logFile);
+#ifdef OS_LINUX
+            if (options.durability == LogDurability::Sync) {
+                ::fdatasync(fileno(logFile));
+            }
+#endif
+            return;
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+enum class LogDurability {
+    Buffered,
+    Flush,
+    Sync
+};
+
+struct LoggerOptions {
+    std::string path = "log.txt";
+    std::chrono::milliseconds flushInterval = std::chrono::milliseconds(200);
+    LogDurability durability = LogDurability::Flush;
+    std::size_t capacity = 8192;
+};
+
+class Logger {
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        std::int64_t seconds;
+        std::string message;
+    };
+    
+    LoggerOptions options;
+    std::FILE* logFile;
+    
+    std::vector<Slot> slots;
+    std::size_t mask;
+    std::atomic<std::size_t> enqueuePosition;
+    std::atomic<std::size_t> dequeuePosition;
+    
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool pending;
+    std::atomic<bool> stopping;
+    std::thread writer;
+    
+    std::int64_t cachedSeconds;
+    std::string cachedPrefix;
+    
+    bool tryPush(std::int64_t seconds, std::string& message);
+    std::size_t drain(std::string& batch);
+    const std::string& prefixFor(std::int64_t seconds);
+    void wakeWriter();
+    void writerLoop();
+    
+public:
+    explicit Logger(const LoggerOptions& options = LoggerOptions());
+    ~Logger();
+    
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    
+    void log(std::string message);
+    
+    static bool parseDurability(const std::string& name, LogDurability& durability);
+};
+
+#endif
@@ -0,0 +1,270 @@
+#include "Metrics.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdio>
+#include <algorithm>
+
+namespace {
+
+struct alignas(64) PaddedCounter {
+    std::atomic<std::uint64_t> value{0};
+};
+
+struct Registry {
+    std::array<PaddedCounter, static_cast<std::size_t>(MetricCounter::Count)> counters;
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<LatencyHistogram>> histograms;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+unsigned highestBit(std::uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63u - static_cast<unsigned>(__builtin_clzll(value));
+#else
+    unsigned bit = 0;
+    while (value >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+std::string formatDuration(std::uint64_t nanoseconds) {
+    char buffer[32];
+    double value = static_cast<double>(nanoseconds);
+    if (nanoseconds < 10000) {
+        std::snprintf(buffer, sizeof(buffer), "%.0fns", value);
+    } else if (nanoseconds < 10000000) {
+        std::snprintf(buffer, sizeof(buffer), "%.1fus", value / 1e3);
+    } else if (nanoseconds < 10000000000ull) {
+        std::snprintf(buffer, sizeof(buffer), "%.1fms", value / 1e6);
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.2fs", value / 1e9);
+    }
+    return buffer;
+}
+
+void updateMax(std::atomic<std::uint64_t>& max, std::uint64_t value) {
+    std::uint64_t current = max.load(std::memory_order_relaxed);
+    while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() : count(0), sum(0), max(0) {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+}
+
+std::size_t LatencyHistogram::bucketFor(std::uint64_t nanoseconds) {
+    if (nanoseconds < 4) return static_cast<std::size_t>(nanoseconds);
+    
+    unsigned bit = highestBit(nanoseconds);
+    std::uint64_t sub = (nanoseconds >> (bit - 2)) & 3;
+    return static_cast<std::size_t>((bit - 1) * 4 + sub);
+}
+
+std::uint64_t LatencyHistogram::bucketUpperBound(std::size_t bucket) {
+    if (bucket < 4) return bucket;
+    
+    unsigned bit = static_cast<unsigned>(bucket / 4 + 1);
+    std::uint64_t sub = bucket % 4;
+    std::uint64_t lower = (4 + sub) << (bit - 2);
+    return lower + ((std::uint64_t(1) << (bit - 2)) - 1);
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds) {
+    buckets[bucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+    updateMax(max, nanoseconds);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& bucket : buckets) bucket.store(0, std::memory_order_relaxed);
+    count.store(0, std::memory_order_relaxed);
+    sum.store(0, std::memory_order_relaxed);
+    max.store(0, std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::samples() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::total() const {
+    return sum.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::maximum() const {
+    return max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::bucketSamples(std::size_t bucket) const {
+    return buckets[bucket].load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyHistogram::percentile(double fraction) const {
+    std::uint64_t total = 0;
+    for (const auto& bucket : buckets) total += bucket.load(std::memory_order_relaxed);
+    if (total == 0) return 0;
+    
+    std::uint64_t rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5);
+    if (rank == 0) rank = 1;
+    
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < bucketCount; ++i) {
+        seen += buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(bucketUpperBound(i), maximum());
+    }
+    return maximum();
+}
+
+MetricTimer::MetricTimer(LatencyHistogram& histogram) : histogram(histogram), started(std::chrono::steady_clock::now()) {}
+
+MetricTimer::~MetricTimer() {
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    histogram.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+void Metrics::add(MetricCounter counter, std::uint64_t value) {
+    registry().counters[static_cast<std::size_t>(counter)].value.fetch_add(value, std::memory_order_relaxed);
+}
+
+std::uint64_t Metrics::value(MetricCounter counter) {
+    return registry().counters[static_cast<std::size_t>(counter)].value.load(std::memory_order_relaxed);
+}
+
+const char* Metrics::counterName(MetricCounter counter) {
+    switch (counter) {
+        case MetricCounter::Commands: return "commands";
+        case MetricCounter::Errors: return "errors";
+        case MetricCounter::EntriesVisited: return "entries_visited";
+        case MetricCounter::DirectoryReads: return "directory_reads";
+        case MetricCounter::StatCalls: return "stat_calls";
+        case MetricCounter::BytesRead: return "bytes_read";
+        case MetricCounter::BytesWritten: return "bytes_written";
+        case MetricCounter::FilesCopied: return "files_copied";
+        case MetricCounter::EntriesRemoved: return "entries_removed";
+        default: return "unknown";
+    }
+}
+
+LatencyHistogram& Metrics::histogram(const std::string& name) {
+    Registry& instance = registry();
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    
+    auto& slot = instance.histograms[name];
+    if (!slot) slot = std::make_unique<LatencyHistogram>();
+    return *slot;
+}
+
+void Metrics::reset() {
+    Registry& instance = registry();
+    for (auto& counter : instance.counters) counter.value.store(0, std::memory_order_relaxed);
+    
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    for (auto& entry : instance.histograms) entry.second->reset();
+    instance.started = std::chrono::steady_clock::now();
+}
+
+std::string Metrics::formatText() {
+    Registry& instance = registry();
+    std::string text;
+    char line[256];
+    
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - instance.started).count();
+    std::snprintf(line, sizeof(line), "Время сбора: %.1f с\n", uptime);
+    text += line;
+    
+    text += "Счетчики:\n";
+    for (std::size_t i = 0; i < instance.counters.size(); ++i) {
+        auto counter = static_cast<MetricCounter>(i);
+        std::snprintf(line, sizeof(line), "  %-20s %20llu\n", counterName(counter),
+                      static_cast<unsigned long long>(value(counter)));
+        text += line;
+    }
+    
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    if (instance.histograms.empty()) return text;
+    
+    std::snprintf(line, sizeof(line), "Задержки:\n  %-20s %10s %10s %10s %10s %10s %10s\n",
+                  "", "count", "mean", "p50", "p90", "p99", "max");
+    text += line;
+    
+    for (const auto& entry : instance.histograms) {
+        const LatencyHistogram& histogram = *entry.second;
+        std::uint64_t samples = histogram.samples();
+        if (samples == 0) continue;
+        
+        std::snprintf(line, sizeof(line), "  %-20s %10llu %10s %10s %10s %10s %10s\n",
+                      entry.first.c_str(),
+                      static_cast<unsigned long long>(samples),
+                      formatDuration(histogram.total() / samples).c_str(),
+                      formatDuration(histogram.percentile(0.50)).c_str(),
+                      formatDuration(histogram.percentile(0.90)).c_str(),
+                      formatDuration(histogram.percentile(0.99)).c_str(),
+                      formatDuration(histogram.maximum()).c_str());
+        text += line;
+    }
+    
+    return text;
+}
+
+std::string Metrics::formatJson() {
+    Registry& instance = registry();
+    std::string json;
+    char buffer[128];
+    
+    double uptime = std::chrono::duration<double>(std::chrono::steady_clock::now() - instance.started).count();
+    std::snprintf(buffer, sizeof(buffer), "{\"uptime_seconds\":%.3f,\"counters\":{", uptime);
+    json += buffer;
+    
+    for (std::size_t i = 0; i < instance.counters.size(); ++i) {
+        auto counter = static_cast<MetricCounter>(i);
+        std::snprintf(buffer, sizeof(buffer), "%s\"%s\":%llu", i ? "," : "", counterName(counter),
+                      static_cast<unsigned long long>(value(counter)));
+        json += buffer;
+    }
+    json += "},\"histograms\":{";
+    
+    std::lock_guard<std::mutex> lock(instance.mutex);
+    bool first = true;
+    for (const auto& entry : instance.histograms) {
+        const LatencyHistogram& histogram = *entry.second;
+        
+        json += first ? "\"" : ",\"";
+        json += entry.first;
+        first = false;
+        
+        std::snprintf(buffer, sizeof(buffer), "\":{\"count\":%llu,\"sum_ns\":%llu,\"max_ns\":%llu",
+                      static_cast<unsigned long long>(histogram.samples()),
+                      static_cast<unsigned long long>(histogram.total()),
+                      static_cast<unsigned long long>(histogram.maximum()));
+        json += buffer;
+        
+        std::snprintf(buffer, sizeof(buffer), ",\"p50_ns\":%llu,\"p90_ns\":%llu,\"p99_ns\":%llu,\"buckets\":[",
+                      static_cast<unsigned long long>(histogram.percentile(0.50)),
+                      static_cast<unsigned long long>(histogram.percentile(0.90)),
+                      static_cast<unsigned long long>(histogram.percentile(0.99)));
+        json += buffer;
+        
+        bool firstBucket = true;
+        for (std::size_t i = 0; i < LatencyHistogram::bucketCount; ++i) {
+            std::uint64_t samples = histogram.bucketSamples(i);
+            if (samples == 0) continue;
+            std::snprintf(buffer, sizeof(buffer), "%s[%llu,%llu]", firstBucket ? "" : ",",
+                          static_cast<unsigned long long>(LatencyHistogram::bucketUpperBound(i)),
+                          static_cast<unsigned long long>(samples));
+            json += buffer;
+            firstBucket = false;
+        }
+        json += "]}";
+    }
+    json += "}}\n";
+    
+    return json;
+}
@@ -0,0 +1,76 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <string>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum class MetricCounter {
+    Commands,
+    Errors,
+    EntriesVisited,
+    DirectoryReads,
+    StatCalls,
+    BytesRead,
+    BytesWritten,
+    FilesCopied,
+    EntriesRemoved,
+    Count
+};
+
+class LatencyHistogram {
+public:
+    static const std::size_t bucketCount = 252;
+    
+private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets;
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> sum;
+    std::atomic<std::uint64_t> max;
+    
+    static std::size_t bucketFor(std::uint64_t nanoseconds);
+    
+public:
+    LatencyHistogram();
+    
+    void record(std::uint64_t nanoseconds);
+    void reset();
+    
+    std::uint64_t samples() const;
+    std::uint64_t total() const;
+    std::uint64_t maximum() const;
+    std::uint64_t percentile(double fraction) const;
+    std::uint64_t bucketSamples(std::size_t bucket) const;
+    
+    static std::uint64_t bucketUpperBound(std::size_t bucket);
+};
+
+class MetricTimer {
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point started;
+    
+public:
+    explicit MetricTimer(LatencyHistogram& histogram);
+    ~MetricTimer();
+    
+    MetricTimer(const MetricTimer&) = delete;
+    MetricTimer& operator=(const MetricTimer&) = delete;
+};
+
+class Metrics {
+public:
+    static void add(MetricCounter counter, std::uint64_t value = 1);
+    static std::uint64_t value(MetricCounter counter);
+    static const char* counterName(MetricCounter counter);
+    
+    static LatencyHistogram& histogram(const std::string& name);
+    
+    static void reset();
+    static std::string formatText();
+    static std::string formatJson();
+};
+
+#endif
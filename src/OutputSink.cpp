@@ -0,0 +1,290 @@
+#include "OutputSink.h"
+#include <filesystem>
+#include <charconv>
+
+namespace {
+
+std::size_t validSequence(std::string_view text, std::size_t position) {
+    unsigned char lead = static_cast<unsigned char>(text[position]);
+    std::size_t length = 0;
+    unsigned char low = 0x80;
+    unsigned char high = 0xbf;
+    
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        length = 2;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        length = 3;
+        if (lead == 0xe0) low = 0xa0;
+        if (lead == 0xed) high = 0x9f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        length = 4;
+        if (lead == 0xf0) low = 0x90;
+        if (lead == 0xf4) high = 0x8f;
+    } else {
+        return 0;
+    }
+    
+    if (text.size() - position < length) return 0;
+    for (std::size_t i = 1; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[position + i]);
+        if (c < low || c > high) return 0;
+        low = 0x80;
+        high = 0xbf;
+    }
+    return length;
+}
+
+const char* typeName(EntryType type) {
+    switch (type) {
+        case EntryType::File: return "file";
+        case EntryType::Directory: return "directory";
+        case EntryType::Symlink: return "symlink";
+        case EntryType::Other: return "other";
+        default: return "unknown";
+    }
+}
+
+}
+
+OutputSink::OutputSink(OutputFormat format, Writer writer, std::size_t capacity)
+    : format(format), writer(std::move(writer)), capacity(capacity) {
+    buffer.reserve(capacity + 4096);
+}
+
+OutputSink::~OutputSink() {
+    try {
+        flush();
+    } catch (...) {
+    }
+}
+
+OutputFormat OutputSink::outputFormat() const {
+    return format;
+}
+
+void OutputSink::appendEscaped(std::string& output, std::string_view text) {
+    static const char hex[] = "0123456789abcdef";
+    
+    std::size_t start = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x80) {
+            std::size_t length = validSequence(text, i);
+            if (length > 0) {
+                i += length - 1;
+                continue;
+            }
+        } else if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        
+        output.append(text.data() + start, i - start);
+        start = i + 1;
+        
+        switch (c) {
+            case '"': output += "\\\""; break;
+            case '\\': output += "\\\\"; break;
+            case '\n': output += "\\n"; break;
+            case '\r': output += "\\r"; break;
+            case '\t': output += "\\t"; break;
+            default:
+                output += "\\u00";
+                output += hex[c >> 4];
+                output += hex[c & 0xf];
+        }
+    }
+    
+    output.append(text.data() + start, text.size() - start);
+}
+
+void OutputSink::appendJson(std::string& output, std::string_view text) {
+    output += '"';
+    appendEscaped(output, text);
+    output += '"';
+}
+
+void OutputSink::appendNumber(std::string& output, std::uint64_t value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    output.append(digits, result.ptr);
+}
+
+void OutputSink::commit() {
+    if (buffer.size() >= capacity) flush();
+}
+
+void OutputSink::message(std::string_view text) {
+    if (format == OutputFormat::NulSeparated) return;
+    
+    if (format == OutputFormat::JsonLines) {
+        buffer += "{\"message\":";
+        appendJson(buffer, text);
+        buffer += "}\n";
+    } else {
+        buffer.append(text.data(), text.size());
+        buffer += '\n';
+    }
+    commit();
+}
+
+void OutputSink::entry(const ListEntry& entry, bool longFormat) {
+    if (format == OutputFormat::Text) {
+        DirectoryLister::render(buffer, entry, longFormat);
+    } else if (format == OutputFormat::NulSeparated) {
+        buffer.append(entry.name.data(), entry.name.size());
+        buffer += '\0';
+    } else {
+        buffer += "{\"name\":";
+        appendJson(buffer, entry.name);
+        buffer += ",\"type\":\"";
+        buffer += typeName(entry.targetType);
+        buffer += '"';
+        if (entry.known) {
+            char digits[24];
+            auto result = std::to_chars(digits, digits + sizeof(digits), entry.mtime);
+            buffer += ",\"size\":";
+            appendNumber(buffer, entry.size);
+            buffer += ",\"mtime\":";
+            buffer.append(digits, result.ptr);
+            buffer += ",\"mode\":";
+            appendNumber(buffer, entry.mode & 07777);
+        }
+        buffer += "}\n";
+    }
+    commit();
+}
+
+void OutputSink::appendPath(std::string& output, std::string_view directory, std::string_view name) const {
+    const char separator = static_cast<char>(std::filesystem::path::preferred_separator);
+    bool needsSeparator = !directory.empty() && directory.back() != separator;
+    
+    if (format == OutputFormat::JsonLines) {
+        output += "{\"path\":\"";
+        appendEscaped(output, directory);
+        if (needsSeparator) output += separator;
+        appendEscaped(output, name);
+        output += "\"}\n";
+        return;
+    }
+    
+    output.append(directory.data(), directory.size());
+    if (needsSeparator) output += separator;
+    output.append(name.data(), name.size());
+    output += format == OutputFormat::NulSeparated ? '\0' : '\n';
+}
+
+void OutputSink::path(std::string_view path) {
+    appendPath(buffer, std::string_view(), path);
+    commit();
+}
+
+void OutputSink::path(std::string_view directory, std::string_view name) {
+    appendPath(buffer, directory, name);
+    commit();
+}
+
+void OutputSink::match(std::string_view path, std::uint64_t line, std::string_view text) {
+    if (format == OutputFormat::NulSeparated) {
+        if (path == lastMatchPath) return;
+        lastMatchPath.assign(path.data(), path.size());
+        buffer.append(path.data(), path.size());
+        buffer += '\0';
+    } else if (format == OutputFormat::JsonLines) {
+        buffer += "{\"path\":";
+        appendJson(buffer, path);
+        buffer += ",\"line\":";
+        appendNumber(buffer, line);
+        buffer += ",\"text\":";
+        appendJson(buffer, text);
+        buffer += "}\n";
+    } else {
+        buffer.append(path.data(), path.size());
+        buffer += ':';
+        appendNumber(buffer, line);
+        buffer += ':';
+        buffer.append(text.data(), text.size());
+        buffer += '\n';
+    }
+    commit();
+}
+
+void OutputSink::group(std::size_t index, std::uint64_t size, const std::vector<std::string>& paths) {
+    if (format == OutputFormat::NulSeparated) {
+        for (const auto& path : paths) {
+            buffer += path;
+            buffer += '\0';
+        }
+    } else if (format == OutputFormat::JsonLines) {
+        buffer += "{\"group\":";
+        appendNumber(buffer, index);
+        buffer += ",\"size\":";
+        appendNumber(buffer, size);
+        buffer += ",\"paths\":[";
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            if (i) buffer += ',';
+            appendJson(buffer, paths[i]);
+        }
+        buffer += "]}\n";
+    } else {
+        buffer += "Группа ";
+        appendNumber(buffer, index);
+        buffer += ": ";
+        appendNumber(buffer, paths.size());
+        buffer += " x ";
+        appendNumber(buffer, size);
+        buffer += " байт\n";
+        for (const auto& path : paths) {
+            buffer += "  ";
+            buffer += path;
+            buffer += '\n';
+        }
+    }
+    commit();
+}
+
+void OutputSink::usage(std::string_view path, std::uint64_t allocated, std::uint64_t apparent) {
+    if (format == OutputFormat::NulSeparated) {
+        buffer.append(path.data(), path.size());
+        buffer += '\0';
+    } else if (format == OutputFormat::JsonLines) {
+        buffer += "{\"path\":";
+        appendJson(buffer, path);
+        buffer += ",\"allocated\":";
+        appendNumber(buffer, allocated);
+        buffer += ",\"apparent\":";
+        appendNumber(buffer, apparent);
+        buffer += "}\n";
+    } else {
+        appendNumber(buffer, allocated);
+        buffer += '\t';
+        appendNumber(buffer, apparent);
+        buffer += '\t';
+        buffer.append(path.data(), path.size());
+        buffer += '\n';
+    }
+    commit();
+}
+
+void OutputSink::write(std::string_view data) {
+    buffer.append(data.data(), data.size());
+    commit();
+}
+
+void OutputSink::flush() {
+    if (buffer.empty()) return;
+    writer(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+bool OutputSink::parseFormat(const std::string& name, OutputFormat& format) {
+    if (name == "text") {
+        format = OutputFormat::Text;
+    } else if (name == "json") {
+        format = OutputFormat::JsonLines;
+    } else if (name == "nul") {
+        format = OutputFormat::NulSeparated;
+    } else {
+        return false;
+    }
+    return true;
+}
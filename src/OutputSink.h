@@ -0,0 +1,58 @@
+#ifndef OUTPUT_SINK_H
+#define OUTPUT_SINK_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "DirectoryLister.h"
+
+enum class OutputFormat {
+    Text,
+    JsonLines,
+    NulSeparated
+};
+
+class OutputSink {
+public:
+    using Writer = std::function<void(const char* data, std::size_t size)>;
+    
+private:
+    OutputFormat format;
+    Writer writer;
+    std::string buffer;
+    std::size_t capacity;
+    std::string lastMatchPath;
+    
+    void commit();
+    
+    static void appendEscaped(std::string& output, std::string_view text);
+    static void appendJson(std::string& output, std::string_view text);
+    static void appendNumber(std::string& output, std::uint64_t value);
+    
+public:
+    OutputSink(OutputFormat format, Writer writer, std::size_t capacity = 1 << 20);
+    ~OutputSink();
+    
+    OutputSink(const OutputSink&) = delete;
+    OutputSink& operator=(const OutputSink&) = delete;
+    
+    OutputFormat outputFormat() const;
+    
+    void message(std::string_view text);
+    void entry(const ListEntry& entry, bool longFormat);
+    void path(std::string_view path);
+    void path(std::string_view directory, std::string_view name);
+    void match(std::string_view path, std::uint64_t line, std::string_view text);
+    void group(std::size_t index, std::uint64_t size, const std::vector<std::string>& paths);
+    void usage(std::string_view path, std::uint64_t allocated, std::uint64_t apparent);
+    
+    void appendPath(std::string& output, std::string_view directory, std::string_view name) const;
+    void write(std::string_view data);
+    void flush();
+    
+    static bool parseFormat(const std::string& name, OutputFormat& format);
+};
+
+#endif
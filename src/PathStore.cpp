@@ -0,0 +1,169 @@
+#include "PathStore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+const char separator = static_cast<char>(std::filesystem::path::preferred_separator);
+const std::size_t blockSize = 64 * 1024;
+
+struct JoinedPath {
+    std::string_view directory;
+    bool needsSeparator;
+    std::string_view name;
+    
+    std::size_t size() const {
+        return directory.size() + (needsSeparator ? 1 : 0) + name.size();
+    }
+    
+    char at(std::size_t index) const {
+        if (index < directory.size()) return directory[index];
+        index -= directory.size();
+        if (needsSeparator) {
+            if (index == 0) return separator;
+            --index;
+        }
+        return name[index];
+    }
+};
+
+bool needsSeparator(std::string_view directory) {
+    return !directory.empty() && directory.back() != separator;
+}
+
+}
+
+PathStore::PathStore() : cursor(nullptr), remaining(0), arenaBytes(0), lastDirectory(UINT32_MAX) {}
+
+std::string_view PathStore::intern(std::string_view text) {
+    if (text.size() > remaining) {
+        std::size_t size = std::max(blockSize, text.size());
+        blocks.push_back(std::make_unique<char[]>(size));
+        cursor = blocks.back().get();
+        remaining = size;
+        arenaBytes += size;
+    }
+    
+    char* stored = cursor;
+    std::memcpy(stored, text.data(), text.size());
+    cursor += text.size();
+    remaining -= text.size();
+    return std::string_view(stored, text.size());
+}
+
+std::uint32_t PathStore::directoryId(std::string_view directory) {
+    if (lastDirectory != UINT32_MAX && directories[lastDirectory] == directory) {
+        return lastDirectory;
+    }
+    
+    auto found = directoryIds.find(directory);
+    if (found != directoryIds.end()) {
+        lastDirectory = found->second;
+        return lastDirectory;
+    }
+    
+    std::string_view stored = intern(directory);
+    lastDirectory = static_cast<std::uint32_t>(directories.size());
+    directories.push_back(stored);
+    directoryIds.emplace(stored, lastDirectory);
+    return lastDirectory;
+}
+
+void PathStore::add(std::string_view directory, std::string_view name) {
+    std::uint32_t id = directoryId(directory);
+    std::string_view stored = intern(name);
+    entries.push_back({stored.data(), static_cast<std::uint32_t>(stored.size()), id});
+}
+
+void PathStore::add(std::string_view path) {
+    std::size_t split = path.rfind(separator);
+    if (split == std::string_view::npos) {
+        add(std::string_view(), path);
+    } else if (split == 0) {
+        add(path.substr(0, 1), path.substr(1));
+    } else {
+        add(path.substr(0, split), path.substr(split + 1));
+    }
+}
+
+void PathStore::append(PathStore&& other) {
+    std::vector<std::uint32_t> rebased(other.directories.size());
+    for (std::size_t i = 0; i < other.directories.size(); ++i) {
+        std::string_view directory = other.directories[i];
+        auto found = directoryIds.find(directory);
+        if (found != directoryIds.end()) {
+            rebased[i] = found->second;
+        } else {
+            rebased[i] = static_cast<std::uint32_t>(directories.size());
+            directories.push_back(directory);
+            directoryIds.emplace(directory, rebased[i]);
+        }
+    }
+    
+    entries.reserve(entries.size() + other.entries.size());
+    for (const auto& entry : other.entries) {
+        entries.push_back({entry.name, entry.length, rebased[entry.directory]});
+    }
+    
+    blocks.reserve(blocks.size() + other.blocks.size());
+    for (auto& block : other.blocks) blocks.push_back(std::move(block));
+    arenaBytes += other.arenaBytes;
+    other = PathStore();
+}
+
+bool PathStore::less(const Entry& a, const Entry& b) const {
+    std::string_view nameA(a.name, a.length);
+    std::string_view nameB(b.name, b.length);
+    if (a.directory == b.directory) return nameA < nameB;
+    
+    JoinedPath left{directories[a.directory], needsSeparator(directories[a.directory]), nameA};
+    JoinedPath right{directories[b.directory], needsSeparator(directories[b.directory]), nameB};
+    
+    std::size_t common = std::min(left.directory.size(), right.directory.size());
+    std::size_t index = static_cast<std::size_t>(
+        std::mismatch(left.directory.begin(), left.directory.begin() + common, right.directory.begin()).first -
+        left.directory.begin());
+    
+    std::size_t leftSize = left.size();
+    std::size_t rightSize = right.size();
+    for (; index < leftSize && index < rightSize; ++index) {
+        unsigned char l = static_cast<unsigned char>(left.at(index));
+        unsigned char r = static_cast<unsigned char>(right.at(index));
+        if (l != r) return l < r;
+    }
+    return leftSize < rightSize;
+}
+
+void PathStore::sort() {
+    std::sort(entries.begin(), entries.end(), [this](const Entry& a, const Entry& b) { return less(a, b); });
+}
+
+std::size_t PathStore::size() const {
+    return entries.size();
+}
+
+std::size_t PathStore::memoryUsage() const {
+    return arenaBytes + entries.capacity() * sizeof(Entry) + directories.capacity() * sizeof(std::string_view) +
+           directoryIds.size() * (sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void*));
+}
+
+void PathStore::appendPath(std::size_t index, std::string& out) const {
+    const Entry& entry = entries[index];
+    std::string_view directory = directories[entry.directory];
+    out.append(directory.data(), directory.size());
+    if (needsSeparator(directory)) out += separator;
+    out.append(entry.name, entry.length);
+}
+
+std::string PathStore::path(std::size_t index) const {
+    std::string out;
+    appendPath(index, out);
+    return out;
+}
+
+void PathStore::forEach(const std::function<void(std::string_view directory, std::string_view name)>& visitor) const {
+    for (const auto& entry : entries) {
+        visitor(directories[entry.directory], std::string_view(entry.name, entry.length));
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PATH_STORE_H
+#define PATH_STORE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+class PathStore {
+private:
+    struct Entry {
+        const char* name;
+        std::uint32_t length;
+        std::uint32_t directory;
+    };
+    
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char* cursor;
+    std::size_t remaining;
+    std::size_t arenaBytes;
+    
+    std::vector<std::string_view> directories;
+    std::unordered_map<std::string_view, std::uint32_t> directoryIds;
+    std::uint32_t lastDirectory;
+    
+    std::vector<Entry> entries;
+    
+    std::string_view intern(std::string_view text);
+    std::uint32_t directoryId(std::string_view directory);
+    bool less(const Entry& a, const Entry& b) const;
+    
+public:
+    PathStore();
+    
+    PathStore(PathStore&&) = default;
+    PathStore& operator=(PathStore&&) = default;
+    
+    void add(std::string_view directory, std::string_view name);
+    void add(std::string_view path);
+    void append(PathStore&& other);
+    void sort();
+    
+    std::size_t size() const;
+    std::size_t memoryUsage() const;
+    std::string path(std::size_t index) const;
+    void appendPath(std::size_t index, std::string& out) const;
+    void forEach(const std::function<void(std::string_view directory, std::string_view name)>& visitor) const;
+};
+
+#endif
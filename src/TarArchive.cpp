@@ -0,0 +1,1007 @@
+#include "TarArchive.h"
+#include "DirectoryWalker.h"
+#include "Metrics.h"
+#include <set>
+#include <unordered_set>
+#include <cstring>
+#include <algorithm>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#if defined(__has_include)
+#if __has_include(<linux/openat2.h>)
+#include <linux/openat2.h>
+#define SFM_OPENAT2 1
+#endif
+#endif
+#endif
+
+namespace {
+
+const std::size_t blockSize = 512;
+const std::size_t outputCapacity = 1024 * 1024;
+const std::size_t windowCapacity = 1024 * 1024;
+const char zeroBlock[blockSize] = {};
+
+std::uint64_t padding(std::uint64_t size) {
+    return (blockSize - size % blockSize) % blockSize;
+}
+
+bool writeOctal(char* field, std::size_t width, std::uint64_t value) {
+    if (width - 1 < 22 && value >> (3 * (width - 1))) return false;
+    
+    field[width - 1] = '\0';
+    for (std::size_t i = width - 1; i-- > 0;) {
+        field[i] = static_cast<char>('0' + (value & 7));
+        value >>= 3;
+    }
+    return true;
+}
+
+bool parseNumber(const char* field, std::size_t width, std::uint64_t& value) {
+    value = 0;
+    if (static_cast<unsigned char>(field[0]) & 0x80) {
+        if (static_cast<unsigned char>(field[0]) != 0x80) return false;
+        for (std::size_t i = 1; i < width; ++i) {
+            if (value >> 56) return false;
+            value = (value << 8) | static_cast<unsigned char>(field[i]);
+        }
+        return true;
+    }
+    
+    std::size_t i = 0;
+    while (i < width && field[i] == ' ') ++i;
+    for (; i < width && field[i] >= '0' && field[i] <= '7'; ++i) {
+        if (value >> 61) return false;
+        value = (value << 3) | static_cast<std::uint64_t>(field[i] - '0');
+    }
+    return i == width || field[i] == '\0' || field[i] == ' ';
+}
+
+bool cleanPath(const std::string& path, std::string& clean) {
+    clean.clear();
+    std::size_t start = 0;
+    while (start <= path.size()) {
+        std::size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        std::string_view part(path.data() + start, end - start);
+        start = end + 1;
+        
+        if (part.empty() || part == ".") continue;
+        if (part == "..") return false;
+        if (!clean.empty()) clean += '/';
+        clean.append(part.data(), part.size());
+    }
+    return true;
+}
+
+std::string fieldString(const char* field, std::size_t width) {
+    return std::string(field, strnlen(field, width));
+}
+
+void appendPaxRecord(std::string& records, const std::string& key, const std::string& value) {
+    std::size_t payload = key.size() + value.size() + 3;
+    std::size_t length = payload + std::to_string(payload).size();
+    length = payload + std::to_string(length).size();
+    
+    records += std::to_string(length);
+    records += ' ';
+    records += key;
+    records += '=';
+    records += value;
+    records += '\n';
+}
+
+bool splitName(const std::string& name, char* block) {
+    if (name.size() <= 100) {
+        std::memcpy(block, name.data(), name.size());
+        return true;
+    }
+    if (name.size() > 256) return false;
+    
+    std::size_t limit = std::min<std::size_t>(155, name.size() - 2);
+    for (std::size_t slash = name.rfind('/', limit); slash != std::string::npos && slash > 0; slash = name.rfind('/', slash - 1)) {
+        if (name.size() - slash - 1 > 100) break;
+        std::memcpy(block + 345, name.data(), slash);
+        std::memcpy(block, name.data() + slash + 1, name.size() - slash - 1);
+        return true;
+    }
+    return false;
+}
+
+void sealHeader(char* block) {
+    std::memcpy(block + 257, "ustar", 6);
+    std::memcpy(block + 263, "00", 2);
+    std::memset(block + 148, ' ', 8);
+    
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i < blockSize; ++i) sum += static_cast<unsigned char>(block[i]);
+    writeOctal(block + 148, 7, sum);
+    block[155] = ' ';
+}
+
+bool verifyHeader(const char* block) {
+    std::uint64_t stored;
+    if (!parseNumber(block + 148, 8, stored)) return false;
+    
+    std::uint64_t sum = 0;
+    std::int64_t signedSum = 0;
+    for (std::size_t i = 0; i < blockSize; ++i) {
+        char c = i >= 148 && i < 156 ? ' ' : block[i];
+        sum += static_cast<unsigned char>(c);
+        signedSum += static_cast<signed char>(c);
+    }
+    return stored == sum || static_cast<std::int64_t>(stored) == signedSum;
+}
+
+#ifdef OS_LINUX
+void buildHeader(std::string& out, const std::string& name, const struct stat& info, char type, std::uint64_t size,
+                 const std::string& link) {
+    char block[blockSize] = {};
+    std::string records;
+    
+    if (!splitName(name, block)) {
+        appendPaxRecord(records, "path", name);
+        std::memcpy(block, name.data(), 100);
+    }
+    if (link.size() > 100) appendPaxRecord(records, "linkpath", link);
+    std::memcpy(block + 157, link.data(), std::min<std::size_t>(link.size(), 100));
+    
+    writeOctal(block + 100, 8, info.st_mode & 07777);
+    if (!writeOctal(block + 108, 8, info.st_uid)) {
+        appendPaxRecord(records, "uid", std::to_string(info.st_uid));
+        writeOctal(block + 108, 8, 0);
+    }
+    if (!writeOctal(block + 116, 8, info.st_gid)) {
+        appendPaxRecord(records, "gid", std::to_string(info.st_gid));
+        writeOctal(block + 116, 8, 0);
+    }
+    if (!writeOctal(block + 124, 12, size)) {
+        appendPaxRecord(records, "size", std::to_string(size));
+        writeOctal(block + 124, 12, 0);
+    }
+    if (info.st_mtime < 0 || !writeOctal(block + 136, 12, static_cast<std::uint64_t>(info.st_mtime))) {
+        appendPaxRecord(records, "mtime", std::to_string(info.st_mtime));
+        writeOctal(block + 136, 12, 0);
+    }
+    block[156] = type;
+    sealHeader(block);
+    
+    if (!records.empty()) {
+        char extended[blockSize] = {};
+        std::string base = name;
+        while (base.size() > 1 && base.back() == '/') base.pop_back();
+        std::string paxName = "PaxHeaders/" + base.substr(base.rfind('/', base.size() - 1) + 1);
+        std::memcpy(extended, paxName.data(), std::min<std::size_t>(paxName.size(), 100));
+        writeOctal(extended + 100, 8, 0644);
+        writeOctal(extended + 108, 8, 0);
+        writeOctal(extended + 116, 8, 0);
+        writeOctal(extended + 124, 12, records.size());
+        std::memcpy(extended + 136, block + 136, 12);
+        extended[156] = 'x';
+        sealHeader(extended);
+        
+        out.append(extended, blockSize);
+        out += records;
+        out.append(zeroBlock, padding(records.size()));
+    }
+    out.append(block, blockSize);
+}
+
+bool writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+bool readAll(int fd, std::uint64_t offset, char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::pread(fd, data, size, static_cast<off_t>(offset));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (n == 0) {
+            errno = EIO;
+            return false;
+        }
+        data += n;
+        offset += static_cast<std::uint64_t>(n);
+        size -= static_cast<std::size_t>(n);
+    }
+    return true;
+}
+
+int openBeneath(int rootFd, const std::string& path) {
+    if (path.empty()) return ::fcntl(rootFd, F_DUPFD_CLOEXEC, 0);
+    
+#if defined(SFM_OPENAT2) && defined(SYS_openat2)
+    struct open_how how;
+    std::memset(&how, 0, sizeof(how));
+    how.flags = O_PATH | O_DIRECTORY | O_CLOEXEC;
+    how.resolve = RESOLVE_BENEATH | RESOLVE_NO_SYMLINKS | RESOLVE_NO_MAGICLINKS | RESOLVE_NO_XDEV;
+    int opened = static_cast<int>(::syscall(SYS_openat2, rootFd, path.c_str(), &how, sizeof(how)));
+    if (opened >= 0 || errno != ENOSYS) return opened;
+#endif
+    
+    int fd = ::fcntl(rootFd, F_DUPFD_CLOEXEC, 0);
+    for (std::size_t start = 0; fd >= 0 && start < path.size();) {
+        std::size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        
+        int next = ::openat(fd, path.substr(start, end - start).c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        int saved = errno;
+        ::close(fd);
+        errno = saved;
+        fd = next;
+        start = end + 1;
+    }
+    return fd;
+}
+
+std::string parentOf(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+std::string nameOf(const std::string& path) {
+    return path.substr(path.rfind('/') + 1);
+}
+#endif
+
+}
+
+TarPacker::TarPacker(const PackOptions& options)
+    : options(options), pool(options.threads), archiveFd(-1), archiveDevice(0), archiveInode(0), written(0), broken(false),
+      directories(0), files(0), symlinks(0), skipped(0), bytes(0), errors(0) {
+    if (this->options.window == 0) this->options.window = 1;
+}
+
+void TarPacker::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+#ifdef OS_LINUX
+void TarPacker::collect(const std::string& root) {
+    DirectoryWalker walker(options.threads);
+    std::vector<PathStore> stores(walker.threadCount());
+    
+    walker.walk(root,
+                [&](const WalkEntry& entry) {
+                    stores[entry.worker].add(entry.directory, std::string_view(entry.name, entry.nameLength));
+                    return true;
+                },
+                [&](const std::string& directory, const std::error_code& error, unsigned) {
+                    fail(directory, error);
+                });
+    
+    for (auto& store : stores) paths.append(std::move(store));
+    paths.sort();
+}
+
+void TarPacker::prepare(std::size_t index) {
+    Slot& slot = slots[index % options.window];
+    slot.path = paths.path(index);
+    
+    struct stat info;
+    if (::lstat(slot.path.c_str(), &info) != 0) {
+        fail(slot.path, std::error_code(errno, std::generic_category()));
+    } else {
+        std::string name = slot.path.substr(prefix.size());
+        
+        if (S_ISDIR(info.st_mode)) {
+            name += '/';
+            buildHeader(slot.header, name, info, '5', 0, std::string());
+            directories.fetch_add(1, std::memory_order_relaxed);
+        } else if (S_ISLNK(info.st_mode)) {
+            std::string link(static_cast<std::size_t>(info.st_size > 0 ? info.st_size : 256), '\0');
+            ssize_t length;
+            while ((length = ::readlink(slot.path.c_str(), &link[0], link.size())) == static_cast<ssize_t>(link.size())) {
+                link.resize(link.size() * 2);
+            }
+            if (length < 0) {
+                fail(slot.path, std::error_code(errno, std::generic_category()));
+            } else {
+                link.resize(static_cast<std::size_t>(length));
+                buildHeader(slot.header, name, info, '2', 0, link);
+                symlinks.fetch_add(1, std::memory_order_relaxed);
+            }
+        } else if (!S_ISREG(info.st_mode) ||
+                   (static_cast<std::uint64_t>(info.st_dev) == archiveDevice && static_cast<std::uint64_t>(info.st_ino) == archiveInode)) {
+            skipped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            int fd = ::open(slot.path.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+            std::uint64_t size = static_cast<std::uint64_t>(info.st_size);
+            
+            if (fd < 0) {
+                fail(slot.path, std::error_code(errno, std::generic_category()));
+            } else if (size <= options.inlineLimit) {
+                slot.data.resize(static_cast<std::size_t>(size));
+                std::size_t filled = 0;
+                bool ok = true;
+                while (filled < slot.data.size()) {
+                    ssize_t n = ::read(fd, &slot.data[filled], slot.data.size() - filled);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n < 0) {
+                        fail(slot.path, std::error_code(errno, std::generic_category()));
+                        ok = false;
+                        break;
+                    }
+                    if (n == 0) break;
+                    filled += static_cast<std::size_t>(n);
+                }
+                ::close(fd);
+                
+                if (ok) {
+                    slot.data.resize(filled);
+                    buildHeader(slot.header, name, info, '0', filled, std::string());
+                    files.fetch_add(1, std::memory_order_relaxed);
+                    Metrics::add(MetricCounter::BytesRead, filled);
+                }
+            } else {
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                slot.fd = fd;
+                slot.size = size;
+                buildHeader(slot.header, name, info, '0', size, std::string());
+                files.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        slot.ready = true;
+    }
+    slotReady.notify_all();
+}
+
+bool TarPacker::flushOutput() {
+    if (broken) return false;
+    if (output.empty()) return true;
+    
+    if (!writeAll(archiveFd, output.data(), output.size())) {
+        fail(archivePath, std::error_code(errno, std::generic_category()));
+        broken = true;
+        return false;
+    }
+    written += output.size();
+    Metrics::add(MetricCounter::BytesWritten, output.size());
+    output.clear();
+    return true;
+}
+
+bool TarPacker::writeOutput(const char* data, std::size_t size) {
+    if (broken) return false;
+    output.append(data, size);
+    return output.size() < outputCapacity || flushOutput();
+}
+
+bool TarPacker::writePadding(std::uint64_t size) {
+    while (size > 0) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(size, blockSize));
+        if (!writeOutput(zeroBlock, chunk)) return false;
+        size -= chunk;
+    }
+    return true;
+}
+
+bool TarPacker::copyBody(Slot& slot) {
+    if (!flushOutput()) return false;
+    
+    std::uint64_t remaining = slot.size;
+    bool fallback = false;
+    
+    while (remaining > 0 && !fallback) {
+        ssize_t n = ::sendfile(archiveFd, slot.fd, nullptr, static_cast<std::size_t>(std::min<std::uint64_t>(remaining, 1u << 30)));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EINVAL || errno == ENOSYS) {
+                fallback = true;
+                break;
+            }
+            fail(slot.path, std::error_code(errno, std::generic_category()));
+            break;
+        }
+        if (n == 0) {
+            fail(slot.path, std::make_error_code(std::errc::io_error));
+            break;
+        }
+        remaining -= static_cast<std::uint64_t>(n);
+        written += static_cast<std::uint64_t>(n);
+    }
+    
+    if (fallback) {
+        thread_local std::vector<char> buffer(outputCapacity);
+        while (remaining > 0) {
+            ssize_t n = ::read(slot.fd, buffer.data(), static_cast<std::size_t>(std::min<std::uint64_t>(remaining, buffer.size())));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                fail(slot.path, n < 0 ? std::error_code(errno, std::generic_category()) : std::make_error_code(std::errc::io_error));
+                break;
+            }
+            if (!writeAll(archiveFd, buffer.data(), static_cast<std::size_t>(n))) {
+                fail(archivePath, std::error_code(errno, std::generic_category()));
+                broken = true;
+                return false;
+            }
+            remaining -= static_cast<std::uint64_t>(n);
+            written += static_cast<std::uint64_t>(n);
+        }
+    }
+    
+    std::uint64_t copied = slot.size - remaining;
+    bytes.fetch_add(copied, std::memory_order_relaxed);
+    Metrics::add(MetricCounter::BytesRead, copied);
+    Metrics::add(MetricCounter::BytesWritten, copied);
+    return writePadding(remaining + padding(slot.size));
+}
+
+bool TarPacker::emit(Slot& slot) {
+    if (slot.header.empty()) return true;
+    if (!writeOutput(slot.header.data(), slot.header.size())) return false;
+    
+    if (slot.fd < 0) {
+        bytes.fetch_add(slot.data.size(), std::memory_order_relaxed);
+        return writeOutput(slot.data.data(), slot.data.size()) && writePadding(padding(slot.data.size()));
+    }
+    
+    bool ok = copyBody(slot);
+    ::close(slot.fd);
+    slot.fd = -1;
+    return ok;
+}
+
+PackSummary TarPacker::pack(const fs::path& root, const fs::path& archive) {
+    std::string rootPath = root.string();
+    while (rootPath.size() > 1 && rootPath.back() == '/') rootPath.pop_back();
+    prefix = rootPath == "/" ? rootPath : rootPath + '/';
+    archivePath = archive.string();
+    
+    struct stat info;
+    bool found = ::stat(rootPath.c_str(), &info) == 0;
+    if (!found || !S_ISDIR(info.st_mode)) {
+        int error = found ? ENOTDIR : errno;
+        fail(rootPath, std::error_code(error, std::generic_category()));
+        summary.errors = errors.load();
+        return summary;
+    }
+    
+    archiveFd = ::open(archivePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+    if (archiveFd < 0 || ::fstat(archiveFd, &info) != 0) {
+        fail(archivePath, std::error_code(errno, std::generic_category()));
+        if (archiveFd >= 0) ::close(archiveFd);
+        summary.errors = errors.load();
+        return summary;
+    }
+    archiveDevice = static_cast<std::uint64_t>(info.st_dev);
+    archiveInode = static_cast<std::uint64_t>(info.st_ino);
+    
+    collect(rootPath);
+    
+    slots.resize(options.window);
+    output.reserve(outputCapacity + 2 * blockSize);
+    
+    std::size_t count = paths.size();
+    std::size_t submitted = 0;
+    for (std::size_t next = 0; next < count; ++next) {
+        while (submitted < count && submitted < next + options.window) {
+            pool.submit([this, submitted]() { prepare(submitted); });
+            ++submitted;
+        }
+        
+        Slot& slot = slots[next % options.window];
+        {
+            std::unique_lock<std::mutex> lock(slotMutex);
+            slotReady.wait(lock, [&slot]() { return slot.ready; });
+        }
+        
+        bool ok = emit(slot);
+        
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            slot.ready = false;
+            slot.header.clear();
+            slot.data.clear();
+            slot.size = 0;
+        }
+        if (!ok) break;
+    }
+    
+    pool.wait();
+    for (auto& slot : slots) {
+        if (slot.fd >= 0) ::close(slot.fd);
+    }
+    
+    if (writeOutput(zeroBlock, blockSize) && writeOutput(zeroBlock, blockSize)) flushOutput();
+    if (::close(archiveFd) != 0 && !broken) fail(archivePath, std::error_code(errno, std::generic_category()));
+    
+    summary.directories = directories.load();
+    summary.files = files.load();
+    summary.symlinks = symlinks.load();
+    summary.skipped = skipped.load();
+    summary.bytes = bytes.load();
+    summary.archiveBytes = written;
+    summary.errors = errors.load();
+    return summary;
+}
+#else
+void TarPacker::collect(const std::string&) {}
+void TarPacker::prepare(std::size_t) {}
+bool TarPacker::emit(Slot&) { return false; }
+bool TarPacker::copyBody(Slot&) { return false; }
+bool TarPacker::writeOutput(const char*, std::size_t) { return false; }
+bool TarPacker::writePadding(std::uint64_t) { return false; }
+bool TarPacker::flushOutput() { return false; }
+
+PackSummary TarPacker::pack(const fs::path& root, const fs::path&) {
+    fail(root.string(), std::make_error_code(std::errc::operation_not_supported));
+    summary.errors = errors.load();
+    return summary;
+}
+#endif
+
+TarUnpacker::TarUnpacker(const UnpackOptions& options)
+    : options(options), pool(options.threads), archiveFd(-1), rootFd(-1), windowStart(0), windowSize(0), skipped(0), files(0),
+      bytes(0), errors(0) {
+    if (this->options.batchFiles == 0) this->options.batchFiles = 1;
+}
+
+void TarUnpacker::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+std::string TarUnpacker::destination(const std::string& path) const {
+    return root == "/" ? root + path : root + '/' + path;
+}
+
+#ifdef OS_LINUX
+const char* TarUnpacker::readBlock(std::uint64_t offset) {
+    if (offset >= windowStart && offset + blockSize <= windowStart + windowSize) {
+        return window.data() + (offset - windowStart);
+    }
+    
+    window.resize(windowCapacity);
+    windowStart = offset;
+    windowSize = 0;
+    while (windowSize < window.size()) {
+        ssize_t n = ::pread(archiveFd, window.data() + windowSize, window.size() - windowSize, static_cast<off_t>(offset + windowSize));
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) {
+            fail(archivePath, std::error_code(errno, std::generic_category()));
+            return nullptr;
+        }
+        if (n == 0) break;
+        windowSize += static_cast<std::size_t>(n);
+    }
+    Metrics::add(MetricCounter::BytesRead, windowSize);
+    return windowSize >= blockSize ? window.data() : nullptr;
+}
+
+bool TarUnpacker::readData(std::uint64_t offset, std::uint64_t size, std::string& data) {
+    data.resize(static_cast<std::size_t>(size));
+    if (!readAll(archiveFd, offset, &data[0], data.size())) {
+        fail(archivePath, std::error_code(errno, std::generic_category()));
+        return false;
+    }
+    return true;
+}
+
+void TarUnpacker::addMember(Member member) {
+    std::string clean;
+    std::string target;
+    if (!cleanPath(member.path, clean) || (member.type == '1' && (!cleanPath(member.link, target) || target.empty()))) {
+        fail(member.path, std::make_error_code(std::errc::permission_denied));
+        return;
+    }
+    if (clean.empty()) return;
+    member.path = clean;
+    if (member.type == '1') member.link = target;
+    
+    switch (member.type) {
+        case '5':
+            directoryMembers.push_back(std::move(member));
+            break;
+        case '0':
+        case '\0':
+        case '7': {
+            auto found = fileIds.find(member.path);
+            if (found != fileIds.end()) {
+                fileMembers[found->second] = std::move(member);
+            } else {
+                fileIds.emplace(member.path, fileMembers.size());
+                fileMembers.push_back(std::move(member));
+            }
+            break;
+        }
+        case '1':
+        case '2':
+            linkMembers.push_back(std::move(member));
+            break;
+        default:
+            ++skipped;
+    }
+}
+
+bool TarUnpacker::scan() {
+    std::uint64_t offset = 0;
+    std::string extendedPath;
+    std::string extendedLink;
+    std::string extendedSize;
+    std::string extendedMtime;
+    std::string data;
+    
+    auto truncated = [this](std::uint64_t reported) {
+        if (errors.load(std::memory_order_relaxed) == reported) fail(archivePath, std::make_error_code(std::errc::bad_message));
+        return false;
+    };
+    
+    while (true) {
+        std::uint64_t reported = errors.load(std::memory_order_relaxed);
+        const char* block = readBlock(offset);
+        if (!block) return truncated(reported);
+        if (std::memcmp(block, zeroBlock, blockSize) == 0) {
+            const char* last = readBlock(offset + blockSize);
+            if (!last) return truncated(reported);
+            if (std::memcmp(last, zeroBlock, blockSize) != 0 || !extendedPath.empty() || !extendedLink.empty() ||
+                !extendedSize.empty() || !extendedMtime.empty()) {
+                fail(archivePath, std::make_error_code(std::errc::bad_message));
+                return false;
+            }
+            break;
+        }
+        
+        std::uint64_t size;
+        if (!verifyHeader(block) || !parseNumber(block + 124, 12, size)) {
+            fail(archivePath, std::make_error_code(std::errc::bad_message));
+            return false;
+        }
+        
+        char type = block[156];
+        if (!extendedSize.empty()) size = std::strtoull(extendedSize.c_str(), nullptr, 10);
+        std::uint64_t dataOffset = offset + blockSize;
+        std::uint64_t next = dataOffset + size + padding(size);
+        
+        if (type == 'x' || type == 'g' || type == 'L' || type == 'K') {
+            if (type != 'g') {
+                if (!readData(dataOffset, size, data)) return false;
+                
+                if (type == 'L') {
+                    extendedPath = data.substr(0, strnlen(data.c_str(), data.size()));
+                } else if (type == 'K') {
+                    extendedLink = data.substr(0, strnlen(data.c_str(), data.size()));
+                } else {
+                    std::size_t position = 0;
+                    while (position < data.size()) {
+                        std::size_t length = std::strtoull(data.c_str() + position, nullptr, 10);
+                        std::size_t space = data.find(' ', position);
+                        std::size_t equals = data.find('=', space);
+                        if (length == 0 || position + length > data.size() || space == std::string::npos || equals >= position + length) {
+                            fail(archivePath, std::make_error_code(std::errc::bad_message));
+                            return false;
+                        }
+                        
+                        std::string key = data.substr(space + 1, equals - space - 1);
+                        std::string value = data.substr(equals + 1, position + length - equals - 2);
+                        if (key == "path") extendedPath = value;
+                        else if (key == "linkpath") extendedLink = value;
+                        else if (key == "size") extendedSize = value;
+                        else if (key == "mtime") extendedMtime = value;
+                        position += length;
+                    }
+                }
+            }
+            offset = next;
+            continue;
+        }
+        
+        Member member;
+        if (!extendedPath.empty()) {
+            member.path = extendedPath;
+        } else {
+            member.path = fieldString(block, 100);
+            std::string prefix = std::memcmp(block + 257, "ustar", 5) == 0 ? fieldString(block + 345, 155) : std::string();
+            if (!prefix.empty()) member.path = prefix + '/' + member.path;
+        }
+        member.link = !extendedLink.empty() ? extendedLink : fieldString(block + 157, 100);
+        
+        std::uint64_t mode = 0;
+        std::uint64_t mtime = 0;
+        parseNumber(block + 100, 8, mode);
+        parseNumber(block + 136, 12, mtime);
+        member.mode = static_cast<std::uint32_t>(mode & 07777);
+        member.mtime = !extendedMtime.empty() ? std::strtoll(extendedMtime.c_str(), nullptr, 10) : static_cast<std::int64_t>(mtime);
+        member.offset = dataOffset;
+        member.size = type == '1' || type == '2' || type == '5' ? 0 : size;
+        member.type = type;
+        addMember(std::move(member));
+        
+        extendedPath.clear();
+        extendedLink.clear();
+        extendedSize.clear();
+        extendedMtime.clear();
+        offset = next;
+    }
+    return true;
+}
+
+bool TarUnpacker::createDirectories() {
+    std::error_code error;
+    fs::create_directories(root, error);
+    if (error) {
+        fail(root, error);
+        return false;
+    }
+    
+    rootFd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0) {
+        fail(root, std::error_code(errno, std::generic_category()));
+        return false;
+    }
+    
+    std::set<std::string> skeleton;
+    auto addParents = [&skeleton](const std::string& path) {
+        for (std::size_t slash = path.find('/'); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+            skeleton.insert(path.substr(0, slash));
+        }
+    };
+    for (const auto& member : directoryMembers) {
+        addParents(member.path);
+        skeleton.insert(member.path);
+    }
+    for (const auto& member : fileMembers) addParents(member.path);
+    for (const auto& member : linkMembers) addParents(member.path);
+    
+    std::unordered_set<std::string> failed;
+    for (const auto& directory : skeleton) {
+        std::string parent = parentOf(directory);
+        if (!parent.empty() && failed.count(parent)) {
+            failed.insert(directory);
+            continue;
+        }
+        
+        int parentFd = openBeneath(rootFd, parent);
+        std::string name = nameOf(directory);
+        int result = parentFd < 0 ? -1 : ::mkdirat(parentFd, name.c_str(), 0777);
+        if (result != 0 && errno == EEXIST) {
+            struct stat info;
+            if (::fstatat(parentFd, name.c_str(), &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode)) result = 0;
+            else errno = ENOTDIR;
+        }
+        
+        if (result != 0) {
+            fail(destination(directory), std::error_code(errno, std::generic_category()));
+            failed.insert(directory);
+        } else {
+            ++summary.directories;
+        }
+        if (parentFd >= 0) ::close(parentFd);
+    }
+    
+    if (!failed.empty()) {
+        auto blocked = [this, &failed](const Member& member) {
+            if (failed.count(parentOf(member.path)) == 0 && (member.type != '5' || failed.count(member.path) == 0)) return false;
+            ++skipped;
+            return true;
+        };
+        directoryMembers.erase(std::remove_if(directoryMembers.begin(), directoryMembers.end(), blocked), directoryMembers.end());
+        fileMembers.erase(std::remove_if(fileMembers.begin(), fileMembers.end(), blocked), fileMembers.end());
+        linkMembers.erase(std::remove_if(linkMembers.begin(), linkMembers.end(), blocked), linkMembers.end());
+        fileIds.clear();
+    }
+    return true;
+}
+
+bool TarUnpacker::extractFile(const Member& member, int directoryFd, const std::string& name) {
+    std::string path = destination(member.path);
+    int fd = ::openat(directoryFd, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0 && errno == ELOOP && ::unlinkat(directoryFd, name.c_str(), 0) == 0) {
+        fd = ::openat(directoryFd, name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    }
+    if (fd < 0) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        return false;
+    }
+    
+    std::uint64_t remaining = member.size;
+    off_t offset = static_cast<off_t>(member.offset);
+    bool ok = true;
+    
+    if (member.size > options.inlineLimit) {
+        while (remaining > 0) {
+            ssize_t n = ::sendfile(fd, archiveFd, &offset, static_cast<std::size_t>(std::min<std::uint64_t>(remaining, 1u << 30)));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            remaining -= static_cast<std::uint64_t>(n);
+        }
+    }
+    
+    thread_local std::vector<char> buffer(windowCapacity);
+    while (ok && remaining > 0) {
+        std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(remaining, buffer.size()));
+        if (!readAll(archiveFd, static_cast<std::uint64_t>(offset), buffer.data(), chunk) || !writeAll(fd, buffer.data(), chunk)) {
+            fail(path, std::error_code(errno, std::generic_category()));
+            ok = false;
+            break;
+        }
+        offset += static_cast<off_t>(chunk);
+        remaining -= chunk;
+    }
+    
+    if (ok) {
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = static_cast<time_t>(member.mtime);
+        times[0].tv_nsec = times[1].tv_nsec = 0;
+        if (::fchmod(fd, static_cast<mode_t>(member.mode)) != 0 || ::futimens(fd, times) != 0) {
+            fail(path, std::error_code(errno, std::generic_category()));
+        }
+    }
+    if (::close(fd) != 0 && ok) {
+        fail(path, std::error_code(errno, std::generic_category()));
+        ok = false;
+    }
+    
+    if (ok) {
+        bytes.fetch_add(member.size, std::memory_order_relaxed);
+        Metrics::add(MetricCounter::BytesRead, member.size);
+        Metrics::add(MetricCounter::BytesWritten, member.size);
+    }
+    return ok;
+}
+
+void TarUnpacker::extractFiles(std::size_t first, std::size_t last) {
+    std::string directory;
+    int directoryFd = -1;
+    
+    for (std::size_t i = first; i < last; ++i) {
+        const Member& member = fileMembers[i];
+        std::string parent = parentOf(member.path);
+        if (directoryFd < 0 || parent != directory) {
+            if (directoryFd >= 0) ::close(directoryFd);
+            directory = parent;
+            directoryFd = openBeneath(rootFd, directory);
+            if (directoryFd < 0) {
+                fail(destination(member.path), std::error_code(errno, std::generic_category()));
+                continue;
+            }
+        }
+        
+        if (extractFile(member, directoryFd, nameOf(member.path))) {
+            files.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (directoryFd >= 0) ::close(directoryFd);
+}
+
+void TarUnpacker::createLinks() {
+    std::stable_partition(linkMembers.begin(), linkMembers.end(), [](const Member& member) { return member.type == '1'; });
+    
+    for (const auto& member : linkMembers) {
+        std::string path = destination(member.path);
+        std::string name = nameOf(member.path);
+        int directoryFd = openBeneath(rootFd, parentOf(member.path));
+        int targetFd = member.type == '1' && directoryFd >= 0 ? openBeneath(rootFd, parentOf(member.link)) : -1;
+        int result = -1;
+        
+        if (member.type == '1' && targetFd >= 0) {
+            std::string target = nameOf(member.link);
+            result = ::linkat(targetFd, target.c_str(), directoryFd, name.c_str(), 0);
+            if (result != 0 && errno == EEXIST && ::unlinkat(directoryFd, name.c_str(), 0) == 0) {
+                result = ::linkat(targetFd, target.c_str(), directoryFd, name.c_str(), 0);
+            }
+        } else if (member.type != '1' && directoryFd >= 0) {
+            result = ::symlinkat(member.link.c_str(), directoryFd, name.c_str());
+            if (result != 0 && errno == EEXIST && ::unlinkat(directoryFd, name.c_str(), 0) == 0) {
+                result = ::symlinkat(member.link.c_str(), directoryFd, name.c_str());
+            }
+        }
+        
+        if (result != 0) {
+            fail(path, std::error_code(errno, std::generic_category()));
+        } else if (member.type == '1') {
+            ++summary.hardlinks;
+        } else {
+            struct timespec times[2];
+            times[0].tv_sec = times[1].tv_sec = static_cast<time_t>(member.mtime);
+            times[0].tv_nsec = times[1].tv_nsec = 0;
+            ::utimensat(directoryFd, name.c_str(), times, AT_SYMLINK_NOFOLLOW);
+            ++summary.symlinks;
+        }
+        
+        if (targetFd >= 0) ::close(targetFd);
+        if (directoryFd >= 0) ::close(directoryFd);
+    }
+}
+
+void TarUnpacker::restoreDirectories() {
+    std::sort(directoryMembers.begin(), directoryMembers.end(),
+              [](const Member& a, const Member& b) { return a.path > b.path; });
+    
+    for (const auto& member : directoryMembers) {
+        std::string path = destination(member.path);
+        int parentFd = openBeneath(rootFd, parentOf(member.path));
+        int fd = parentFd < 0 ? -1 : ::openat(parentFd, nameOf(member.path).c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        
+        struct timespec times[2];
+        times[0].tv_sec = times[1].tv_sec = static_cast<time_t>(member.mtime);
+        times[0].tv_nsec = times[1].tv_nsec = 0;
+        if (fd < 0 || ::fchmod(fd, static_cast<mode_t>(member.mode)) != 0 || ::futimens(fd, times) != 0) {
+            fail(path, std::error_code(errno, std::generic_category()));
+        }
+        
+        if (fd >= 0) ::close(fd);
+        if (parentFd >= 0) ::close(parentFd);
+    }
+}
+
+UnpackSummary TarUnpacker::unpack(const fs::path& archive, const fs::path& dest) {
+    root = dest.string();
+    while (root.size() > 1 && root.back() == '/') root.pop_back();
+    archivePath = archive.string();
+    
+    archiveFd = ::open(archivePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (archiveFd < 0) {
+        fail(archivePath, std::error_code(errno, std::generic_category()));
+        summary.errors = errors.load();
+        return summary;
+    }
+    ::posix_fadvise(archiveFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    if (scan() && createDirectories()) {
+        window = std::vector<char>();
+        for (std::size_t first = 0; first < fileMembers.size(); first += options.batchFiles) {
+            std::size_t last = std::min(fileMembers.size(), first + options.batchFiles);
+            pool.submit([this, first, last]() { extractFiles(first, last); });
+        }
+        pool.wait();
+        
+        createLinks();
+        restoreDirectories();
+    }
+    if (rootFd >= 0) ::close(rootFd);
+    ::close(archiveFd);
+    
+    summary.files = files.load();
+    summary.bytes = bytes.load();
+    summary.skipped = skipped;
+    summary.errors = errors.load();
+    return summary;
+}
+#else
+const char* TarUnpacker::readBlock(std::uint64_t) { return nullptr; }
+bool TarUnpacker::readData(std::uint64_t, std::uint64_t, std::string&) { return false; }
+void TarUnpacker::addMember(Member) {}
+bool TarUnpacker::scan() { return false; }
+bool TarUnpacker::createDirectories() { return false; }
+bool TarUnpacker::extractFile(const Member&, int, const std::string&) { return false; }
+void TarUnpacker::extractFiles(std::size_t, std::size_t) {}
+void TarUnpacker::createLinks() {}
+void TarUnpacker::restoreDirectories() {}
+
+UnpackSummary TarUnpacker::unpack(const fs::path& archive, const fs::path&) {
+    fail(archive.string(), std::make_error_code(std::errc::operation_not_supported));
+    summary.errors = errors.load();
+    return summary;
+}
+#endif
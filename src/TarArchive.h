@@ -0,0 +1,158 @@
+#ifndef TAR_ARCHIVE_H
+#define TAR_ARCHIVE_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <system_error>
+#include "ThreadPool.h"
+#include "PathStore.h"
+
+namespace fs = std::filesystem;
+
+struct PackOptions {
+    unsigned threads = 0;
+    std::size_t window = 256;
+    std::uint64_t inlineLimit = 64 * 1024;
+};
+
+struct PackSummary {
+    std::uint64_t directories = 0;
+    std::uint64_t files = 0;
+    std::uint64_t symlinks = 0;
+    std::uint64_t skipped = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t archiveBytes = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+struct UnpackOptions {
+    unsigned threads = 0;
+    std::size_t batchFiles = 64;
+    std::uint64_t inlineLimit = 64 * 1024;
+};
+
+struct UnpackSummary {
+    std::uint64_t directories = 0;
+    std::uint64_t files = 0;
+    std::uint64_t symlinks = 0;
+    std::uint64_t hardlinks = 0;
+    std::uint64_t skipped = 0;
+    std::uint64_t bytes = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class TarPacker {
+private:
+    struct Slot {
+        bool ready = false;
+        std::string path;
+        std::string header;
+        std::string data;
+        int fd = -1;
+        std::uint64_t size = 0;
+    };
+    
+    PackOptions options;
+    ThreadPool pool;
+    PathStore paths;
+    std::string prefix;
+    
+    std::vector<Slot> slots;
+    std::mutex slotMutex;
+    std::condition_variable slotReady;
+    
+    std::string archivePath;
+    int archiveFd;
+    std::uint64_t archiveDevice;
+    std::uint64_t archiveInode;
+    std::string output;
+    std::uint64_t written;
+    bool broken;
+    
+    std::atomic<std::uint64_t> directories;
+    std::atomic<std::uint64_t> files;
+    std::atomic<std::uint64_t> symlinks;
+    std::atomic<std::uint64_t> skipped;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    PackSummary summary;
+    
+    void collect(const std::string& root);
+    void prepare(std::size_t index);
+    bool emit(Slot& slot);
+    bool copyBody(Slot& slot);
+    bool writeOutput(const char* data, std::size_t size);
+    bool writePadding(std::uint64_t size);
+    bool flushOutput();
+    void fail(const std::string& path, const std::error_code& error);
+    
+public:
+    explicit TarPacker(const PackOptions& options = PackOptions());
+    
+    PackSummary pack(const fs::path& root, const fs::path& archive);
+};
+
+class TarUnpacker {
+private:
+    struct Member {
+        std::string path;
+        std::string link;
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::int64_t mtime;
+        std::uint32_t mode;
+        char type;
+    };
+    
+    UnpackOptions options;
+    ThreadPool pool;
+    std::string root;
+    std::string archivePath;
+    int archiveFd;
+    int rootFd;
+    std::vector<char> window;
+    std::uint64_t windowStart;
+    std::size_t windowSize;
+    
+    std::vector<Member> directoryMembers;
+    std::vector<Member> fileMembers;
+    std::vector<Member> linkMembers;
+    std::unordered_map<std::string, std::size_t> fileIds;
+    std::uint64_t skipped;
+    
+    std::atomic<std::uint64_t> files;
+    std::atomic<std::uint64_t> bytes;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    UnpackSummary summary;
+    
+    bool scan();
+    const char* readBlock(std::uint64_t offset);
+    bool readData(std::uint64_t offset, std::uint64_t size, std::string& data);
+    void addMember(Member member);
+    bool createDirectories();
+    void extractFiles(std::size_t first, std::size_t last);
+    bool extractFile(const Member& member, int directoryFd, const std::string& name);
+    void createLinks();
+    void restoreDirectories();
+    std::string destination(const std::string& path) const;
+    void fail(const std::string& path, const std::error_code& error);
+    
+public:
+    explicit TarUnpacker(const UnpackOptions& options = UnpackOptions());
+    
+    UnpackSummary unpack(const fs::path& archive, const fs::path& dest);
+};
+
+#endif
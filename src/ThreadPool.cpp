@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+
+namespace {
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentIndex = -1;
+}
+
+ThreadPool::ThreadPool(unsigned threads) : queued(0), active(0), nextQueue(0), stopping(false) {
+    if (threads == 0) threads = defaultThreads();
+    
+    for (unsigned i = 0; i < threads; ++i) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+    
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::defaultThreads() {
+    unsigned threads = std::thread::hardware_concurrency();
+    return threads ? threads : 1;
+}
+
+unsigned ThreadPool::size() const {
+    return static_cast<unsigned>(workers.size());
+}
+
+int ThreadPool::currentWorker() {
+    return currentIndex;
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    ++active;
+    
+    unsigned index = currentPool == this ? static_cast<unsigned>(currentIndex)
+                                         : nextQueue++ % static_cast<unsigned>(queues.size());
+    
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        ++queued;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    
+    wakeCondition.notify_one();
+}
+
+bool ThreadPool::tryPop(unsigned self, std::function<void()>& task) {
+    {
+        Queue& own = *queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            --queued;
+            return true;
+        }
+    }
+    
+    for (std::size_t i = 1; i < queues.size(); ++i) {
+        Queue& victim = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --queued;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+void ThreadPool::workerLoop(unsigned self) {
+    currentPool = this;
+    currentIndex = static_cast<int>(self);
+    
+    while (true) {
+        std::function<void()> task;
+        
+        if (tryPop(self, task)) {
+            try {
+                task();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) firstError = std::current_exception();
+            }
+            
+            if (--active == 0) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idleCondition.notify_all();
+            }
+            continue;
+        }
+        
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        idleCondition.wait(lock, [this]() { return active == 0; });
+    }
+    
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (firstError) {
+        std::exception_ptr error = firstError;
+        firstError = nullptr;
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <memory>
+#include <exception>
+
+class ThreadPool {
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+    
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable idleCondition;
+    std::atomic<std::size_t> queued;
+    std::atomic<std::size_t> active;
+    std::atomic<unsigned> nextQueue;
+    bool stopping;
+    
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+    
+    bool tryPop(unsigned self, std::function<void()>& task);
+    void workerLoop(unsigned self);
+    
+public:
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+    
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    
+    void submit(std::function<void()> task);
+    void wait();
+    unsigned size() const;
+    
+    static int currentWorker();
+    static unsigned defaultThreads();
+};
+
+#endif
@@ -0,0 +1,376 @@
+#include "TreeCopier.h"
+#include "FileCopier.h"
+#include "IoUring.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <vector>
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+enum RingStep : std::uint64_t {
+    OpenSource,
+    OpenDest,
+    ReadSource,
+    WriteDest,
+    CloseSource,
+    CloseDest
+};
+
+const unsigned stepsPerFile = 6;
+const std::uintmax_t ringFileLimit = 16ull * 1024 * 1024;
+
+std::string childPath(const std::string& directory, const char* name) {
+    std::string path = directory;
+    if (path.empty() || path.back() != static_cast<char>(fs::path::preferred_separator)) {
+        path += static_cast<char>(fs::path::preferred_separator);
+    }
+    path += name;
+    return path;
+}
+
+}
+
+TreeCopier::TreeCopier(const TreeCopyOptions& options)
+    : options(options), scanPool(options.threads), copyPool(options.threads), pendingDirectories(0),
+      directories(0), files(0), ringFiles(0), pooledFiles(0), bytesCopied(0), errors(0) {}
+
+void TreeCopier::fail(const std::string& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path;
+        summary.firstError = error;
+    }
+}
+
+void TreeCopier::enqueueDirectory(DirectoryTask task) {
+    pendingDirectories.fetch_add(1, std::memory_order_relaxed);
+    directoryQueue.push(std::move(task));
+}
+
+void TreeCopier::finishDirectory() {
+    if (pendingDirectories.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        directoryQueue.close();
+        smallFileQueue.close();
+    }
+}
+
+void TreeCopier::createDirectories() {
+    DirectoryTask task;
+    while (directoryQueue.pop(task)) {
+        std::error_code error;
+#ifdef OS_LINUX
+        if (::mkdir(task.dest.c_str(), 0777) != 0) {
+            struct stat info;
+            if (errno != EEXIST || ::stat(task.dest.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+                error = std::error_code(errno == EEXIST ? ENOTDIR : errno, std::generic_category());
+            }
+        }
+#else
+        if (!fs::create_directory(task.dest, error) && !error && !fs::is_directory(task.dest, error)) {
+            error = std::make_error_code(std::errc::not_a_directory);
+        }
+#endif
+        if (error) {
+            fail(task.dest, error);
+            finishDirectory();
+            continue;
+        }
+        
+        directories.fetch_add(1, std::memory_order_relaxed);
+        scanPool.submit([this, task]() { scanDirectory(task); });
+    }
+}
+
+void TreeCopier::routeFile(FileTask task) {
+    files.fetch_add(1, std::memory_order_relaxed);
+    if (task.size <= options.smallFileLimit) {
+        smallFileQueue.push(std::move(task));
+    } else {
+        copyPool.submit([this, task]() { copyPooled(task); });
+    }
+}
+
+void TreeCopier::scanDirectory(const DirectoryTask& task) {
+#ifdef OS_LINUX
+    int fd = ::open(task.source.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        fail(task.source, std::error_code(errno, std::generic_category()));
+        finishDirectory();
+        return;
+    }
+    
+    thread_local std::vector<char> buffer(64 * 1024);
+    DirentReader reader(fd, buffer);
+    std::uint64_t entries = 0;
+    std::uint64_t stats = 0;
+    
+    while (const LinuxDirent64* record = reader.next()) {
+        const char* name = record->name;
+        ++entries;
+        
+        if (record->type == DT_DIR) {
+            enqueueDirectory({childPath(task.source, name), childPath(task.dest, name)});
+            continue;
+        }
+        
+        ++stats;
+        struct stat info;
+        if (::fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) != 0) {
+            fail(childPath(task.source, name), std::error_code(errno, std::generic_category()));
+            continue;
+        }
+        
+        std::string source = childPath(task.source, name);
+        std::string dest = childPath(task.dest, name);
+        if (S_ISDIR(info.st_mode)) {
+            enqueueDirectory({std::move(source), std::move(dest)});
+        } else if (S_ISREG(info.st_mode)) {
+            routeFile({std::move(source), std::move(dest), static_cast<std::uint64_t>(info.st_size),
+                       static_cast<unsigned>(info.st_mode & 07777)});
+        } else if (S_ISLNK(info.st_mode)) {
+            files.fetch_add(1, std::memory_order_relaxed);
+            copySymlink(source, dest);
+        } else {
+            fail(source, std::make_error_code(std::errc::operation_not_supported));
+        }
+    }
+    if (reader.error() != 0) {
+        fail(task.source, std::error_code(reader.error(), std::generic_category()));
+    }
+    
+    ::close(fd);
+    
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+    Metrics::add(MetricCounter::DirectoryReads, reader.readCalls());
+    Metrics::add(MetricCounter::StatCalls, stats);
+#else
+    std::error_code error;
+    fs::directory_iterator it(task.source, error);
+    if (error) {
+        fail(task.source, error);
+        finishDirectory();
+        return;
+    }
+    
+    Metrics::add(MetricCounter::DirectoryReads);
+    
+    for (fs::directory_iterator end; it != end; it.increment(error)) {
+        Metrics::add(MetricCounter::EntriesVisited);
+        
+        std::string source = it->path().string();
+        std::string dest = (fs::path(task.dest) / it->path().filename()).string();
+        fs::file_status status = it->symlink_status(error);
+        if (error) {
+            fail(source, error);
+            error.clear();
+            continue;
+        }
+        
+        if (fs::is_directory(status)) {
+            enqueueDirectory({std::move(source), std::move(dest)});
+        } else if (fs::is_regular_file(status)) {
+            std::uintmax_t size = it->file_size(error);
+            if (error) {
+                fail(source, error);
+                error.clear();
+                continue;
+            }
+            routeFile({std::move(source), std::move(dest), static_cast<std::uint64_t>(size), 0666});
+        } else if (fs::is_symlink(status)) {
+            files.fetch_add(1, std::memory_order_relaxed);
+            copySymlink(source, dest);
+        } else {
+            fail(source, std::make_error_code(std::errc::operation_not_supported));
+        }
+    }
+    if (error) fail(task.source, error);
+#endif
+    finishDirectory();
+}
+
+void TreeCopier::copySymlink(const std::string& source, const std::string& dest) {
+    std::error_code error;
+    fs::copy_symlink(source, dest, error);
+    if (error == std::errc::file_exists) {
+        error.clear();
+        if (fs::remove(dest, error)) fs::copy_symlink(source, dest, error);
+    }
+    if (error) fail(source, error);
+}
+
+void TreeCopier::copyPooled(const FileTask& task) {
+    try {
+        CopyResult result = FileCopier::copyFile(task.source, task.dest);
+        pooledFiles.fetch_add(1, std::memory_order_relaxed);
+        bytesCopied.fetch_add(result.bytesCopied, std::memory_order_relaxed);
+    } catch (const fs::filesystem_error& e) {
+        fail(task.source, e.code());
+    }
+}
+
+bool TreeCopier::transferWithRing() {
+#ifdef OS_LINUX
+    struct InFlight {
+        FileTask task;
+        std::vector<char> buffer;
+        unsigned pending = 0;
+        int error = 0;
+    };
+    
+    unsigned depth = std::max(options.queueDepth, 8u);
+    unsigned slots = std::max(depth / stepsPerFile, 1u);
+    std::vector<InFlight> inFlight(slots);
+    
+    IoUring ring;
+    std::error_code openError;
+    if (!ring.open(depth, slots * 2, openError)) return false;
+    summary.ringUsed = true;
+    
+    std::vector<unsigned> freeSlots;
+    for (unsigned index = slots; index > 0; --index) freeSlots.push_back(index - 1);
+    
+    bool broken = false;
+    auto complete = [&](unsigned index) {
+        InFlight& file = inFlight[index];
+        if (file.error == 0) {
+            ringFiles.fetch_add(1, std::memory_order_relaxed);
+            bytesCopied.fetch_add(file.task.size, std::memory_order_relaxed);
+            Metrics::add(MetricCounter::FilesCopied);
+            Metrics::add(MetricCounter::BytesRead, file.task.size);
+            Metrics::add(MetricCounter::BytesWritten, file.task.size);
+        } else {
+            if (file.error == EINVAL || file.error == EBADF) broken = true;
+            FileTask task = std::move(file.task);
+            copyPool.submit([this, task]() { copyPooled(task); });
+        }
+        freeSlots.push_back(index);
+    };
+    
+    std::vector<FileTask> batch;
+    bool open = true;
+    while (open || freeSlots.size() < slots) {
+        batch.clear();
+        if (open && !freeSlots.empty()) {
+            open = smallFileQueue.popBatch(batch, freeSlots.size(), freeSlots.size() == slots);
+        }
+        
+        for (auto& task : batch) {
+            if (broken || task.size > ringFileLimit) {
+                copyPool.submit([this, task]() { copyPooled(task); });
+                continue;
+            }
+            
+            unsigned index = freeSlots.back();
+            freeSlots.pop_back();
+            InFlight& file = inFlight[index];
+            file.task = std::move(task);
+            file.error = 0;
+            if (file.buffer.size() < file.task.size) file.buffer.resize(file.task.size);
+            
+            unsigned source = index * 2;
+            unsigned dest = index * 2 + 1;
+            unsigned length = static_cast<unsigned>(file.task.size);
+            std::uint64_t tag = static_cast<std::uint64_t>(index) << 3;
+            
+            ring.prepareOpen(file.task.source.c_str(), O_RDONLY, 0, source, tag | OpenSource, true);
+            ring.prepareOpen(file.task.dest.c_str(), O_WRONLY | O_CREAT | O_TRUNC, file.task.mode, dest, tag | OpenDest, true);
+            if (length > 0) {
+                ring.prepareRead(source, file.buffer.data(), length, 0, tag | ReadSource, true);
+                ring.prepareWrite(dest, file.buffer.data(), length, 0, tag | WriteDest, true);
+            }
+            ring.prepareClose(source, tag | CloseSource, true);
+            ring.prepareClose(dest, tag | CloseDest, false);
+            file.pending = length > 0 ? stepsPerFile : stepsPerFile - 2;
+        }
+        
+        if (freeSlots.size() == slots) continue;
+        
+        int result = ring.submit(1);
+        if (result != 0 && result != EAGAIN && result != EBUSY) {
+            fail("io_uring", std::error_code(result, std::generic_category()));
+            std::uint64_t userData = 0;
+            while (ring.withdraw(userData)) {
+                unsigned index = static_cast<unsigned>(userData >> 3);
+                InFlight& file = inFlight[index];
+                file.error = result;
+                if (--file.pending == 0) complete(index);
+            }
+            broken = true;
+            continue;
+        }
+        
+        std::uint64_t userData = 0;
+        int res = 0;
+        while (ring.popCompletion(userData, res)) {
+            unsigned index = static_cast<unsigned>(userData >> 3);
+            std::uint64_t step = userData & 7;
+            InFlight& file = inFlight[index];
+            
+            int failure = 0;
+            if (res < 0) {
+                failure = -res;
+            } else if ((step == ReadSource || step == WriteDest) && static_cast<std::uint64_t>(res) != file.task.size) {
+                failure = EIO;
+            }
+            if (failure != 0 && (file.error == 0 || file.error == ECANCELED)) file.error = failure;
+            
+            if (--file.pending == 0) complete(index);
+        }
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+void TreeCopier::transferSmallFiles() {
+    if (options.useIoUring && transferWithRing()) return;
+    
+    FileTask task;
+    while (smallFileQueue.pop(task)) {
+        copyPool.submit([this, task]() { copyPooled(task); });
+    }
+}
+
+TreeCopySummary TreeCopier::copy(const fs::path& source, const fs::path& dest) {
+    summary = TreeCopySummary();
+    directories = 0;
+    files = 0;
+    ringFiles = 0;
+    pooledFiles = 0;
+    bytesCopied = 0;
+    errors = 0;
+    pendingDirectories = 0;
+    directoryQueue.reopen();
+    smallFileQueue.reopen();
+    
+    enqueueDirectory({source.string(), dest.string()});
+    
+    std::thread directoryStage([this]() { createDirectories(); });
+    std::thread transferStage([this]() { transferSmallFiles(); });
+    directoryStage.join();
+    transferStage.join();
+    
+    scanPool.wait();
+    copyPool.wait();
+    
+    summary.directories = directories.load();
+    summary.files = files.load();
+    summary.ringFiles = ringFiles.load();
+    summary.pooledFiles = pooledFiles.load();
+    summary.bytesCopied = bytesCopied.load();
+    summary.errors = errors.load();
+    return summary;
+}
@@ -0,0 +1,82 @@
+#ifndef TREE_COPIER_H
+#define TREE_COPIER_H
+
+#include <filesystem>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <system_error>
+#include "ThreadPool.h"
+#include "WorkQueue.h"
+
+namespace fs = std::filesystem;
+
+struct TreeCopyOptions {
+    unsigned threads = 0;
+    unsigned queueDepth = 256;
+    std::uintmax_t smallFileLimit = 64 * 1024;
+    bool useIoUring = true;
+};
+
+struct TreeCopySummary {
+    std::uint64_t directories = 0;
+    std::uint64_t files = 0;
+    std::uint64_t ringFiles = 0;
+    std::uint64_t pooledFiles = 0;
+    std::uint64_t bytesCopied = 0;
+    bool ringUsed = false;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class TreeCopier {
+private:
+    struct DirectoryTask {
+        std::string source;
+        std::string dest;
+    };
+    
+    struct FileTask {
+        std::string source;
+        std::string dest;
+        std::uint64_t size;
+        unsigned mode;
+    };
+    
+    TreeCopyOptions options;
+    ThreadPool scanPool;
+    ThreadPool copyPool;
+    
+    WorkQueue<DirectoryTask> directoryQueue;
+    WorkQueue<FileTask> smallFileQueue;
+    std::atomic<std::size_t> pendingDirectories;
+    
+    std::atomic<std::uint64_t> directories;
+    std::atomic<std::uint64_t> files;
+    std::atomic<std::uint64_t> ringFiles;
+    std::atomic<std::uint64_t> pooledFiles;
+    std::atomic<std::uint64_t> bytesCopied;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    TreeCopySummary summary;
+    
+    void enqueueDirectory(DirectoryTask task);
+    void finishDirectory();
+    void createDirectories();
+    void scanDirectory(const DirectoryTask& task);
+    void routeFile(FileTask task);
+    void transferSmallFiles();
+    bool transferWithRing();
+    void copySymlink(const std::string& source, const std::string& dest);
+    void copyPooled(const FileTask& task);
+    void fail(const std::string& path, const std::error_code& error);
+    
+public:
+    explicit TreeCopier(const TreeCopyOptions& options = TreeCopyOptions());
+    
+    TreeCopySummary copy(const fs::path& source, const fs::path& dest);
+};
+
+#endif
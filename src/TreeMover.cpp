@@ -0,0 +1,307 @@
+#include "TreeMover.h"
+#include "Metrics.h"
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+TreeMover::TreeMover(const MoveOptions& options)
+    : options(options), pool(options.threads), errors(0), inflightBytes(0), inflightEntries(0) {}
+
+fs::path TreeMover::tempPath(const fs::path& dest) {
+    fs::path temp = dest;
+    temp += ".sfm-part";
+    return temp;
+}
+
+fs::path TreeMover::markerPath(const fs::path& dest) {
+    return dest / ".sfm-move";
+}
+
+bool TreeMover::claimDestination(const fs::path& source, const fs::path& dest) {
+    std::error_code error;
+    fs::path marker = markerPath(dest);
+    std::string origin = fs::absolute(source, error).lexically_normal().string();
+    
+    if (!fs::is_directory(fs::symlink_status(dest, error))) {
+        if (!fs::create_directory(dest, source, error)) {
+            fail(dest, error ? error : std::make_error_code(std::errc::file_exists));
+            return false;
+        }
+    } else {
+        bool empty = fs::is_empty(dest, error);
+        if (error) {
+            fail(dest, error);
+            return false;
+        }
+        
+        if (!empty) {
+            std::ifstream in(marker, std::ios::binary);
+            std::string recorded((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            if (!in.is_open() || recorded != origin) {
+                fail(dest, std::make_error_code(std::errc::directory_not_empty));
+                return false;
+            }
+            return true;
+        }
+    }
+    
+    std::ofstream out(marker, std::ios::binary | std::ios::trunc);
+    if (!(out << origin) || !out.flush()) {
+        fail(marker, std::make_error_code(std::errc::io_error));
+        return false;
+    }
+    return true;
+}
+
+bool TreeMover::alreadyMoved(const fs::path& source, const fs::path& dest, bool symlink, std::uintmax_t size) {
+    std::error_code error;
+    fs::file_status status = fs::symlink_status(dest, error);
+    if (error) return false;
+    
+    if (symlink) {
+        return fs::is_symlink(status) && fs::read_symlink(dest, error) == fs::read_symlink(source, error) && !error;
+    }
+    
+    if (!fs::is_regular_file(status) || fs::file_size(dest, error) != size || error) return false;
+    return fs::last_write_time(dest, error) == fs::last_write_time(source, error) && !error;
+}
+
+bool TreeMover::sameContents(const fs::path& source, const fs::path& dest) {
+    std::ifstream first(source, std::ios::binary);
+    std::ifstream second(dest, std::ios::binary);
+    if (!first || !second) return false;
+    
+    thread_local std::vector<char> left(1 << 20);
+    thread_local std::vector<char> right(1 << 20);
+    while (true) {
+        first.read(left.data(), static_cast<std::streamsize>(left.size()));
+        second.read(right.data(), static_cast<std::streamsize>(right.size()));
+        std::streamsize count = first.gcount();
+        
+        if (count != second.gcount() || std::memcmp(left.data(), right.data(), static_cast<std::size_t>(count)) != 0) return false;
+        Metrics::add(MetricCounter::BytesRead, static_cast<std::uint64_t>(count) * 2);
+        if (count < static_cast<std::streamsize>(left.size())) return first.eof() && second.eof();
+    }
+}
+
+void TreeMover::fail(const fs::path& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path.string();
+        summary.firstError = error;
+    }
+}
+
+void TreeMover::enqueue(Pending pending) {
+    std::lock_guard<std::mutex> lock(batchMutex);
+    batch.push_back(std::move(pending));
+}
+
+bool TreeMover::syncDestination() {
+#ifdef OS_LINUX
+    int fd = ::open(syncRoot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0 || ::syncfs(fd) != 0) {
+        int error = errno;
+        if (fd >= 0) ::close(fd);
+        fail(syncRoot, std::error_code(error, std::generic_category()));
+        return false;
+    }
+    ::close(fd);
+#endif
+    return true;
+}
+
+void TreeMover::commit() {
+    std::vector<Pending> entries;
+    {
+        std::lock_guard<std::mutex> lock(batchMutex);
+        entries.swap(batch);
+    }
+    if (entries.empty() || !syncDestination()) return;
+    
+    std::vector<bool> placed(entries.size(), true);
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].temp.empty()) continue;
+        
+        std::error_code error;
+        fs::rename(entries[i].temp, entries[i].dest, error);
+        if (error) {
+            fail(entries[i].dest, error);
+            placed[i] = false;
+        }
+    }
+    
+    if (!syncDestination()) return;
+    
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (!placed[i]) continue;
+        
+        std::error_code error;
+        fs::remove(entries[i].source, error);
+        if (error) {
+            fail(entries[i].source, error);
+            continue;
+        }
+        
+        ++summary.files;
+        summary.bytes += entries[i].size;
+        if (entries[i].temp.empty()) ++summary.resumed;
+    }
+}
+
+void TreeMover::copyEntry(const fs::path& source, const fs::path& dest, bool symlink, std::uintmax_t size) {
+    fs::path temp = tempPath(dest);
+    std::error_code ignored;
+    
+    try {
+        fs::remove(temp, ignored);
+        if (symlink) {
+            fs::copy_symlink(source, temp);
+        } else {
+            FileCopier::copyFile(source, temp, options.copy);
+            fs::last_write_time(temp, fs::last_write_time(source));
+        }
+        enqueue({source, temp, dest, size});
+    } catch (const fs::filesystem_error& e) {
+        fs::remove(temp, ignored);
+        fail(source, e.code());
+    }
+}
+
+void TreeMover::resumeEntry(const fs::path& source, const fs::path& dest, std::uintmax_t size) {
+    if (sameContents(source, dest)) {
+        enqueue({source, fs::path(), dest, size});
+    } else {
+        copyEntry(source, dest, false, size);
+    }
+}
+
+void TreeMover::moveEntry(const fs::path& source, const fs::path& dest, const fs::file_status& status) {
+    bool symlink = fs::is_symlink(status);
+    if (!symlink && !fs::is_regular_file(status)) {
+        fail(source, std::make_error_code(std::errc::operation_not_supported));
+        return;
+    }
+    
+    std::error_code error;
+    std::uintmax_t size = symlink ? 0 : fs::file_size(source, error);
+    if (error) {
+        fail(source, error);
+        return;
+    }
+    
+    if (inflightEntries > 0 && (inflightBytes + size > options.syncBytes || inflightEntries >= options.syncFiles)) {
+        pool.wait();
+        commit();
+        inflightBytes = 0;
+        inflightEntries = 0;
+    }
+    
+    ++inflightEntries;
+    bool moved = alreadyMoved(source, dest, symlink, size);
+    if (moved && symlink) {
+        enqueue({source, fs::path(), dest, size});
+        return;
+    }
+    
+    inflightBytes += size;
+    if (moved) {
+        pool.submit([this, source, dest, size]() { resumeEntry(source, dest, size); });
+    } else {
+        pool.submit([this, source, dest, symlink, size]() { copyEntry(source, dest, symlink, size); });
+    }
+}
+
+void TreeMover::walk(const fs::path& source, const fs::path& dest, std::vector<fs::path>& directories) {
+    std::error_code error;
+    fs::directory_iterator it(source, error);
+    if (error) {
+        fail(source, error);
+        return;
+    }
+    
+    std::uint64_t entries = 0;
+    for (; it != fs::directory_iterator(); it.increment(error)) {
+        ++entries;
+        fs::path target = dest / it->path().filename();
+        fs::file_status status = it->symlink_status(error);
+        if (error) {
+            fail(it->path(), error);
+            continue;
+        }
+        
+        if (fs::is_directory(status)) {
+            if (!fs::is_directory(fs::symlink_status(target, error)) && !fs::create_directory(target, it->path(), error)) {
+                fail(target, error);
+                continue;
+            }
+            directories.push_back(it->path());
+            walk(it->path(), target, directories);
+        } else {
+            moveEntry(it->path(), target, status);
+        }
+    }
+    if (error) fail(source, error);
+    
+    Metrics::add(MetricCounter::DirectoryReads);
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+}
+
+MoveSummary TreeMover::move(const fs::path& source, const fs::path& dest) {
+    summary = MoveSummary();
+    errors = 0;
+    inflightBytes = 0;
+    inflightEntries = 0;
+    
+    std::error_code error;
+    fs::file_status status = fs::symlink_status(source, error);
+    if (error) {
+        fail(source, error);
+        summary.errors = errors.load();
+        return summary;
+    }
+    
+    if (fs::is_directory(status)) {
+        syncRoot = dest;
+        if (!claimDestination(source, dest)) {
+            summary.errors = errors.load();
+            return summary;
+        }
+        
+        std::vector<fs::path> directories;
+        directories.push_back(source);
+        walk(source, dest, directories);
+        
+        pool.wait();
+        commit();
+        
+        for (auto it = directories.rbegin(); it != directories.rend(); ++it) {
+            fs::remove(*it, error);
+            if (!error) {
+                ++summary.directories;
+            } else if (errors.load() == 0) {
+                fail(*it, error);
+            }
+        }
+        
+        if (errors.load() == 0) {
+            fs::remove(markerPath(dest), error);
+            if (error) fail(markerPath(dest), error);
+        }
+    } else {
+        syncRoot = dest.has_parent_path() ? dest.parent_path() : fs::current_path();
+        moveEntry(source, dest, status);
+        pool.wait();
+        commit();
+    }
+    
+    summary.errors = errors.load();
+    return summary;
+}
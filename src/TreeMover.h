@@ -0,0 +1,78 @@
+#ifndef TREE_MOVER_H
+#define TREE_MOVER_H
+
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <system_error>
+#include "ThreadPool.h"
+#include "FileCopier.h"
+
+namespace fs = std::filesystem;
+
+struct MoveOptions {
+    unsigned threads = 0;
+    std::uintmax_t syncBytes = 256ull * 1024 * 1024;
+    std::size_t syncFiles = 4096;
+    CopyOptions copy;
+};
+
+struct MoveSummary {
+    std::uint64_t files = 0;
+    std::uint64_t directories = 0;
+    std::uint64_t resumed = 0;
+    std::uintmax_t bytes = 0;
+    bool crossDevice = false;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class TreeMover {
+private:
+    struct Pending {
+        fs::path source;
+        fs::path temp;
+        fs::path dest;
+        std::uintmax_t size;
+    };
+    
+    MoveOptions options;
+    ThreadPool pool;
+    fs::path syncRoot;
+    
+    std::mutex batchMutex;
+    std::vector<Pending> batch;
+    
+    std::mutex errorMutex;
+    MoveSummary summary;
+    std::atomic<std::uint64_t> errors;
+    
+    std::uintmax_t inflightBytes;
+    std::size_t inflightEntries;
+    
+    void walk(const fs::path& source, const fs::path& dest, std::vector<fs::path>& directories);
+    void moveEntry(const fs::path& source, const fs::path& dest, const fs::file_status& status);
+    void copyEntry(const fs::path& source, const fs::path& dest, bool symlink, std::uintmax_t size);
+    void resumeEntry(const fs::path& source, const fs::path& dest, std::uintmax_t size);
+    void enqueue(Pending pending);
+    void commit();
+    bool syncDestination();
+    bool claimDestination(const fs::path& source, const fs::path& dest);
+    void fail(const fs::path& path, const std::error_code& error);
+    
+    static bool alreadyMoved(const fs::path& source, const fs::path& dest, bool symlink, std::uintmax_t size);
+    static bool sameContents(const fs::path& source, const fs::path& dest);
+    static fs::path tempPath(const fs::path& dest);
+    static fs::path markerPath(const fs::path& dest);
+    
+public:
+    explicit TreeMover(const MoveOptions& options = MoveOptions());
+    
+    MoveSummary move(const fs::path& source, const fs::path& dest);
+};
+
+#endif
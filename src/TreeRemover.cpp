@@ -0,0 +1,234 @@
+#include "TreeRemover.h"
+#include "Metrics.h"
+#include "LinuxDirectory.h"
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <condition_variable>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+#ifdef OS_LINUX
+const std::uint64_t progressBatch = 1024;
+
+std::size_t retainedLimit() {
+    static const std::size_t limit = []() {
+        struct rlimit files;
+        if (::getrlimit(RLIMIT_NOFILE, &files) != 0 || files.rlim_cur == RLIM_INFINITY) return std::size_t(256);
+        return std::min<std::size_t>(256, static_cast<std::size_t>(files.rlim_cur) / 4);
+    }();
+    return limit;
+}
+#endif
+
+}
+
+TreeRemover::Node::Node(Node* parent, std::string name)
+    : parent(parent), name(std::move(name)), fd(-1), pending(1), failed(false) {}
+
+TreeRemover::TreeRemover(const RemoveOptions& options)
+    : options(options), pool(options.threads), removed(0), errors(0), retainedFds(0) {}
+
+std::string TreeRemover::pathOf(const Node* node, const std::string& name) {
+    std::string path = name;
+    for (const Node* current = node; current; current = current->parent) {
+        path = path.empty() ? current->name : current->name + static_cast<char>(fs::path::preferred_separator) + path;
+    }
+    return path;
+}
+
+void TreeRemover::fail(Node* node, const std::string& name, int error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = node ? pathOf(node, name) : name;
+        summary.firstError = std::error_code(error, std::generic_category());
+    }
+    for (Node* current = node; current; current = current->parent) {
+        current->failed.store(true, std::memory_order_relaxed);
+    }
+}
+
+#ifdef OS_LINUX
+int TreeRemover::directoryFd(Node* node, bool& owned) {
+    owned = false;
+    if (!node) return AT_FDCWD;
+    if (node->fd >= 0) return node->fd;
+    
+    std::vector<Node*> chain;
+    Node* base = node;
+    for (; base && base->fd < 0; base = base->parent) chain.push_back(base);
+    
+    int fd = base ? base->fd : AT_FDCWD;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+        int next = ::openat(fd, (*it)->name.c_str(), O_PATH | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        int error = errno;
+        if (owned) ::close(fd);
+        if (next < 0) {
+            owned = false;
+            errno = error;
+            return -1;
+        }
+        fd = next;
+        owned = true;
+    }
+    return fd;
+}
+
+void TreeRemover::scan(Node* node) {
+    bool ownedParent = false;
+    int parentFd = directoryFd(node->parent, ownedParent);
+    int fd = parentFd == -1 ? -1 : ::openat(parentFd, node->name.c_str(), O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    int openError = errno;
+    if (ownedParent) ::close(parentFd);
+    if (fd < 0) {
+        fail(node->parent, node->name, openError);
+        node->failed.store(true, std::memory_order_relaxed);
+        release(node);
+        return;
+    }
+    
+    thread_local std::vector<char> buffer(64 * 1024);
+    DirentReader reader(fd, buffer);
+    std::vector<std::string> subdirectories;
+    std::uint64_t unlinked = 0;
+    std::uint64_t stats = 0;
+    
+    while (const LinuxDirent64* record = reader.next()) {
+        const char* name = record->name;
+        bool directory = record->type == DT_DIR;
+        if (record->type == DT_UNKNOWN) {
+            struct stat info;
+            ++stats;
+            directory = ::fstatat(fd, name, &info, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(info.st_mode);
+        }
+        
+        if (!directory) {
+            if (::unlinkat(fd, name, 0) == 0) {
+                if (++unlinked == progressBatch) {
+                    removed.fetch_add(unlinked, std::memory_order_relaxed);
+                    unlinked = 0;
+                }
+                continue;
+            }
+            if (errno != EISDIR) {
+                fail(node, name, errno);
+                continue;
+            }
+        }
+        
+        subdirectories.emplace_back(name);
+    }
+    if (reader.error() != 0) fail(node, "", reader.error());
+    removed.fetch_add(unlinked, std::memory_order_relaxed);
+    
+    Metrics::add(MetricCounter::DirectoryReads, reader.readCalls());
+    Metrics::add(MetricCounter::StatCalls, stats);
+    
+    if (!subdirectories.empty() && retainedFds.fetch_add(1, std::memory_order_relaxed) < retainedLimit()) {
+        node->fd = fd;
+    } else {
+        if (!subdirectories.empty()) retainedFds.fetch_sub(1, std::memory_order_relaxed);
+        ::close(fd);
+    }
+    
+    for (auto& name : subdirectories) {
+        Node* child = new Node(node, std::move(name));
+        node->pending.fetch_add(1, std::memory_order_relaxed);
+        pool.submit([this, child]() { scan(child); });
+    }
+    release(node);
+}
+
+void TreeRemover::release(Node* node) {
+    while (node && node->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        Node* parent = node->parent;
+        
+        if (node->fd >= 0) {
+            ::close(node->fd);
+            retainedFds.fetch_sub(1, std::memory_order_relaxed);
+        }
+        
+        if (!node->failed.load(std::memory_order_relaxed)) {
+            bool owned = false;
+            int parentFd = directoryFd(parent, owned);
+            if (parentFd != -1) {
+                if (::unlinkat(parentFd, node->name.c_str(), AT_REMOVEDIR) == 0) {
+                    removed.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    fail(parent, node->name, errno);
+                }
+                if (owned) ::close(parentFd);
+            } else {
+                fail(parent, node->name, errno);
+            }
+        }
+        
+        delete node;
+        node = parent;
+    }
+}
+#else
+void TreeRemover::scan(Node* node) {
+    std::error_code error;
+    std::uintmax_t count = fs::remove_all(node->name, error);
+    if (error) {
+        fail(nullptr, node->name, error.value());
+    } else {
+        removed.fetch_add(count, std::memory_order_relaxed);
+    }
+    release(node);
+}
+
+void TreeRemover::release(Node* node) {
+    if (node->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete node;
+    }
+}
+#endif
+
+RemoveSummary TreeRemover::remove(const fs::path& path) {
+    removed = 0;
+    errors = 0;
+    summary = RemoveSummary();
+    
+    std::mutex progressMutex;
+    std::condition_variable progressCondition;
+    bool finished = false;
+    std::thread progress;
+    
+    if (options.onProgress) {
+        progress = std::thread([&]() {
+            std::unique_lock<std::mutex> lock(progressMutex);
+            while (!progressCondition.wait_for(lock, options.progressInterval, [&]() { return finished; })) {
+                options.onProgress(removed.load(std::memory_order_relaxed));
+            }
+        });
+    }
+    
+    std::string root = path.string();
+    pool.submit([this, root]() { scan(new Node(nullptr, root)); });
+    pool.wait();
+    
+    if (progress.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            finished = true;
+        }
+        progressCondition.notify_all();
+        progress.join();
+    }
+    
+    summary.removed = removed.load();
+    summary.errors = errors.load();
+    return summary;
+}
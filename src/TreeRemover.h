@@ -0,0 +1,61 @@
+#ifndef TREE_REMOVER_H
+#define TREE_REMOVER_H
+
+#include <filesystem>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <system_error>
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+struct RemoveOptions {
+    unsigned threads = 0;
+    std::chrono::milliseconds progressInterval = std::chrono::milliseconds(500);
+    std::function<void(std::uint64_t removed)> onProgress;
+};
+
+struct RemoveSummary {
+    std::uint64_t removed = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class TreeRemover {
+private:
+    struct Node {
+        Node* parent;
+        std::string name;
+        int fd;
+        std::atomic<std::size_t> pending;
+        std::atomic<bool> failed;
+        
+        Node(Node* parent, std::string name);
+    };
+    
+    RemoveOptions options;
+    ThreadPool pool;
+    std::atomic<std::uint64_t> removed;
+    std::atomic<std::uint64_t> errors;
+    std::atomic<std::size_t> retainedFds;
+    std::mutex errorMutex;
+    RemoveSummary summary;
+    
+    void scan(Node* node);
+    void release(Node* node);
+    int directoryFd(Node* node, bool& owned);
+    void fail(Node* node, const std::string& name, int error);
+    static std::string pathOf(const Node* node, const std::string& name);
+    
+public:
+    explicit TreeRemover(const RemoveOptions& options = RemoveOptions());
+    
+    RemoveSummary remove(const fs::path& path);
+};
+
+#endif
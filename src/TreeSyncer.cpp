@@ -0,0 +1,355 @@
+#include "TreeSyncer.h"
+#include "FileCopier.h"
+#include "Metrics.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#ifdef OS_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <sys/stat.h>
+#endif
+
+struct TreeSyncer::DeltaJob {
+    fs::path source;
+    fs::path dest;
+    int in = -1;
+    int out = -1;
+    std::uint64_t size = 0;
+    std::atomic<std::size_t> remaining{0};
+    std::atomic<bool> failed{false};
+#ifdef OS_LINUX
+    struct stat sourceInfo;
+#endif
+};
+
+namespace {
+
+const std::size_t windowSize = 4 * 1024 * 1024;
+
+#ifdef OS_LINUX
+int readFull(int fd, char* buffer, std::size_t size, std::uint64_t offset, std::size_t& got) {
+    got = 0;
+    while (got < size) {
+        ssize_t n = ::pread(fd, buffer + got, size - got, static_cast<off_t>(offset + got));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        if (n == 0) break;
+        got += static_cast<std::size_t>(n);
+    }
+    return 0;
+}
+
+int writeFull(int fd, const char* data, std::size_t size, std::uint64_t offset) {
+    std::size_t written = 0;
+    while (written < size) {
+        ssize_t n = ::pwrite(fd, data + written, size - written, static_cast<off_t>(offset + written));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return errno;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    return 0;
+}
+#endif
+
+}
+
+TreeSyncer::TreeSyncer(const SyncOptions& options)
+    : options(options), pool(options.threads), copied(0), patched(0), blocksRewritten(0), bytesWritten(0), errors(0) {}
+
+void TreeSyncer::fail(const fs::path& path, const std::error_code& error) {
+    Metrics::add(MetricCounter::Errors);
+    if (errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        summary.firstErrorPath = path.string();
+        summary.firstError = error;
+    }
+}
+
+bool TreeSyncer::upToDate(const fs::path& source, const fs::path& dest, std::uintmax_t size) {
+    std::error_code error;
+    if (fs::file_size(dest, error) != size || error) return false;
+    return fs::last_write_time(dest, error) == fs::last_write_time(source, error) && !error;
+}
+
+void TreeSyncer::copyWhole(const fs::path& source, const fs::path& dest) {
+    try {
+        CopyResult result = FileCopier::copyFile(source, dest);
+        fs::last_write_time(dest, fs::last_write_time(source));
+        copied.fetch_add(1, std::memory_order_relaxed);
+        bytesWritten.fetch_add(result.bytesCopied, std::memory_order_relaxed);
+    } catch (const fs::filesystem_error& e) {
+        fail(source, e.code());
+    }
+}
+
+void TreeSyncer::startDelta(const fs::path& source, const fs::path& dest, std::uintmax_t size) {
+#ifdef OS_LINUX
+    auto job = std::make_shared<DeltaJob>();
+    job->source = source;
+    job->dest = dest;
+    job->size = size;
+    job->in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (job->in < 0 || ::fstat(job->in, &job->sourceInfo) != 0) {
+        fail(source, std::error_code(errno, std::generic_category()));
+        if (job->in >= 0) ::close(job->in);
+        return;
+    }
+    job->out = ::open(dest.c_str(), O_RDWR | O_CLOEXEC);
+    if (job->out < 0) {
+        fail(dest, std::error_code(errno, std::generic_category()));
+        ::close(job->in);
+        return;
+    }
+    ::posix_fadvise(job->in, 0, 0, POSIX_FADV_SEQUENTIAL);
+    ::posix_fadvise(job->out, 0, 0, POSIX_FADV_SEQUENTIAL);
+    
+    std::uint64_t segment = std::max<std::uint64_t>(options.segmentSize / options.blockSize, 1) * options.blockSize;
+    job->remaining = static_cast<std::size_t>((size + segment - 1) / segment);
+    for (std::uint64_t offset = 0; offset < size; offset += segment) {
+        std::uint64_t length = std::min<std::uint64_t>(segment, size - offset);
+        pool.submit([this, job, offset, length]() { patchSegment(job, offset, length); });
+    }
+#else
+    (void)size;
+    pool.submit([this, source, dest]() { copyWhole(source, dest); });
+#endif
+}
+
+void TreeSyncer::patchSegment(const std::shared_ptr<DeltaJob>& job, std::uint64_t offset, std::uint64_t length) {
+#ifdef OS_LINUX
+    std::size_t window = std::max<std::size_t>(windowSize / options.blockSize, 1) * options.blockSize;
+    thread_local std::vector<char> sourceBuffer;
+    thread_local std::vector<char> destBuffer;
+    if (sourceBuffer.size() < window) {
+        sourceBuffer.resize(window);
+        destBuffer.resize(window);
+    }
+    
+    std::uint64_t end = offset + length;
+    std::uint64_t blocks = 0;
+    std::uint64_t written = 0;
+    std::uint64_t read = 0;
+    int error = 0;
+    
+    for (std::uint64_t position = offset; position < end && error == 0 && !job->failed; position += window) {
+        std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(window, end - position));
+        std::size_t sourceGot = 0;
+        std::size_t destGot = 0;
+        
+        error = readFull(job->in, sourceBuffer.data(), size, position, sourceGot);
+        if (error == 0 && sourceGot != size) error = EIO;
+        if (error == 0) error = readFull(job->out, destBuffer.data(), size, position, destGot);
+        if (error != 0) break;
+        read += sourceGot + destGot;
+        
+        std::size_t runStart = size;
+        auto flush = [&](std::size_t runEnd) {
+            if (runStart == size) return;
+            error = writeFull(job->out, sourceBuffer.data() + runStart, runEnd - runStart, position + runStart);
+            written += runEnd - runStart;
+            runStart = size;
+        };
+        
+        for (std::size_t block = 0; block < size && error == 0; block += options.blockSize) {
+            std::size_t blockLength = std::min(options.blockSize, size - block);
+            bool differs = block + blockLength > destGot ||
+                           std::memcmp(sourceBuffer.data() + block, destBuffer.data() + block, blockLength) != 0;
+            
+            if (differs) {
+                ++blocks;
+                if (runStart == size) runStart = block;
+            } else {
+                flush(block);
+            }
+        }
+        if (error == 0) flush(size);
+    }
+    
+    Metrics::add(MetricCounter::BytesRead, read);
+    Metrics::add(MetricCounter::BytesWritten, written);
+    blocksRewritten.fetch_add(blocks, std::memory_order_relaxed);
+    bytesWritten.fetch_add(written, std::memory_order_relaxed);
+    
+    if (error != 0 && !job->failed.exchange(true)) {
+        fail(job->dest, std::error_code(error, std::generic_category()));
+    }
+#else
+    (void)offset;
+    (void)length;
+#endif
+    if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        finishDelta(job);
+    }
+}
+
+void TreeSyncer::finishDelta(const std::shared_ptr<DeltaJob>& job) {
+#ifdef OS_LINUX
+    if (!job->failed) {
+        struct timespec times[2] = {job->sourceInfo.st_atim, job->sourceInfo.st_mtim};
+        if (::ftruncate(job->out, static_cast<off_t>(job->size)) != 0 ||
+            ::fchmod(job->out, job->sourceInfo.st_mode & 07777) != 0 ||
+            ::futimens(job->out, times) != 0) {
+            fail(job->dest, std::error_code(errno, std::generic_category()));
+        } else {
+            patched.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    ::close(job->out);
+    ::close(job->in);
+#else
+    (void)job;
+#endif
+}
+
+void TreeSyncer::syncEntry(const fs::path& source, const fs::path& dest, const fs::file_status& status) {
+    ++summary.files;
+    std::error_code error;
+    fs::file_status destStatus = fs::symlink_status(dest, error);
+    
+    if (fs::is_symlink(status)) {
+        if (fs::is_symlink(destStatus) && fs::read_symlink(dest, error) == fs::read_symlink(source, error) && !error) {
+            ++summary.unchanged;
+            return;
+        }
+        if (fs::exists(destStatus) && !removeTarget(dest)) return;
+        fs::copy_symlink(source, dest, error);
+        if (error) {
+            fail(source, error);
+        } else {
+            copied.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    
+    if (!fs::is_regular_file(status)) {
+        fail(source, std::make_error_code(std::errc::operation_not_supported));
+        return;
+    }
+    
+    std::uintmax_t size = fs::file_size(source, error);
+    if (error) {
+        fail(source, error);
+        return;
+    }
+    
+    if (fs::exists(destStatus) && !fs::is_regular_file(destStatus)) {
+        if (!removeTarget(dest)) return;
+        destStatus = fs::file_status(fs::file_type::not_found);
+    }
+    
+    if (fs::is_regular_file(destStatus)) {
+        if (upToDate(source, dest, size)) {
+            ++summary.unchanged;
+            return;
+        }
+        if (size >= options.deltaThreshold) {
+            startDelta(source, dest, size);
+            return;
+        }
+    }
+    
+    pool.submit([this, source, dest]() { copyWhole(source, dest); });
+}
+
+bool TreeSyncer::removeTarget(const fs::path& path) {
+    std::error_code error;
+    std::uintmax_t count = fs::remove_all(path, error);
+    if (error) {
+        fail(path, error);
+        return false;
+    }
+    summary.deleted += count;
+    return true;
+}
+
+void TreeSyncer::removeExtraneous(const fs::path& dest, const fs::path& source) {
+    std::error_code error;
+    fs::directory_iterator it(dest, error);
+    
+    for (; !error && it != fs::directory_iterator(); it.increment(error)) {
+        std::error_code ignored;
+        if (fs::exists(fs::symlink_status(source / it->path().filename(), ignored))) continue;
+        removeTarget(it->path());
+    }
+    if (error) fail(dest, error);
+}
+
+void TreeSyncer::walk(const fs::path& source, const fs::path& dest) {
+    std::error_code error;
+    fs::directory_iterator it(source, error);
+    if (error) {
+        fail(source, error);
+        return;
+    }
+    
+    std::uint64_t entries = 0;
+    for (; it != fs::directory_iterator(); it.increment(error)) {
+        ++entries;
+        fs::path target = dest / it->path().filename();
+        fs::file_status status = it->symlink_status(error);
+        if (error) {
+            fail(it->path(), error);
+            continue;
+        }
+        
+        if (!fs::is_directory(status)) {
+            syncEntry(it->path(), target, status);
+            continue;
+        }
+        
+        fs::file_status targetStatus = fs::symlink_status(target, error);
+        if (fs::exists(targetStatus) && !fs::is_directory(targetStatus) && !removeTarget(target)) continue;
+        if (!fs::is_directory(targetStatus) && !fs::create_directory(target, it->path(), error)) {
+            fail(target, error);
+            continue;
+        }
+        walk(it->path(), target);
+    }
+    if (error) fail(source, error);
+    
+    if (options.deleteExtraneous) {
+        removeExtraneous(dest, source);
+    }
+    
+    Metrics::add(MetricCounter::DirectoryReads);
+    Metrics::add(MetricCounter::EntriesVisited, entries);
+}
+
+SyncSummary TreeSyncer::sync(const fs::path& source, const fs::path& dest) {
+    summary = SyncSummary();
+    copied = 0;
+    patched = 0;
+    blocksRewritten = 0;
+    bytesWritten = 0;
+    errors = 0;
+    
+    std::error_code error;
+    fs::file_status status = fs::symlink_status(source, error);
+    if (error) {
+        fail(source, error);
+    } else if (fs::is_directory(status)) {
+        if (!fs::is_directory(fs::symlink_status(dest, error)) && !fs::create_directory(dest, source, error)) {
+            fail(dest, error);
+        } else {
+            walk(source, dest);
+        }
+    } else {
+        syncEntry(source, dest, status);
+    }
+    
+    pool.wait();
+    
+    summary.copied = copied.load();
+    summary.patched = patched.load();
+    summary.blocksRewritten = blocksRewritten.load();
+    summary.bytesWritten = bytesWritten.load();
+    summary.errors = errors.load();
+    return summary;
+}
@@ -0,0 +1,69 @@
+#ifndef TREE_SYNCER_H
+#define TREE_SYNCER_H
+
+#include <filesystem>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <system_error>
+#include "ThreadPool.h"
+
+namespace fs = std::filesystem;
+
+struct SyncOptions {
+    unsigned threads = 0;
+    bool deleteExtraneous = false;
+    std::size_t blockSize = 64 * 1024;
+    std::uintmax_t deltaThreshold = 16ull * 1024 * 1024;
+    std::uintmax_t segmentSize = 256ull * 1024 * 1024;
+};
+
+struct SyncSummary {
+    std::uint64_t files = 0;
+    std::uint64_t unchanged = 0;
+    std::uint64_t copied = 0;
+    std::uint64_t patched = 0;
+    std::uint64_t blocksRewritten = 0;
+    std::uint64_t bytesWritten = 0;
+    std::uint64_t deleted = 0;
+    std::uint64_t errors = 0;
+    std::string firstErrorPath;
+    std::error_code firstError;
+};
+
+class TreeSyncer {
+private:
+    struct DeltaJob;
+    
+    SyncOptions options;
+    ThreadPool pool;
+    
+    std::atomic<std::uint64_t> copied;
+    std::atomic<std::uint64_t> patched;
+    std::atomic<std::uint64_t> blocksRewritten;
+    std::atomic<std::uint64_t> bytesWritten;
+    std::atomic<std::uint64_t> errors;
+    std::mutex errorMutex;
+    SyncSummary summary;
+    
+    void walk(const fs::path& source, const fs::path& dest);
+    void syncEntry(const fs::path& source, const fs::path& dest, const fs::file_status& status);
+    void copyWhole(const fs::path& source, const fs::path& dest);
+    void startDelta(const fs::path& source, const fs::path& dest, std::uintmax_t size);
+    void patchSegment(const std::shared_ptr<DeltaJob>& job, std::uint64_t offset, std::uint64_t length);
+    void finishDelta(const std::shared_ptr<DeltaJob>& job);
+    void removeExtraneous(const fs::path& dest, const fs::path& source);
+    bool removeTarget(const fs::path& path);
+    void fail(const fs::path& path, const std::error_code& error);
+    
+    static bool upToDate(const fs::path& source, const fs::path& dest, std::uintmax_t size);
+    
+public:
+    explicit TreeSyncer(const SyncOptions& options = SyncOptions());
+    
+    SyncSummary sync(const fs::path& source, const fs::path& dest);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <deque>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+template <typename T>
+class WorkQueue {
+private:
+    std::mutex mutex;
+    std::condition_variable available;
+    std::deque<T> items;
+    bool closed = false;
+    
+public:
+    void push(T item) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            items.push_back(std::move(item));
+        }
+        available.notify_one();
+    }
+    
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex);
+        available.wait(lock, [this]() { return closed || !items.empty(); });
+        if (items.empty()) return false;
+        
+        item = std::move(items.front());
+        items.pop_front();
+        return true;
+    }
+    
+    bool popBatch(std::vector<T>& batch, std::size_t maximum, bool wait) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (wait) {
+            available.wait(lock, [this]() { return closed || !items.empty(); });
+        }
+        
+        while (!items.empty() && batch.size() < maximum) {
+            batch.push_back(std::move(items.front()));
+            items.pop_front();
+        }
+        return !batch.empty() || !closed;
+    }
+    
+    void reopen() {
+        std::lock_guard<std::mutex> lock(mutex);
+        items.clear();
+        closed = false;
+    }
+    
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        available.notify_all();
+    }
+};
+
+#endif
@@ -2,6 +2,8 @@
 #include <iostream>
 #include <exception>
 #include <locale>
+#include <string>
+#include <fstream>
 
 #ifdef OS_WINDOWS
 #include <windows.h>
@@ -9,8 +11,60 @@
 #include <io.h>
 #endif
 
-int main() {
+struct BatchArguments {
+    std::string source;
+    std::string reportFile;
+    BatchOptions options;
+    OutputFormat format = OutputFormat::Text;
+};
+
+bool parseArguments(int argc, char* argv[], LoggerOptions& loggerOptions, BatchArguments& batch) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        
+        if (i + 1 >= argc) {
+            return false;
+        }
+        
+        std::string value = argv[++i];
+        
+        if (arg == "--log") {
+            loggerOptions.path = value;
+        } else if (arg == "--log-flush") {
+            loggerOptions.flushInterval = std::chrono::milliseconds(std::stoul(value));
+        } else if (arg == "--log-durability") {
+            if (!Logger::parseDurability(value, loggerOptions.durability)) {
+                return false;
+            }
+        } else if (arg == "--batch") {
+            batch.source = value;
+        } else if (arg == "--jobs") {
+            batch.options.threads = static_cast<unsigned>(std::stoul(value));
+        } else if (arg == "--report") {
+            batch.reportFile = value;
+        } else if (arg == "--format") {
+            if (!OutputSink::parseFormat(value, batch.format)) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     try {
+        LoggerOptions loggerOptions;
+        BatchArguments batch;
+        if (!parseArguments(argc, argv, loggerOptions, batch)) {
+            tcerr << toTString("Использование: FileManager [--log <файл>] [--log-flush <мс>] [--log-durability buffered|flush|sync]\n"
+                               "                   [--batch <файл>|-] [--jobs N] [--report <файл>] [--format text|json|nul]") << std::endl;
+            return 1;
+        }
+        
+        
 #ifdef OS_WINDOWS
         SetConsoleOutputCP(1251);
         SetConsoleCP(1251);
@@ -22,7 +76,22 @@ int main() {
         std::locale::global(std::locale("en_US.UTF-8"));
 #endif
         
-        FileManager fileManager;
+        FileManager fileManager(loggerOptions);
+        fileManager.setOutputFormat(batch.format);
+        
+        if (!batch.source.empty()) {
+            if (batch.source == "-") {
+                return fileManager.runBatch(std::cin, batch.options, batch.reportFile) ? 0 : 2;
+            }
+            
+            std::ifstream script(batch.source);
+            if (!script) {
+                tcerr << toTString("Не удалось открыть файл команд: " + batch.source) << std::endl;
+                return 1;
+            }
+            return fileManager.runBatch(script, batch.options, batch.reportFile) ? 0 : 2;
+        }
+        
         fileManager.run();
     } catch (const std::exception& e) {
         tcerr << toTString("Критическая ошибка: ") << toTString(e.what()) << std::endl;
@@ -0,0 +1,139 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+
+#ifdef OS_LINUX
+namespace {
+
+void makeTree(const fs::path& root) {
+    writeFile(root / "small.txt", "small file\n");
+    writeFile(root / "empty.txt", "");
+    writeFile(root / "dir" / "large.bin", patternData(300 * 1024 + 5, 1));
+    writeFile(root / "dir" / "inner" / "medium.bin", patternData(64 * 1024, 2));
+    fs::create_directories(root / "hollow");
+    fs::create_symlink("dir/large.bin", root / "link");
+    for (int i = 0; i < 200; ++i) writeFile(root / "many" / ("f" + std::to_string(i)), std::to_string(i));
+}
+
+void testRoundTrip() {
+    TempDir dir;
+    fs::path source = dir / "source";
+    makeTree(source);
+    FileEngine engine;
+    
+    PackSummary packed = engine.pack(source, dir / "tree.tar");
+    CHECK(packed.errors == 0);
+    CHECK(packed.files == 204);
+    CHECK(packed.symlinks == 1);
+    CHECK(packed.archiveBytes == fs::file_size(dir / "tree.tar"));
+    CHECK(packed.archiveBytes % 512 == 0);
+    
+    UnpackSummary unpacked = engine.unpack(dir / "tree.tar", dir / "restored");
+    CHECK(unpacked.errors == 0);
+    CHECK(unpacked.files == packed.files);
+    CHECK(unpacked.symlinks == 1);
+    CHECK(unpacked.bytes == packed.bytes);
+    CHECK(sameTree(source, dir / "restored"));
+}
+
+void testSmallBatches() {
+    TempDir dir;
+    fs::path source = dir / "source";
+    makeTree(source);
+    FileEngine engine;
+    
+    PackOptions packOptions;
+    packOptions.threads = 1;
+    packOptions.window = 1;
+    packOptions.inlineLimit = 0;
+    CHECK(engine.pack(source, dir / "tree.tar", packOptions).errors == 0);
+    
+    UnpackOptions unpackOptions;
+    unpackOptions.threads = 3;
+    unpackOptions.batchFiles = 1;
+    unpackOptions.inlineLimit = 16;
+    CHECK(engine.unpack(dir / "tree.tar", dir / "restored", unpackOptions).errors == 0);
+    CHECK(sameTree(source, dir / "restored"));
+}
+
+void testSymlinkEscape() {
+    TempDir dir;
+    writeFile(dir / "source" / "a" / "f", "payload");
+    FileEngine engine;
+    CHECK(engine.pack(dir / "source", dir / "tree.tar").errors == 0);
+    
+    fs::create_directories(dir / "outside");
+    fs::create_directories(dir / "dest");
+    fs::create_directory_symlink(dir / "outside", dir / "dest" / "a");
+    
+    UnpackSummary summary = engine.unpack(dir / "tree.tar", dir / "dest");
+    CHECK(summary.errors > 0);
+    CHECK(fs::is_empty(dir / "outside"));
+}
+
+void testArchiveInsideSource() {
+    TempDir dir;
+    writeFile(dir / "f", "data");
+    FileEngine engine;
+    PackSummary summary = engine.pack(dir.path(), dir / "self.tar");
+    CHECK(summary.errors == 0);
+    CHECK(summary.files == 1);
+    
+    UnpackSummary unpacked = engine.unpack(dir / "self.tar", dir / "out");
+    CHECK(unpacked.errors == 0);
+    CHECK(!fs::exists(dir / "out" / "self.tar"));
+    CHECK(readFile(dir / "out" / "f") == "data");
+}
+
+void testMissingRoot() {
+    TempDir dir;
+    writeFile(dir / "file", "x");
+    FileEngine engine;
+    
+    PackSummary missing = engine.pack(dir / "absent", dir / "a.tar");
+    CHECK(missing.errors == 1);
+    CHECK(missing.firstError == std::errc::no_such_file_or_directory);
+    
+    PackSummary file = engine.pack(dir / "file", dir / "b.tar");
+    CHECK(file.errors == 1);
+    CHECK(file.firstError == std::errc::not_a_directory);
+}
+
+void testTruncatedArchive() {
+    TempDir dir;
+    writeFile(dir / "source" / "a", patternData(5000, 1));
+    writeFile(dir / "source" / "b", patternData(5000, 2));
+    FileEngine engine;
+    CHECK(engine.pack(dir / "source", dir / "tree.tar").errors == 0);
+    std::string archive = readFile(dir / "tree.tar");
+    
+    std::size_t end = archive.find_last_not_of('\0');
+    end = (end / 512 + 1) * 512;
+    for (std::size_t size : {std::size_t(0), std::size_t(512), archive.size() / 2, end, end + 512}) {
+        writeFile(dir / "cut.tar", archive.substr(0, size));
+        UnpackSummary summary = engine.unpack(dir / "cut.tar", dir / ("out" + std::to_string(size)));
+        CHECK(summary.errors == 1);
+        CHECK(summary.firstError == std::errc::bad_message);
+    }
+    
+    writeFile(dir / "cut.tar", archive.substr(0, end + 1024));
+    CHECK(engine.unpack(dir / "cut.tar", dir / "whole").errors == 0);
+    CHECK(sameTree(dir / "source", dir / "whole"));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"tar.roundtrip", testRoundTrip},
+        {"tar.small-batches", testSmallBatches},
+        {"tar.symlink-escape", testSymlinkEscape},
+        {"tar.self", testArchiveInsideSource},
+        {"tar.missing-root", testMissingRoot},
+        {"tar.truncated", testTruncatedArchive},
+    });
+}
+#else
+int main() {
+    return 0;
+}
+#endif
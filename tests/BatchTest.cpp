@@ -0,0 +1,56 @@
+#include "TestSupport.h"
+#include "BatchRunner.h"
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+std::vector<std::string> splitWords(const std::string& line) {
+    std::istringstream in(line);
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) words.push_back(word);
+    return words;
+}
+
+void testBatchOrder() {
+#ifndef OS_WINDOWS
+    std::ostringstream captured;
+    std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+    
+    BatchOptions options;
+    options.threads = 4;
+    BatchRunner runner(options, splitWords, [](const std::vector<std::string>& args) {
+        if (args[1] == "boom") throw 42;
+        if (args[1] == "fail") throw std::runtime_error("отказ");
+        std::cout << args[1] << "\n";
+    }, [](const std::string& arg) { return fs::path("/batch") / arg; });
+    
+    std::ostringstream script;
+    for (int i = 0; i < 50; ++i) script << "mkdir d" << i << "\n";
+    script << "mkdir boom\nmkdir fail\nmkdir last\n";
+    std::istringstream input(script.str());
+    bool success = runner.run(input);
+    std::cout.rdbuf(original);
+    
+    std::ostringstream expected;
+    for (int i = 0; i < 50; ++i) expected << "d" << i << "\n";
+    expected << "last\n";
+    
+    CHECK(!success);
+    CHECK(captured.str() == expected.str());
+    CHECK(runner.report().size() == 53);
+    CHECK(runner.failures() == 2);
+    CHECK(runner.report().size() == 53 && !runner.report()[50].success && !runner.report()[50].error.empty());
+    CHECK(runner.report().size() == 53 && runner.report()[51].error == "отказ");
+    CHECK(runner.report().size() == 53 && runner.report()[52].success);
+#endif
+}
+
+}
+
+int main() {
+    return runTests({
+        {"batch.order", testBatchOrder},
+    });
+}
@@ -0,0 +1,87 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+
+namespace {
+
+void testTotals() {
+    TempDir dir;
+    writeFile(dir / "a", std::string(1000, 'a'));
+    writeFile(dir / "sub" / "b", std::string(2000, 'b'));
+    writeFile(dir / "sub" / "deeper" / "c", std::string(3000, 'c'));
+    FileEngine engine;
+    
+    DiskUsageOptions options;
+    options.apparentSize = true;
+    options.top = 2;
+    DiskUsageSummary summary = engine.diskUsage(dir.path(), options);
+    CHECK(summary.errors == 0);
+    CHECK(summary.totals.files == 3);
+    CHECK(summary.totals.directories == 3);
+    CHECK(summary.totals.apparent >= 6000);
+    CHECK(summary.largest.size() == 2);
+    CHECK(summary.largest.size() == 2 && fs::path(summary.largest[0].path) == dir / "sub");
+    CHECK(summary.largest.size() == 2 && summary.largest[0].totals.files == 2);
+}
+
+void testHardLinks() {
+#ifdef OS_LINUX
+    TempDir dir;
+    writeFile(dir / "one" / "data", std::string(50000, 'x'));
+    fs::create_directories(dir / "two");
+    fs::create_hard_link(dir / "one" / "data", dir / "two" / "data");
+    FileEngine engine;
+    
+    DiskUsageOptions options;
+    options.apparentSize = true;
+    DiskUsageSummary summary = engine.diskUsage(dir.path(), options);
+    CHECK(summary.errors == 0);
+    CHECK(summary.totals.files == 1);
+    CHECK(summary.duplicateLinks == 1);
+#endif
+}
+
+void testCache() {
+    TempDir dir;
+    writeFile(dir / "sub" / "file", std::string(100, 'x'));
+    FileEngine engine;
+    
+    DiskUsageOptions options;
+    options.apparentSize = true;
+    std::uint64_t before = engine.diskUsage(dir.path(), options).totals.apparent;
+    
+    writeFile(dir / "sub" / "file", std::string(100000, 'x'));
+    DiskUsageSummary fresh = engine.diskUsage(dir.path(), options);
+    CHECK(fresh.cachedDirectories == 0);
+    CHECK(fresh.totals.apparent >= before + 99900);
+    
+#ifdef OS_LINUX
+    options.cached = true;
+    DiskUsageSummary cached = engine.diskUsage(dir.path(), options);
+    CHECK(cached.cachedDirectories == 2);
+    CHECK(cached.totals.apparent == fresh.totals.apparent);
+    
+    writeFile(dir / "sub" / "added", "new");
+    DiskUsageSummary changed = engine.diskUsage(dir.path(), options);
+    CHECK(changed.totals.files == 2);
+    CHECK(changed.cachedDirectories == 1);
+#endif
+}
+
+void testMissing() {
+    TempDir dir;
+    FileEngine engine;
+    DiskUsageSummary summary = engine.diskUsage(dir / "absent");
+    CHECK(summary.errors == 1);
+    CHECK(summary.firstError == std::errc::no_such_file_or_directory);
+}
+
+}
+
+int main() {
+    return runTests({
+        {"du.totals", testTotals},
+        {"du.hardlinks", testHardLinks},
+        {"du.cache", testCache},
+        {"du.missing", testMissing},
+    });
+}
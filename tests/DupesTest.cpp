@@ -0,0 +1,59 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+
+namespace {
+
+void testGroups() {
+    TempDir dir;
+    std::string data = patternData(10000, 3);
+    writeFile(dir / "a.bin", data);
+    writeFile(dir / "sub" / "b.bin", data);
+    writeFile(dir / "c.bin", patternData(10000, 4));
+    std::string edges = data;
+    edges[5000] ^= 1;
+    writeFile(dir / "d.bin", edges);
+    writeFile(dir / "empty1", "");
+    writeFile(dir / "empty2", "");
+    FileEngine engine;
+    
+    DupeSummary summary = engine.findDuplicates(dir.path());
+    CHECK(summary.errors == 0);
+    CHECK(summary.groups.size() == 1);
+    CHECK(summary.groups.size() == 1 && summary.groups[0].size == 10000);
+    CHECK(summary.groups.size() == 1 && summary.groups[0].paths.size() == 2);
+    CHECK(summary.wastedBytes == 10000);
+}
+
+void testHardLink() {
+    TempDir dir;
+    std::string data = patternData(10000, 3);
+    writeFile(dir / "a.bin", data);
+    writeFile(dir / "b.bin", data);
+    writeFile(dir / "b.bin.sfm-link", "keep me");
+    writeFile(dir / "b.bin.sfm-link-0", "keep me too");
+    FileEngine engine;
+    
+    DupeOptions options;
+    options.link = LinkMode::Hard;
+    DupeSummary linked = engine.findDuplicates(dir.path(), options);
+    CHECK(linked.errors == 0);
+    CHECK(linked.linked == 1);
+    CHECK(fs::equivalent(dir / "a.bin", dir / "b.bin"));
+    CHECK(readFile(dir / "b.bin") == data);
+    CHECK(readFile(dir / "b.bin.sfm-link") == "keep me");
+    CHECK(readFile(dir / "b.bin.sfm-link-0") == "keep me too");
+    CHECK(relativeFiles(dir.path()).size() == 4);
+    
+    DupeSummary again = engine.findDuplicates(dir.path(), options);
+    CHECK(again.groups.empty());
+    CHECK(again.hardlinksSkipped == 1);
+}
+
+}
+
+int main() {
+    return runTests({
+        {"dupes.groups", testGroups},
+        {"dupes.hardlink", testHardLink},
+    });
+}
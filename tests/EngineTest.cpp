@@ -0,0 +1,131 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+std::set<std::string> findPaths(FileEngine& engine, const fs::path& root, const std::vector<std::string>& patterns,
+                                 FindOptions options = FindOptions()) {
+    std::mutex mutex;
+    std::set<std::string> paths;
+    engine.find(root, patterns, options, [&](std::string_view directory, std::string_view name, unsigned) {
+        std::lock_guard<std::mutex> lock(mutex);
+        paths.insert(fs::relative(fs::path(std::string(directory)) / std::string(name), root).generic_string());
+        return true;
+    });
+    return paths;
+}
+
+void testList() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    FileEngine engine;
+    
+    ListOptions options;
+    options.sort = ListSort::Name;
+    std::vector<std::string> names;
+    ListSummary summary = engine.list(dir.path(), options, [&](const ListEntry& entry) {
+        names.emplace_back(entry.name);
+        return true;
+    });
+    
+    CHECK(summary.errors == 0);
+    CHECK(summary.entries == 4);
+    CHECK((names == std::vector<std::string>{"docs", "empty", "readme.txt", "src"}));
+    
+    writeFile(dir / "later.txt", "x");
+    names.clear();
+    engine.list(dir.path(), options, [&](const ListEntry& entry) {
+        names.emplace_back(entry.name);
+        return true;
+    });
+    CHECK(std::find(names.begin(), names.end(), "later.txt") != names.end());
+}
+
+void testCachedSymlinkLoop() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    fs::create_directory_symlink("..", dir / "src" / "loop");
+    FileEngine engine;
+    
+    ListOptions options;
+    options.longFormat = true;
+    for (const fs::path& path : {dir.path(), dir / "src", dir / "src" / "lib"}) {
+        engine.list(path, options, [&](const ListEntry& entry) {
+            if (entry.name == "loop") {
+                CHECK(entry.type == EntryType::Symlink);
+                CHECK(entry.targetType == EntryType::Directory);
+            }
+            return true;
+        });
+    }
+    
+    FindOptions findOptions;
+    findOptions.useIndex = false;
+    findOptions.threads = 1;
+    CHECK((findPaths(engine, dir.path(), {"*.cpp"}, findOptions) ==
+           std::set<std::string>{"src/main.cpp", "src/util.cpp", "src/lib/deep.cpp"}));
+    
+    std::set<std::string> matches;
+    SearchOptions searchOptions;
+    searchOptions.threads = 1;
+    searchOptions.onMatch = [&](const std::string& path, std::uint64_t, std::string_view) {
+        matches.insert(fs::relative(path, dir.path()).generic_string());
+    };
+    engine.grep(dir.path(), "a.*b", {"*.cpp"}, searchOptions);
+    CHECK((matches == std::set<std::string>{"src/util.cpp", "src/lib/deep.cpp"}));
+}
+
+void testFindPatterns() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    FileEngine engine;
+    
+    FindOptions options;
+    options.useIndex = false;
+    CHECK((findPaths(engine, dir.path(), {"*.cpp"}, options) ==
+           std::set<std::string>{"src/main.cpp", "src/util.cpp", "src/lib/deep.cpp"}));
+    CHECK((findPaths(engine, dir.path(), {"*.md", "readme.*"}, options) == std::set<std::string>{"docs/guide.md", "readme.txt"}));
+    CHECK(findPaths(engine, dir.path(), {"*.none"}, options).empty());
+    
+    options.limit = 2;
+    CHECK(findPaths(engine, dir.path(), {"*.cpp"}, options).size() == 2);
+}
+
+void testCopyMoveRemove() {
+    TempDir dir;
+    fs::path source = dir / "source";
+    makeSampleTree(source);
+    writeFile(source / "big.bin", patternData(3 * 1024 * 1024 + 17, 7));
+    FileEngine engine;
+    
+    TreeCopySummary copied = engine.copy(source, dir / "copy");
+    CHECK(copied.errors == 0);
+    CHECK(copied.files == 6);
+    CHECK(sameTree(source, dir / "copy"));
+    
+    MoveSummary moved = engine.move(dir / "copy", dir / "moved");
+    CHECK(moved.errors == 0);
+    CHECK(!fs::exists(dir / "copy"));
+    CHECK(sameTree(source, dir / "moved"));
+    
+    RemoveSummary removed = engine.remove(dir / "moved");
+    CHECK(removed.errors == 0);
+    CHECK(!fs::exists(dir / "moved"));
+    
+    MakeDirectorySummary made = engine.makeDirectory(dir / "a" / "b");
+    CHECK(made.created);
+    CHECK(fs::is_directory(dir / "a" / "b"));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"list", testList},
+        {"list.cached-symlink-loop", testCachedSymlinkLoop},
+        {"find.patterns", testFindPatterns},
+        {"copy.move.remove", testCopyMoveRemove},
+    });
+}
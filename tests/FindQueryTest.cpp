@@ -0,0 +1,54 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+#include <mutex>
+
+namespace {
+
+std::set<std::string> queryPaths(FileEngine& engine, const fs::path& root, const std::vector<std::string>& tokens) {
+    FindQuery query(tokens);
+    std::mutex mutex;
+    std::set<std::string> paths;
+    engine.find(root, query, FindOptions(), [&](std::string_view directory, std::string_view name, unsigned) {
+        std::lock_guard<std::mutex> lock(mutex);
+        paths.insert(fs::relative(fs::path(std::string(directory)) / std::string(name), root).generic_string());
+        return true;
+    });
+    return paths;
+}
+
+void testDepth() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    FileEngine engine;
+    
+    CHECK(queryPaths(engine, dir.path(), {"-maxdepth", "0"}).empty());
+    CHECK((queryPaths(engine, dir.path(), {"-maxdepth", "1", "-type", "d"}) == std::set<std::string>{"docs", "empty", "src"}));
+    CHECK((queryPaths(engine, dir.path(), {"-mindepth", "2", "-maxdepth", "2", "-name", "*.cpp"}) ==
+           std::set<std::string>{"src/main.cpp", "src/util.cpp"}));
+    CHECK((queryPaths(engine, dir.path(), {"-mindepth", "3"}) == std::set<std::string>{"src/lib/deep.cpp"}));
+}
+
+void testPredicates() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    FileEngine engine;
+    
+    CHECK((queryPaths(engine, dir.path(), {"-type", "f", "-size", "+10c", "-not", "-name", "*.cpp"}) ==
+           std::set<std::string>{"readme.txt"}));
+    CHECK((queryPaths(engine, dir.path(), {"-name", "*.md", "-o", "-name", "main.*"}) ==
+           std::set<std::string>{"docs/guide.md", "src/main.cpp"}));
+    CHECK((queryPaths(engine, dir.path(), {"(", "-name", "*.md", "-o", "-name", "*.txt", ")", "-type", "f"}) ==
+           std::set<std::string>{"docs/guide.md", "readme.txt"}));
+    CHECK((queryPaths(engine, dir.path(), {"-type", "f", "-mmin", "-60", "-prune", "lib", "-name", "*.cpp"}) ==
+           std::set<std::string>{"src/main.cpp", "src/util.cpp"}));
+    CHECK(queryPaths(engine, dir.path(), {"-type", "f", "-mtime", "+1"}).empty());
+}
+
+}
+
+int main() {
+    return runTests({
+        {"find.depth", testDepth},
+        {"find.predicates", testPredicates},
+    });
+}
@@ -0,0 +1,47 @@
+#include "TestSupport.h"
+#include "GlobMatcher.h"
+
+namespace {
+
+void testShapes() {
+    GlobMatcher cpp("*.cpp");
+    CHECK(cpp.matches("main.cpp"));
+    CHECK(cpp.matches(".cpp"));
+    CHECK(!cpp.matches("main.cpp.bak"));
+    CHECK(!cpp.matches("main.c"));
+    
+    GlobMatcher all("*");
+    CHECK(all.matches("anything"));
+}
+
+void testMultiplePatterns() {
+    GlobMatcher several(std::vector<std::string>{"Makefile", "test_*", "*.h", "?x?", "*mid*"});
+    CHECK(several.matches("Makefile"));
+    CHECK(!several.matches("makefile"));
+    CHECK(several.matches("test_glob"));
+    CHECK(several.matches("a.h"));
+    CHECK(!several.matches("a.o"));
+    CHECK(several.matches("axb"));
+    CHECK(!several.matches("axbb"));
+    CHECK(several.matches("amidb"));
+    CHECK(!several.matches("other"));
+}
+
+void testGeneralPatterns() {
+    GlobMatcher general(std::vector<std::string>{"a*b*c", "?*z?"});
+    CHECK(general.matches("abc"));
+    CHECK(general.matches("a123b456c"));
+    CHECK(!general.matches("acb"));
+    CHECK(general.matches("xyzw"));
+    CHECK(!general.matches("zw"));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"glob.shapes", testShapes},
+        {"glob.multiple", testMultiplePatterns},
+        {"glob.general", testGeneralPatterns},
+    });
+}
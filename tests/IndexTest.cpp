@@ -0,0 +1,60 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+#include <cstdlib>
+
+namespace {
+
+std::set<std::string> indexedFind(FileEngine& engine, const fs::path& root, FindSummary& summary) {
+    std::set<std::string> paths;
+    summary = engine.find(root, {"*.cpp"}, FindOptions(), [&](std::string_view directory, std::string_view name, unsigned) {
+        paths.insert(fs::relative(fs::path(std::string(directory)) / std::string(name), root).generic_string());
+        return true;
+    });
+    return paths;
+}
+
+void testFallback() {
+#ifndef OS_WINDOWS
+    TempDir cache;
+    ::setenv("XDG_CACHE_HOME", cache.path().c_str(), 1);
+    
+    TempDir dir;
+    makeSampleTree(dir.path());
+    fs::path root = fs::canonical(dir.path());
+    const std::set<std::string> expected{"src/main.cpp", "src/util.cpp", "src/lib/deep.cpp"};
+    
+    {
+        FileEngine engine;
+        IndexSummary built = engine.buildIndex(root);
+        CHECK(built.errors == 0);
+        CHECK(fs::exists(built.location));
+        
+        FindSummary summary;
+        CHECK(indexedFind(engine, root, summary) == expected);
+        CHECK(summary.indexed);
+    }
+    
+    fs::path location = FileIndex::defaultLocation(root);
+    for (std::uintmax_t size : {std::uintmax_t(40), fs::file_size(location) / 2}) {
+        std::string original = readFile(location);
+        fs::resize_file(location, size);
+        
+        FileEngine engine;
+        FindSummary summary;
+        CHECK(indexedFind(engine, root, summary) == expected);
+        CHECK(!summary.indexed);
+        CHECK(summary.errors == 0);
+        writeFile(location, original);
+    }
+    
+    ::unsetenv("XDG_CACHE_HOME");
+#endif
+}
+
+}
+
+int main() {
+    return runTests({
+        {"index.fallback", testFallback},
+    });
+}
@@ -0,0 +1,70 @@
+#include "TestSupport.h"
+#include "TreeMover.h"
+#include <fstream>
+
+namespace {
+
+void makeSource(const fs::path& root) {
+    writeFile(root / "a.txt", "alpha");
+    writeFile(root / "sub" / "b.bin", patternData(100000, 1));
+    fs::create_directories(root / "hollow");
+}
+
+void testFreshDestination() {
+    TempDir dir;
+    fs::create_directories(dir / "empty");
+    
+    for (const char* name : {"absent", "empty"}) {
+        makeSource(dir / "source");
+        TreeMover mover;
+        MoveSummary summary = mover.move(dir / "source", dir / name);
+        CHECK(summary.errors == 0);
+        CHECK(summary.files == 2);
+        CHECK(!fs::exists(dir / "source"));
+        CHECK((relativeFiles(dir / name) == std::set<std::string>{"a.txt", "hollow/", "sub/", "sub/b.bin"}));
+        CHECK(readFile(dir / name / "sub" / "b.bin") == patternData(100000, 1));
+    }
+}
+
+void testNonEmptyDestination() {
+    TempDir dir;
+    makeSource(dir / "source");
+    writeFile(dir / "dest" / "a.txt", "precious");
+    
+    TreeMover mover;
+    MoveSummary summary = mover.move(dir / "source", dir / "dest");
+    CHECK(summary.errors == 1);
+    CHECK(summary.firstError == std::errc::directory_not_empty);
+    CHECK(summary.files == 0);
+    CHECK(readFile(dir / "dest" / "a.txt") == "precious");
+    CHECK((relativeFiles(dir / "dest") == std::set<std::string>{"a.txt"}));
+    CHECK(readFile(dir / "source" / "a.txt") == "alpha");
+}
+
+void testResume() {
+    TempDir dir;
+    makeSource(dir / "source");
+    fs::create_directories(dir / "dest" / "sub");
+    fs::copy_file(dir / "source" / "a.txt", dir / "dest" / "a.txt");
+    fs::last_write_time(dir / "dest" / "a.txt", fs::last_write_time(dir / "source" / "a.txt"));
+    std::ofstream(dir / "dest" / ".sfm-move") << fs::absolute(dir / "source").lexically_normal().string();
+    
+    TreeMover mover;
+    MoveSummary summary = mover.move(dir / "source", dir / "dest");
+    CHECK(summary.errors == 0);
+    CHECK(summary.files == 2);
+    CHECK(summary.resumed == 1);
+    CHECK(!fs::exists(dir / "source"));
+    CHECK(!fs::exists(dir / "dest" / ".sfm-move"));
+    CHECK(readFile(dir / "dest" / "sub" / "b.bin") == patternData(100000, 1));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"mv.fresh", testFreshDestination},
+        {"mv.non-empty", testNonEmptyDestination},
+        {"mv.resume", testResume},
+    });
+}
@@ -0,0 +1,54 @@
+#include "TestSupport.h"
+#include "OutputSink.h"
+
+namespace {
+
+std::string render(OutputFormat format, const std::function<void(OutputSink&)>& body) {
+    std::string output;
+    {
+        OutputSink sink(format, [&](const char* data, std::size_t size) { output.append(data, size); }, 16);
+        body(sink);
+    }
+    return output;
+}
+
+void testFormats() {
+    OutputFormat format;
+    CHECK(OutputSink::parseFormat("json", format) && format == OutputFormat::JsonLines);
+    CHECK(OutputSink::parseFormat("nul", format) && format == OutputFormat::NulSeparated);
+    CHECK(!OutputSink::parseFormat("xml", format));
+    
+    CHECK(render(OutputFormat::Text, [](OutputSink& sink) { sink.path("a/b"); }) == "a/b\n");
+    CHECK(render(OutputFormat::NulSeparated, [](OutputSink& sink) {
+        sink.path("a");
+        sink.path("b");
+    }) == std::string("a\0b\0", 4));
+}
+
+void testJsonEscaping() {
+    std::string output = render(OutputFormat::JsonLines, [](OutputSink& sink) {
+        sink.path(std::string("q\"\\\n\x01") + "\xff" + "\xd0\xb4");
+    });
+    CHECK(output == "{\"path\":\"q\\\"\\\\\\n\\u0001\\u00ff\xd0\xb4\"}\n");
+    
+    std::string truncated = render(OutputFormat::JsonLines, [](OutputSink& sink) { sink.path("x\xd0"); });
+    CHECK(truncated == "{\"path\":\"x\\u00d0\"}\n");
+}
+
+void testNulGroups() {
+    std::string output = render(OutputFormat::NulSeparated, [](OutputSink& sink) {
+        sink.group(1, 10, {"a", "b"});
+        sink.group(2, 20, {"c", "d"});
+    });
+    CHECK(output == std::string("a\0b\0c\0d\0", 8));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"output.formats", testFormats},
+        {"output.json", testJsonEscaping},
+        {"output.nul-groups", testNulGroups},
+    });
+}
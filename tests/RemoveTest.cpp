@@ -0,0 +1,57 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+
+namespace {
+
+void testWideTree() {
+    TempDir dir;
+    for (int i = 0; i < 50; ++i) {
+        for (int j = 0; j < 20; ++j) writeFile(dir / "tree" / ("d" + std::to_string(i)) / ("f" + std::to_string(j)), "x");
+    }
+    
+    FileEngine engine;
+    RemoveSummary summary = engine.remove(dir / "tree");
+    CHECK(summary.errors == 0);
+    CHECK(summary.removed == 1051);
+    CHECK(!fs::exists(dir / "tree"));
+}
+
+void testDeepTree() {
+    TempDir dir;
+    fs::path deep = dir / "tree";
+    for (int i = 0; i < 300; ++i) deep /= "d";
+    writeFile(deep / "leaf", "x");
+    for (int i = 0; i < 300; ++i) writeFile(dir / "tree" / ("w" + std::to_string(i)) / "s" / "f", "y");
+    
+    FileEngine engine;
+    RemoveOptions options;
+    options.threads = 4;
+    RemoveSummary summary = engine.remove(dir / "tree", options);
+    CHECK(summary.errors == 0);
+    CHECK(!fs::exists(dir / "tree"));
+}
+
+void testSymlinkNotFollowed() {
+#ifdef OS_LINUX
+    TempDir dir;
+    writeFile(dir / "outside" / "keep", "keep");
+    writeFile(dir / "tree" / "f", "x");
+    fs::create_directory_symlink(dir / "outside", dir / "tree" / "link");
+    
+    FileEngine engine;
+    RemoveSummary summary = engine.remove(dir / "tree");
+    CHECK(summary.errors == 0);
+    CHECK(!fs::exists(dir / "tree"));
+    CHECK(readFile(dir / "outside" / "keep") == "keep");
+#endif
+}
+
+}
+
+int main() {
+    return runTests({
+        {"rm.wide", testWideTree},
+        {"rm.deep", testDeepTree},
+        {"rm.symlink", testSymlinkNotFollowed},
+    });
+}
@@ -0,0 +1,82 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+#include <chrono>
+#include <mutex>
+
+namespace {
+
+bool lineMatches(const std::string& pattern, const std::string& line) {
+    LinePattern compiled(pattern);
+    return compiled.matchesLine(line.data(), line.data() + line.size());
+}
+
+void testLinePattern() {
+    CHECK(lineMatches("needle", "a needle here"));
+    CHECK(!lineMatches("needle", "a needl here"));
+    CHECK(lineMatches("^start", "start of line"));
+    CHECK(!lineMatches("^start", " start"));
+    CHECK(lineMatches("end$", "the end"));
+    CHECK(!lineMatches("end$", "the end "));
+    CHECK(lineMatches("a.c", "xabcx"));
+    CHECK(lineMatches("ab*c", "ac"));
+    CHECK(lineMatches("ab*c", "abbbc"));
+    CHECK(lineMatches("^a.*z$", "abcz"));
+    CHECK(!lineMatches("^a.*z$", "abczy"));
+    CHECK(lineMatches("", "anything"));
+    CHECK(LinePattern("plain").isLiteral());
+    CHECK(!LinePattern("pl.in").isLiteral());
+}
+
+void testBacktracking() {
+    std::string pattern;
+    for (int i = 0; i < 20; ++i) pattern += "a*";
+    pattern += "b";
+    std::string line(20000, 'a');
+    
+    auto start = std::chrono::steady_clock::now();
+    CHECK(!lineMatches(pattern, line));
+    CHECK(lineMatches(pattern, line + "b"));
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+}
+
+void testFindLiteral() {
+    std::string text = "one two three two";
+    const char* found = LinePattern::findLiteral(text.data(), text.data() + text.size(), "two");
+    CHECK(found == text.data() + 4);
+    CHECK(LinePattern::findLiteral(text.data(), text.data() + text.size(), "four") == nullptr);
+}
+
+void testGrep() {
+    TempDir dir;
+    makeSampleTree(dir.path());
+    writeFile(dir / "binary.cpp", std::string("a\0b\n", 4));
+    FileEngine engine;
+    
+    std::mutex mutex;
+    std::set<std::string> matches;
+    SearchOptions options;
+    options.onMatch = [&](const std::string& path, std::uint64_t line, std::string_view text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        matches.insert(fs::relative(path, dir.path()).generic_string() + ":" + std::to_string(line) + ":" + std::string(text));
+    };
+    
+    SearchSummary summary = engine.grep(dir.path(), "a.*b", {"*.cpp"}, options);
+    CHECK(summary.errors == 0);
+    CHECK(summary.binarySkipped == 1);
+    CHECK((matches == std::set<std::string>{"src/util.cpp:1:// aXXb", "src/lib/deep.cpp:1:abb"}));
+    
+    matches.clear();
+    engine.grep(dir.path(), "^world$", {}, options);
+    CHECK((matches == std::set<std::string>{"readme.txt:2:world"}));
+}
+
+}
+
+int main() {
+    return runTests({
+        {"line-pattern", testLinePattern},
+        {"line-pattern.backtracking", testBacktracking},
+        {"line-pattern.literal", testFindLiteral},
+        {"grep", testGrep},
+    });
+}
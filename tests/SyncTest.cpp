@@ -0,0 +1,114 @@
+#include "TestSupport.h"
+#include "FileEngine.h"
+#include <fstream>
+
+#ifdef OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+void testInitialAndRepeat() {
+    TempDir dir;
+    writeFile(dir / "source" / "a.txt", "alpha");
+    writeFile(dir / "source" / "sub" / "b.bin", patternData(200000, 5));
+    fs::create_directories(dir / "source" / "hollow");
+    FileEngine engine;
+    
+    SyncSummary first = engine.sync(dir / "source", dir / "dest");
+    CHECK(first.errors == 0);
+    CHECK(first.files == 2);
+    CHECK(first.copied == 2);
+    CHECK(sameTree(dir / "source", dir / "dest"));
+    
+    SyncSummary second = engine.sync(dir / "source", dir / "dest");
+    CHECK(second.errors == 0);
+    CHECK(second.unchanged == 2);
+    CHECK(second.copied == 0);
+    CHECK(second.bytesWritten == 0);
+}
+
+void testDeltaPatch() {
+    TempDir dir;
+    std::string data = patternData(1024 * 1024, 9);
+    writeFile(dir / "source" / "big.bin", data);
+    FileEngine engine;
+    
+    SyncOptions options;
+    options.blockSize = 4096;
+    options.deltaThreshold = 64 * 1024;
+    options.segmentSize = 128 * 1024;
+    CHECK(engine.sync(dir / "source", dir / "dest", options).errors == 0);
+    
+    data[5000] ^= 0x55;
+    data[700000] ^= 0x55;
+    writeFile(dir / "source" / "big.bin", data);
+    
+    SyncSummary summary = engine.sync(dir / "source", dir / "dest", options);
+    CHECK(summary.errors == 0);
+    CHECK(summary.patched == 1);
+    CHECK(summary.blocksRewritten == 2);
+    CHECK(summary.bytesWritten == 2 * 4096);
+    CHECK(readFile(dir / "dest" / "big.bin") == data);
+    
+    data.resize(data.size() - 10000);
+    writeFile(dir / "source" / "big.bin", data);
+    CHECK(engine.sync(dir / "source", dir / "dest", options).errors == 0);
+    CHECK(readFile(dir / "dest" / "big.bin") == data);
+}
+
+void testDeleteExtraneous() {
+    TempDir dir;
+    writeFile(dir / "source" / "keep", "keep");
+    writeFile(dir / "dest" / "keep", "old");
+    writeFile(dir / "dest" / "extra", "extra");
+    writeFile(dir / "dest" / "gone" / "nested", "nested");
+    FileEngine engine;
+    
+    SyncSummary kept = engine.sync(dir / "source", dir / "dest");
+    CHECK(kept.errors == 0);
+    CHECK(kept.deleted == 0);
+    CHECK(fs::exists(dir / "dest" / "extra"));
+    
+    SyncOptions options;
+    options.deleteExtraneous = true;
+    SyncSummary summary = engine.sync(dir / "source", dir / "dest", options);
+    CHECK(summary.errors == 0);
+    CHECK(summary.deleted == 3);
+    CHECK(sameTree(dir / "source", dir / "dest"));
+}
+
+void testFailedRemoval() {
+#ifdef OS_LINUX
+    if (::geteuid() == 0) return;
+    
+    TempDir dir;
+    writeFile(dir / "source" / "x", "file now");
+    writeFile(dir / "dest" / "x" / "inner", "was a directory");
+    writeFile(dir / "dest" / "extra" / "inner", "extraneous");
+    fs::permissions(dir / "dest" / "x", fs::perms::owner_read | fs::perms::owner_exec);
+    fs::permissions(dir / "dest" / "extra", fs::perms::owner_read | fs::perms::owner_exec);
+    FileEngine engine;
+    
+    SyncOptions options;
+    options.deleteExtraneous = true;
+    SyncSummary summary = engine.sync(dir / "source", dir / "dest", options);
+    CHECK(summary.errors == 2);
+    CHECK(summary.deleted == 0);
+    CHECK(summary.copied == 0);
+    
+    fs::permissions(dir / "dest" / "x", fs::perms::owner_all);
+    fs::permissions(dir / "dest" / "extra", fs::perms::owner_all);
+#endif
+}
+
+}
+
+int main() {
+    return runTests({
+        {"sync.repeat", testInitialAndRepeat},
+        {"sync.delta", testDeltaPatch},
+        {"sync.delete", testDeleteExtraneous},
+        {"sync.failed-removal", testFailedRemoval},
+    });
+}
@@ -0,0 +1,112 @@
+#include "TestSupport.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+namespace {
+
+std::atomic<int> failures(0);
+
+}
+
+TempDir::TempDir() {
+    static std::atomic<unsigned> sequence(0);
+    static const unsigned salt = std::random_device()();
+    auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    root = fs::temp_directory_path() / ("sfm-test-" + std::to_string(salt) + "-" + std::to_string(stamp) + "-" + std::to_string(sequence++));
+    fs::create_directories(root);
+}
+
+TempDir::~TempDir() {
+    std::error_code error;
+    fs::remove_all(root, error);
+}
+
+const fs::path& TempDir::path() const {
+    return root;
+}
+
+fs::path TempDir::operator/(const std::string& name) const {
+    return root / name;
+}
+
+void checkCondition(bool condition, const char* expression, const char* file, int line) {
+    if (condition) return;
+    failures.fetch_add(1);
+    std::cerr << file << ":" << line << ": проверка не выполнена: " << expression << std::endl;
+}
+
+void writeFile(const fs::path& path, const std::string& data) {
+    fs::create_directories(path.parent_path());
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out) throw std::runtime_error("не удалось записать " + path.string());
+}
+
+std::string readFile(const fs::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) throw std::runtime_error("не удалось прочитать " + path.string());
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::string patternData(std::size_t size, unsigned seed) {
+    std::string data(size, '\0');
+    std::uint32_t state = seed * 2654435761u + 1;
+    for (auto& c : data) {
+        state = state * 1664525u + 1013904223u;
+        c = static_cast<char>(state >> 24);
+    }
+    return data;
+}
+
+void makeSampleTree(const fs::path& root) {
+    writeFile(root / "readme.txt", "hello\nworld\n");
+    writeFile(root / "src" / "main.cpp", "int main() { return 0; }\n");
+    writeFile(root / "src" / "util.cpp", "// aXXb\nint helper();\n");
+    writeFile(root / "src" / "lib" / "deep.cpp", "abb\n");
+    writeFile(root / "docs" / "guide.md", "guide\n");
+    fs::create_directories(root / "empty");
+}
+
+std::set<std::string> relativeFiles(const fs::path& root) {
+    std::set<std::string> files;
+    for (auto it = fs::recursive_directory_iterator(root); it != fs::recursive_directory_iterator(); ++it) {
+        std::string name = fs::relative(it->path(), root).generic_string();
+        if (it->is_symlink()) {
+            files.insert(name + " -> " + fs::read_symlink(it->path()).generic_string());
+        } else if (it->is_directory()) {
+            files.insert(name + "/");
+        } else {
+            files.insert(name);
+        }
+    }
+    return files;
+}
+
+bool sameTree(const fs::path& left, const fs::path& right) {
+    if (relativeFiles(left) != relativeFiles(right)) return false;
+    for (auto it = fs::recursive_directory_iterator(left); it != fs::recursive_directory_iterator(); ++it) {
+        if (it->is_symlink() || !it->is_regular_file()) continue;
+        if (readFile(it->path()) != readFile(right / fs::relative(it->path(), left))) return false;
+    }
+    return true;
+}
+
+int runTests(const std::vector<TestCase>& cases) {
+    for (const auto& test : cases) {
+        int before = failures.load();
+        try {
+            test.body();
+        } catch (const std::exception& e) {
+            failures.fetch_add(1);
+            std::cerr << test.name << ": исключение: " << e.what() << std::endl;
+        }
+        std::cout << (failures.load() == before ? "ok      " : "ОШИБКА  ") << test.name << std::endl;
+    }
+    return failures.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,43 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+#include <set>
+
+namespace fs = std::filesystem;
+
+struct TestCase {
+    const char* name;
+    std::function<void()> body;
+};
+
+class TempDir {
+private:
+    fs::path root;
+    
+public:
+    TempDir();
+    ~TempDir();
+    
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+    
+    const fs::path& path() const;
+    fs::path operator/(const std::string& name) const;
+};
+
+void checkCondition(bool condition, const char* expression, const char* file, int line);
+void writeFile(const fs::path& path, const std::string& data);
+std::string readFile(const fs::path& path);
+std::string patternData(std::size_t size, unsigned seed);
+void makeSampleTree(const fs::path& root);
+std::set<std::string> relativeFiles(const fs::path& root);
+bool sameTree(const fs::path& left, const fs::path& right);
+int runTests(const std::vector<TestCase>& cases);
+
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+#endif